@@ -11,6 +11,7 @@
 
 #include "C_MainWindow.h"
 #include "ui_mainwindow.h"
+#include "network/C_FileCache.h"
 
 /*****************************************************************************
   Macro Definitions
@@ -38,8 +39,12 @@
 
 /*****************************************************************************
  * Конструктор
+ *
+ * @param
+ *  [in] a_options - параметры воспроизведения для сервера и клиента
+ *  [in] parent    - родительский виджет
  */
-C_MainWindow::C_MainWindow( QWidget *parent ) :
+C_MainWindow::C_MainWindow( const T_Options &a_options, QWidget *parent ) :
     QMainWindow(parent),
     ui( new Ui::MainWindow )
 {
@@ -62,6 +67,24 @@ C_MainWindow::C_MainWindow( QWidget *parent ) :
                              "127.7.7.7:7777 127.0.0.1:8888 mode=nonblocking",
                              E_Protocol::TCP );
 
+    // Применение параметров воспроизведения, заданных в командной строке
+    m_server->setSocketBackend( a_options.Backend );
+    m_server->setSpeed( a_options.Speed );
+    m_server->setZeroCopy( a_options.ZeroCopy );
+    m_server->setBulkMode( a_options.Bulk );
+    m_server->setStartTime( a_options.StartTime );
+    m_server->setStreams( a_options.Streams );
+    m_server->setStreamProto( a_options.StreamProto );
+    m_server->setWindowSize( a_options.FileWindow );
+    m_server->setPrewarm( a_options.Prewarm );
+
+    m_client->setSocketBackend( a_options.Backend );
+    m_client->setWindow( a_options.Window );
+
+    if ( a_options.CacheBudget != 0 ) {
+        C_FileCache::instance().setBudget( a_options.CacheBudget );
+    }
+
     /*
      * Создание потока, в котором будет выполняться сервер
      * Привязка сигнала от кнопки интерфейса к слоту главного цикла обработчика сервера
@@ -11,6 +11,10 @@
 #include <QMainWindow>
 #include <QThread>
 
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
 #include "network/C_Server.h"
 #include "network/C_Client.h"
 #include "C_Logger.h"
@@ -31,6 +35,24 @@ class MainWindow;
   Types and Classes Definitions
 *****************************************************************************/
 
+/*****************************************************************************
+ * Параметры воспроизведения, заданные в командной строке (см. main.cpp)
+ */
+struct T_Options
+{
+    network::E_SocketBackend     Backend     = network::E_SocketBackend::Native;   // Реализация сокетов
+    double                       Speed       = 1.0;                                // Скорость воспроизведения
+    bool                         ZeroCopy    = false;                              // Отправка без копирования
+    bool                         Bulk        = false;                              // Потоковая передача
+    std::chrono::milliseconds    StartTime   { 0 };                                // Смещение начала воспроизведения
+    std::vector<unsigned char>   Streams;                                          // Воспроизводимые потоки (пусто - все)
+    network::E_StreamProto       StreamProto = network::E_StreamProto::Unknown;    // Протокол потоков (Unknown - все)
+    std::size_t                  FileWindow  = 0;                                  // Окно файла в памяти в байтах
+    bool                         Prewarm     = false;                              // Загрузка файла при запуске сервера
+    std::uint32_t                Window      = 0;                                  // Окно кредитов клиента в пакетах
+    std::size_t                  CacheBudget = 0;                                  // Бюджет кэша файлов (0 - по умолчанию)
+};
+
 /*****************************************************************************
  * Класс главного окна приложения
  *
@@ -44,7 +66,7 @@ class C_MainWindow : public QMainWindow
 
 public:
 
-    explicit C_MainWindow( QWidget *parent = nullptr );
+    explicit C_MainWindow( const T_Options &a_options = T_Options(), QWidget *parent = nullptr );
     ~C_MainWindow();
 
 private slots:
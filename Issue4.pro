@@ -15,11 +15,14 @@ CONFIG += c++14
 SOURCES += main.cpp\
     network/C_Client.cpp \
     network/C_Server.cpp \
-    network/C_Socket.cpp \
     network/C_SocketFactory.cpp \
     network/C_StreamAnalyzer.cpp \
-    network/C_TcpSocket.cpp \
-    network/C_UdpSocket.cpp \
+    network/C_IndexFile.cpp \
+    network/C_FileCache.cpp \
+    network/C_FileChecker.cpp \
+    network/C_PacketIndex.cpp \
+    network/C_ParallelIndexer.cpp \
+    network/C_StreamCodec.cpp \
     network/utils.cpp \
     C_MainWindow.cpp \
     C_Logger.cpp
@@ -27,20 +30,63 @@ SOURCES += main.cpp\
 HEADERS  += \
     network/C_Client.h \
     network/C_Server.h \
-    network/C_Socket.h \
     network/C_SocketFactory.h \
     network/C_StreamAnalyzer.h \
-    network/C_TcpSocket.h \
-    network/C_UdpSocket.h \
+    network/C_IndexFile.h \
+    network/C_FileCache.h \
+    network/C_FileChecker.h \
+    network/C_PacketIndex.h \
+    network/C_ParallelIndexer.h \
+    network/C_StreamCodec.h \
     network/common_types.h \
     network/I_Socket.h \
+    network/record_views.h \
     network/utils.h \
     C_Logger.h \
     C_MainWindow.h
 
 FORMS    += mainwindow.ui
 
+win32 {
+    SOURCES += \
+        network/C_Socket.cpp \
+        network/C_TcpSocket.cpp \
+        network/C_UdpSocket.cpp
 
-LIBS += -lws2_32
+    HEADERS += \
+        network/C_Socket.h \
+        network/C_TcpSocket.h \
+        network/C_UdpSocket.h
+
+    LIBS += -lws2_32
+}
+
+unix {
+    SOURCES += \
+        network/C_PosixSocket.cpp \
+        network/C_PosixTcpSocket.cpp \
+        network/C_PosixUdpSocket.cpp \
+        network/C_Reactor.cpp \
+        network/C_MappedStreamAnalyzer.cpp
+
+    HEADERS += \
+        network/C_PosixSocket.h \
+        network/C_PosixTcpSocket.h \
+        network/C_PosixUdpSocket.h \
+        network/C_Reactor.h \
+        network/C_MappedStreamAnalyzer.h
+}
+
+linux {
+    SOURCES += \
+        network/C_Uring.cpp \
+        network/C_UringTcpSocket.cpp \
+        network/C_WindowedStreamAnalyzer.cpp
+
+    HEADERS += \
+        network/C_Uring.h \
+        network/C_UringTcpSocket.h \
+        network/C_WindowedStreamAnalyzer.h
+}
 
 QMAKE_CXXFLAGS += -O3
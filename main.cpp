@@ -2,13 +2,43 @@
 
   MAIN FUNCTION
 
-  Запуск графического окна приложения
+  Запуск графического окна приложения либо проверка файла *.mes без запуска
+  окна:
+
+    Issue4 --check data.mes [--truncate]
+
+  При ключе --truncate поврежденный файл обрезается по первому поврежденному
+  пакету (см. C_FileChecker.h)
+
+  Параметры воспроизведения задаются ключами командной строки при запуске
+  окна (см. C_Server.h, C_Client.h):
+
+    Issue4 [--backend native|posix|uring] [--speed X] [--zero-copy] [--bulk]
+           [--start-ms N] [--streams 1,2,...] [--stream-proto rs|ethernet]
+           [--file-window BYTES] [--prewarm] [--window PACKETS]
+           [--cache-budget BYTES]
+
+  Например, воспроизведение в 2 раза быстрее реального времени с окном
+  кредитов клиента в 64 пакета:
+
+    Issue4 --speed 2 --window 64
 
 *****************************************************************************/
 
 #include <QApplication>
 
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
 #include "C_MainWindow.h"
+#include "network/C_FileChecker.h"
+#ifdef __linux__
+#include "network/C_MappedStreamAnalyzer.h"
+#endif
 
 /*****************************************************************************
   Macro Definitions
@@ -26,6 +56,13 @@
   Functions Prototypes
 *****************************************************************************/
 
+// Проверка целостности файла *.mes
+int checkFile( const std::string &a_filePath, bool a_truncate );
+// Разбор параметров воспроизведения
+bool parseOptions( int a_argc, char *a_argv[], T_Options &a_options );
+// Разбор беззнакового целого числа
+bool parseNumber( const char *a_text, unsigned long long &a_value );
+
 /*****************************************************************************
   Variables Definitions
 *****************************************************************************/
@@ -39,9 +76,251 @@
  */
 int main(int argc, char *argv[])
 {
+    if ( argc >= 3 && std::strcmp( argv[1], "--check" ) == 0 ) {
+        return checkFile( argv[2], argc >= 4 && std::strcmp( argv[3], "--truncate" ) == 0 );
+    }
+
+    T_Options options;
+    if ( !parseOptions( argc, argv, options ) ) {
+        std::cerr << "usage: " << argv[0] << " [--backend native|posix|uring] [--speed X] [--zero-copy] [--bulk]\n"
+                  << "    [--start-ms N] [--streams 1,2,...] [--stream-proto rs|ethernet] [--file-window BYTES]\n"
+                  << "    [--prewarm] [--window PACKETS] [--cache-budget BYTES]\n"
+                  << "   or: " << argv[0] << " --check data.mes [--truncate]" << std::endl;
+        return 1;
+    }
+
     QApplication a(argc, argv);
-    C_MainWindow w;
+    C_MainWindow w( options );
     w.show();
 
     return a.exec();
 }
+
+/*****************************************************************************
+ * Проверка целостности файла *.mes
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу
+ *  [in] a_truncate - обрезать поврежденный файл по первому поврежденному пакету
+ *
+ * @return
+ *  0 - файл исправен (или обрезан)
+ *  1 - файл поврежден
+ *  2 - файл не удалось открыть
+ */
+int checkFile( const std::string &a_filePath, bool a_truncate )
+{
+    using namespace network;
+
+    C_FileChecker::T_Result result;
+    {
+        std::unique_ptr<C_StreamAnalyzer> provider;
+        std::ifstream file;
+        std::vector<char> data;
+#ifdef __linux__
+        provider = std::make_unique<C_MappedStreamAnalyzer>( a_filePath );
+        if ( provider->size() == 0 ) {
+            provider.reset();
+        }
+#endif
+        if ( !provider ) {
+            file.open( a_filePath, std::ios::binary | std::ios::in );
+            if ( !file.is_open() ) {
+                std::cerr << a_filePath << ": cannot open file" << std::endl;
+                return 2;
+            }
+            provider = std::make_unique<C_StreamAnalyzer>( file, data );
+        }
+
+        C_FileChecker checker( *provider );
+        bool valid = checker.check();
+        result = checker.result();
+        std::cout << a_filePath << ": " << result.ValidPackets << " valid packets, RecordsInFile "
+                  << result.RecordsInFile << std::endl;
+        if ( valid ) {
+            std::cout << a_filePath << ": OK" << std::endl;
+            return 0;
+        }
+        std::cout << a_filePath << ": " << C_FileChecker::errorText( result.Error )
+                  << " at offset " << result.Offset << " (packet #" << result.ValidPackets << ")" << std::endl;
+    }
+
+    if ( result.Error == C_FileChecker::E_Error::ShortHeader ) {
+        return 1;
+    }
+    if ( !a_truncate ) {
+        std::cout << "run with --truncate to cut the file at offset " << result.Offset << std::endl;
+        return 1;
+    }
+    if ( !C_FileChecker::truncate( a_filePath, result ) ) {
+        std::cerr << a_filePath << ": cannot truncate file" << std::endl;
+        return 1;
+    }
+    std::cout << a_filePath << ": truncated to " << result.Offset << " bytes, "
+              << result.ValidPackets << " packets" << std::endl;
+    return 0;
+}
+
+/*****************************************************************************
+ * Разбор параметров воспроизведения
+ *
+ * Аргументы, не начинающиеся с "--", пропускаются (параметры Qt)
+ *
+ * @param
+ *  [in]  a_argc    - количество аргументов
+ *  [in]  a_argv    - аргументы командной строки
+ *  [out] a_options - параметры воспроизведения
+ *
+ * @return
+ *  true  - параметры разобраны
+ *  false - неизвестный ключ или недопустимое значение
+ */
+bool parseOptions( int a_argc, char *a_argv[], T_Options &a_options )
+{
+    using namespace network;
+
+    for ( int i = 1; i < a_argc; ++i ) {
+        const char *key = a_argv[i];
+        if ( std::strncmp( key, "--", 2 ) != 0 ) {
+            continue;
+        }
+
+        if ( std::strcmp( key, "--zero-copy" ) == 0 ) {
+            a_options.ZeroCopy = true;
+            continue;
+        }
+        if ( std::strcmp( key, "--bulk" ) == 0 ) {
+            a_options.Bulk = true;
+            continue;
+        }
+        if ( std::strcmp( key, "--prewarm" ) == 0 ) {
+            a_options.Prewarm = true;
+            continue;
+        }
+
+        // Остальные ключи имеют значение
+        static const char *const s_valueKeys[] = { "--backend", "--speed", "--start-ms", "--streams",
+                                                   "--stream-proto", "--file-window", "--window",
+                                                   "--cache-budget" };
+        bool known = false;
+        for ( const char *valueKey : s_valueKeys ) {
+            known = known || std::strcmp( key, valueKey ) == 0;
+        }
+        if ( !known ) {
+            std::cerr << key << ": unknown option" << std::endl;
+            return false;
+        }
+        if ( i + 1 >= a_argc ) {
+            std::cerr << key << ": value expected" << std::endl;
+            return false;
+        }
+        const char *value = a_argv[++i];
+        unsigned long long number = 0;
+
+        if ( std::strcmp( key, "--backend" ) == 0 ) {
+            if ( std::strcmp( value, "native" ) == 0 ) {
+                a_options.Backend = E_SocketBackend::Native;
+            }
+            else if ( std::strcmp( value, "posix" ) == 0 ) {
+                a_options.Backend = E_SocketBackend::Posix;
+            }
+            else if ( std::strcmp( value, "uring" ) == 0 ) {
+                a_options.Backend = E_SocketBackend::Uring;
+            }
+            else {
+                std::cerr << key << ": unknown backend " << value << std::endl;
+                return false;
+            }
+        }
+        else if ( std::strcmp( key, "--speed" ) == 0 ) {
+            char *end = nullptr;
+            a_options.Speed = std::strtod( value, &end );
+            if ( end == value || *end != '\0' || !( a_options.Speed > 0.0 ) ) {
+                std::cerr << key << ": positive number expected" << std::endl;
+                return false;
+            }
+        }
+        else if ( std::strcmp( key, "--start-ms" ) == 0 ) {
+            if ( !parseNumber( value, number ) ) {
+                std::cerr << key << ": number expected" << std::endl;
+                return false;
+            }
+            a_options.StartTime = std::chrono::milliseconds( number );
+        }
+        else if ( std::strcmp( key, "--streams" ) == 0 ) {
+            // Список номеров потоков через запятую
+            a_options.Streams.clear();
+            std::string list( value );
+            size_t begin = 0;
+            while ( begin <= list.size() ) {
+                size_t end = list.find( ',', begin );
+                if ( end == std::string::npos ) {
+                    end = list.size();
+                }
+                std::string item = list.substr( begin, end - begin );
+                if ( !parseNumber( item.c_str(), number ) || number > 0xFF ) {
+                    std::cerr << key << ": stream numbers 0..255 expected" << std::endl;
+                    return false;
+                }
+                a_options.Streams.push_back( static_cast<unsigned char>( number ) );
+                begin = end + 1;
+            }
+        }
+        else if ( std::strcmp( key, "--stream-proto" ) == 0 ) {
+            if ( std::strcmp( value, "rs" ) == 0 ) {
+                a_options.StreamProto = E_StreamProto::RS;
+            }
+            else if ( std::strcmp( value, "ethernet" ) == 0 ) {
+                a_options.StreamProto = E_StreamProto::Ethernet;
+            }
+            else {
+                std::cerr << key << ": rs or ethernet expected" << std::endl;
+                return false;
+            }
+        }
+        else if ( std::strcmp( key, "--file-window" ) == 0 ) {
+            if ( !parseNumber( value, number ) ) {
+                std::cerr << key << ": number expected" << std::endl;
+                return false;
+            }
+            a_options.FileWindow = static_cast<size_t>( number );
+        }
+        else if ( std::strcmp( key, "--window" ) == 0 ) {
+            if ( !parseNumber( value, number ) || number > 0xFFFFFFFFull ) {
+                std::cerr << key << ": number of packets expected" << std::endl;
+                return false;
+            }
+            a_options.Window = static_cast<std::uint32_t>( number );
+        }
+        else if ( std::strcmp( key, "--cache-budget" ) == 0 ) {
+            if ( !parseNumber( value, number ) || number == 0 ) {
+                std::cerr << key << ": positive number expected" << std::endl;
+                return false;
+            }
+            a_options.CacheBudget = static_cast<size_t>( number );
+        }
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Разбор беззнакового целого числа
+ *
+ * @param
+ *  [in]  a_text  - строка с числом
+ *  [out] a_value - число
+ *
+ * @return
+ *  true  - строка целиком содержит десятичное число
+ *  false - строка пуста или содержит посторонние символы
+ */
+bool parseNumber( const char *a_text, unsigned long long &a_value )
+{
+    if ( *a_text < '0' || *a_text > '9' ) {
+        return false;
+    }
+    char *end = nullptr;
+    errno = 0;
+    a_value = std::strtoull( a_text, &end, 10 );
+    return *end == '\0' && errno == 0;
+}
@@ -20,6 +20,10 @@
     логикой работы склиента. Завершение работы производится в состоянии
     States::Finish
 
+  * Функция step() выполняет один шаг машины состояний и возвращает событие, которого
+    необходимо дождаться перед следующим шагом. В ОС Linux ожидание выполняет реактор на
+    основе epoll (C_Reactor.h), в остальных системах - пауза между итерациями цикла.
+
   * После каждого запроса клиент ждет ответа от сервера со следующей посылкой данных.
 
   * Завершение работы клиента происходит после получения пакета FileSent от сервера,
@@ -33,6 +37,9 @@
 #include <cstring>
 
 #include "C_SocketFactory.h"
+#ifdef __linux__
+#include "C_Reactor.h"
+#endif
 
 namespace network {
 
@@ -57,8 +64,11 @@ namespace network {
 *****************************************************************************/
 
 const size_t        C_Client::s_bufSize      = 8 * 1024;    // Размер буфера приема/отправки
+const size_t        C_Client::s_batchSize    = 32;          // Количество буферов пакетного приема
 
 const unsigned char C_Client::s_approveCount = 3;           // Количество подтверждений от сервера для установления соединения
+const char * const  C_Client::s_recvFilePath = "received.mes"; // Файл для сохранения принятых данных
+const std::chrono::milliseconds C_Client::s_regrantTimeout { 500 }; // Время без пакетов до повторной выдачи окна
 
 /*****************************************************************************
   Functions Definitions
@@ -87,109 +97,320 @@ C_Client::C_Client( std::string a_logLabel,
 void C_Client::stop()
 {
     isRunning = false;
+#ifdef __linux__
+    // Пробуждение реактора для завершения работы клиента в его потоке. Реактор не
+    // может быть уничтожен, пока захвачен мьютекс: detach() ожидает его освобождения
+    std::lock_guard<std::mutex> lock( m_reactorMutex );
+    C_Reactor *reactor = m_reactor;
+    if ( reactor ) {
+        reactor->post( [this](){ resume(); } );
+    }
+#endif
 }
 
 /*****************************************************************************
  * Главный цикл-обработчик клиента
+ *
+ * В ОС Linux клиент обслуживается собственным реактором событий, в остальных
+ * системах - циклом с ожиданием между неуспешными шагами машины состояний
  */
 void C_Client::work()
 {
-    using namespace std::chrono_literals;
+#ifdef __linux__
+    C_Reactor reactor;
+    attach( reactor );
+    reactor.run();
+    // Реактор уничтожается при выходе из функции, stop() не должен к нему обращаться
+    detach();
+#else
+    reset();
+    while ( m_state != E_States::Closed ) {
+        if ( !isRunning ) {
+            close();
+            break;
+        }
+        T_Wait wait = step();
+        if ( wait.What != E_Readiness::None ) {
+            sleep( wait.Timeout );
+        }
+    }
+#endif
+}
 
-    E_States state     = E_States::Setup;   // Текущее состояние стейт-машины
-    E_States prevState = E_States::Setup;   // Предыдущее состояние стейт-машины
+/*****************************************************************************
+ * Начальное состояние машины состояний клиента
+ */
+void C_Client::reset()
+{
+    m_state         = E_States::Setup;
+    m_conState      = E_ConnectionStates::EchoReqt;
+    m_recvCounter   = 0;
+    m_echoCounter   = 0;
+    m_frameIdx      = 0;
+    m_frameCount    = 0;
+    m_bulkRemaining = 0;
+    m_credit        = 0;
+    m_codec.reset();
+    isRunning       = true;                           // Установить флаг работы для вхождения в цикл событий
+}
+
+/*****************************************************************************
+ * Шаг машины состояний клиента
+ *
+ * @return
+ *  - событие, которое необходимо дождаться перед следующим шагом
+ *    (E_Readiness::None - следующий шаг можно выполнять сразу)
+ */
+T_Wait C_Client::step()
+{
+    using namespace std::chrono_literals;
 
-    std::chrono::milliseconds sleepTime = 1000ms;   // Время ожидания между двумя неуспешными операциями, мсек
-    unsigned long long recvCounter = 0;             // Счетчик пакетов
+    T_Wait wait;
 
-    isRunning = true;                               // Установить флаг работы для вхождения в цикл событий
+    switch ( m_state ) {
 
-    while (isRunning) {
-        prevState = state;
-        switch ( state ) {
+        case E_States::Setup:
+            if ( setup() ) {
+                m_state = E_States::Connect;
+            }
+            else {
+                g_log << m_name + "socket setup error: " << errno << std::endl;
+                wait = { E_Readiness::Timer, 1000ms };
+            }
+            break;
 
-            case E_States::Setup:
-                sleepTime = 1000ms;
-                if ( setup() ) {
-                    state = E_States::Connect;
-                }
-                else {
-                    g_log << m_name + "socket setup error: " << errno << std::endl;
-                }
-                break;
+        case E_States::Connect:
+            if ( connect() ) {
+                m_state = ( m_protoType == E_Protocol::UDP ) ? E_States::Handshake
+                                                             : E_States::SendPacket;
+            }
+            else {
+                // Ожидание завершения неблокирующего подключения либо повторная попытка
+                wait = { m_handle->wouldBlock() ? E_Readiness::Write : E_Readiness::Timer, 1000ms };
+            }
+            break;
 
-            case E_States::Connect:
-                sleepTime = 1000ms;
-                if ( connect() ) {
-                    state =  E_States::SendPacket;
-                }
-                break;
+        case E_States::Handshake:
+            if ( udpConStep( wait ) ) {
+                g_log << m_name << "connected to udp server" << std::endl;
+                m_state = E_States::SendPacket;
+            }
+            break;
 
-            case E_States::SendPacket:
-                sleepTime = 10ms;
-                if ( sendPacket( Comand::Data ) ) {
-                    state = E_States::RecvPacket;
-                }
-                break;
+        case E_States::SendPacket:
+            if ( sendPacket( Comand::Data ) ) {
+                m_state = ( m_fileFd >= 0 ) ? E_States::RecvFile : E_States::RecvPacket;
+            }
+            else {
+                wait = { m_handle->wouldBlock() ? E_Readiness::Write : E_Readiness::Timer, 10ms };
+            }
+            break;
 
-            case E_States::RecvPacket:
-                sleepTime = 10ms;
-                if ( recvPacket() ) {
-                    recvCounter++;
-                    state = E_States::ParseComand;
-                }
-                break;
+        case E_States::RecvPacket:
+            if ( recvPacket() ) {
+                m_recvCounter++;
+                m_lastActivity = std::chrono::steady_clock::now();
+                m_state = E_States::ParseComand;
+            }
+            else if ( m_codec.isBroken() ) {
+                g_log << m_name << "tcp stream framing is broken" << std::endl;
+                m_state = E_States::Finish;
+            }
+            else if ( m_window != 0 && m_protoType == E_Protocol::UDP && m_recvCounter > 0 &&
+                      m_handle->wouldBlock() &&
+                      std::chrono::steady_clock::now() - m_lastActivity >= s_regrantTimeout ) {
+                // Кредиты могли быть израсходованы на потерянные датаграммы, окно
+                // выдается заново (сервер не превышает окна, см. C_Server::takeCredit())
+                m_credit = 0;
+                m_state  = E_States::SendPacket;
+            }
+            else {
+                wait = { m_handle->wouldBlock() ? E_Readiness::Read : E_Readiness::Timer, 10ms };
+            }
+            break;
 
-            case E_States::ParseComand:
-                if ( parseComand() != Comand::Finish ) {
-                    state = ( recvCounter == 1 )
-                          ? E_States::WriteHeader
-                          : E_States::WritePacket;
-                    break;
-                }
-                else {
+        case E_States::ParseComand:
+            switch ( parseComand() ) {
+                case Comand::Finish:
                     g_log << "client: finish packet was received" << std::endl;
-                    state = E_States::Finish;
+                    m_state = E_States::Finish;
+                    break;
+                case Comand::Bulk:
+                    // Подтверждение сервер ожидает перед началом потока
+                    m_state = openBulk() ? E_States::SendPacket : E_States::Finish;
+                    break;
+                default:
+                    m_state = ( m_recvCounter == 1 )
+                            ? E_States::WriteHeader
+                            : E_States::WritePacket;
+                    break;
+            }
+            break;
+
+        case E_States::RecvFile:
+            if ( m_bulkRemaining == 0 ) {
+                closeFileDescriptor( m_fileFd );
+                g_log << m_name << "file stream is received" << std::endl;
+                m_state = E_States::RecvPacket;
+            }
+            else if ( !m_handle->recvFile( m_fileFd, m_bulkRemaining ) ) {
+                if ( m_handle->wouldBlock() ) {
+                    wait = { E_Readiness::Read, 10ms };
                     break;
                 }
+                g_log << m_name << "file stream is broken, "
+                      << m_bulkRemaining << " bytes are not received" << std::endl;
+                m_state = E_States::Finish;
+            }
+            break;
+
+        case E_States::WriteHeader:
+            g_log << m_name << "file open status: " << openFile(s_recvFilePath) << std::endl;
+            writeHeader();
+            m_state = E_States::SendPacket;
+            break;
+
+        case E_States::WritePacket:
+            writePacket();
+            if ( m_credit > 0 ) {
+                m_credit--;
+            }
+            // С окном кредитов запрос отправляется, когда израсходована половина окна
+            m_state = ( m_window == 0 || m_credit <= m_window / 2 ) ? E_States::SendPacket
+                                                                    : E_States::RecvPacket;
+            break;
+
+        case E_States::Finish:
+            g_log << m_name + m_handle->name() << " stopped" << std::endl;
+            close();
+            break;
+
+        case E_States::Closed:
+            break;
+    }
+    return wait;
+}
 
-            case E_States::WriteHeader:
-                g_log << m_name << "file open status: " << openFile("received.mes") << std::endl;
-                writeHeader();
-                state = E_States::SendPacket;
-                break;
-
-            case E_States::WritePacket:
-                writePacket();
-                state = E_States::SendPacket;
-                break;
-
-            case E_States::Finish:
-                g_log << m_name + m_handle->name() << " stopped" << std::endl;
-                close();
-                return;
+#ifdef __linux__
+
+/*****************************************************************************
+ * Подключение клиента к реактору событий
+ *
+ * Первый шаг машины состояний будет выполнен в потоке реактора
+ *
+ * @param
+ *  [in] a_reactor - реактор, который будет обслуживать клиента
+ */
+void C_Client::attach( C_Reactor &a_reactor )
+{
+    reset();
+    m_reactor = &a_reactor;
+    a_reactor.post( [this](){ resume(); } );
+}
+
+/*****************************************************************************
+ * Продолжение работы машины состояний по событию реактора
+ *
+ * Шаги выполняются до тех пор, пока машине состояний не потребуется дождаться
+ * готовности сокета или таймера
+ */
+void C_Client::resume()
+{
+    C_Reactor *reactor = m_reactor;
+    if ( !reactor ) {
+        return;
+    }
+    if ( m_timerId ) {
+        reactor->cancelTimer( m_timerId );
+        m_timerId = 0;
+    }
+
+    while ( m_state != E_States::Closed ) {
+        if ( !isRunning ) {
+            close();
+            return;
         }
-        if ( state == prevState ) {
-            sleep( sleepTime );
+        T_Wait wait = step();
+        if ( wait.What != E_Readiness::None && m_state != E_States::Closed ) {
+            arm( wait );
+            return;
         }
     }
-    close();
-    return;
 }
 
+/*****************************************************************************
+ * Регистрация в реакторе ожидаемого машиной состояний события
+ *
+ * @param
+ *  [in] a_wait - ожидаемое событие
+ */
+void C_Client::arm( const T_Wait &a_wait )
+{
+    C_Reactor *reactor = m_reactor;
+    int fd = m_handle ? m_handle->handle() : -1;
+
+    if ( m_watchedFd >= 0 && m_watchedFd != fd ) {
+        reactor->unwatch( m_watchedFd );
+        m_watchedFd = -1;
+    }
+
+    if ( a_wait.What == E_Readiness::Read || a_wait.What == E_Readiness::Write ) {
+        if ( reactor->watch( fd, a_wait.What, [this](){ resume(); } ) ) {
+            m_watchedFd = fd;
+            return;
+        }
+    }
+    m_timerId = reactor->addTimer( a_wait.Timeout, [this](){ m_timerId = 0; resume(); } );
+}
+
+/*****************************************************************************
+ * Отключение клиента от реактора событий
+ */
+void C_Client::detach()
+{
+    C_Reactor *reactor = nullptr;
+    {
+        std::lock_guard<std::mutex> lock( m_reactorMutex );
+        reactor = m_reactor.exchange( nullptr );
+    }
+    if ( !reactor ) {
+        return;
+    }
+    if ( m_watchedFd >= 0 ) {
+        reactor->unwatch( m_watchedFd );
+        m_watchedFd = -1;
+    }
+    if ( m_timerId ) {
+        reactor->cancelTimer( m_timerId );
+        m_timerId = 0;
+    }
+}
+
+#endif
+
 /*****************************************************************************
  * Завершение работы клиента
  */
 void C_Client::close()
 {
+#ifdef __linux__
+    // Снятие сокета с наблюдения до его закрытия
+    detach();
+#endif
+    m_state = E_States::Closed;
+
     if ( m_file.is_open() ) {
         m_file.close();
     }
+    closeFileDescriptor( m_fileFd );
     // Закрытие сокета и его удаление
-    m_handle->close();
-    m_handle.reset();
+    if ( m_handle ) {
+        m_handle->close();
+        m_handle.reset();
+    }
     // Очистка входного буфера
     m_buffer.clear();
+    m_codec.reset();
     // Сброс счетчика входящих пакетов
     m_counter = 0;
     g_log << m_name << "deinitialized" << std::endl;
@@ -203,6 +424,9 @@ void C_Client::close()
  * Команда из enum E_Comands преобразуется в байт, записываемый в буфер отправки
  * сообщения после чего терминируется символом '\0'.
  *
+ * С окном кредитов запрос содержит кредиты (4 байта big-endian), пополняющие
+ * неизрасходованные сервером кредиты до размера окна
+ *
  * @param
  *  [in] a_comand - команда, отправляемая на сервер
  *
@@ -212,29 +436,80 @@ void C_Client::close()
  */
 bool C_Client::sendPacket( Comand a_comand )
 {
-    T_NetPacket packet;
-
-    if ( a_comand == Comand::Data ) {
-        packet.Head = Header::DataReqt;
-    } else {
+    if ( a_comand != Comand::Data ) {
         return false;
     }
 
-    return m_handle->send( serialize(packet) );
+    char   credit[ sizeof(std::uint32_t) ];
+    size_t creditSize = 0;
+    if ( m_window != 0 ) {
+        std::uint32_t value = m_window - m_credit;
+        for ( size_t idx = sizeof(credit); idx > 0; idx--, value >>= 8 ) {
+            credit[ idx - 1 ] = static_cast<char>( value & 0xFF );
+        }
+        creditSize = sizeof(credit);
+    }
+
+    // По TCP запрос предваряется длиной (см. C_StreamCodec.h)
+    T_Frame frame = ( m_protoType == E_Protocol::TCP ) ? C_StreamCodec::frame( Header::DataReqt, credit, creditSize )
+                                                       : makeFrame( Header::DataReqt, credit, creditSize );
+    if ( m_handle->sendFrames( &frame, 1 ) != 1 ) {
+        return false;
+    }
+    m_credit       = m_window;
+    m_lastActivity = std::chrono::steady_clock::now();
+    // Запрос передается ядру при следующем приеме (см. I_Socket::submit())
+    return true;
 }
 
 /*****************************************************************************
  * Прием данных с сервера
  *
+ * Датаграммы принимаются пакетно вызовом I_Socket::recvBatch() и выдаются
+ * в m_buffer по одной (длина датаграммы - m_recvSize); новый прием выполняется
+ * после обработки всех ранее принятых датаграмм. По TCP кадры так же выдаются
+ * по одному из буфера m_codec (см. C_StreamCodec.h)
+ *
  * @return
  *  true  - данные успешно приняты с сервера
  *  false - ошибка при приеме данных с сервера
  */
 bool C_Client::recvPacket()
 {
-    m_buffer.clear();
-    m_buffer.resize( s_bufSize );
-    return m_handle->recv( m_buffer );
+    if ( m_protoType == E_Protocol::TCP ) {
+        while ( !m_codec.next( m_packet ) ) {
+            if ( m_codec.isBroken() ) {
+                return false;
+            }
+            size_t capacity = 0;
+            char  *space    = m_codec.space( capacity );
+            if ( !m_handle->recvInto( space, capacity, m_recvSize ) ) {
+                return false;
+            }
+            m_codec.commit( m_recvSize );
+        }
+        return true;
+    }
+
+    if ( m_frameIdx == m_frameCount ) {
+        // Прием не изменяет размер буферов, поэтому буферы выделяются и
+        // заполняются нулями только один раз
+        m_frames.resize( s_batchSize );
+        for ( auto &frame : m_frames ) {
+            frame.resize( s_bufSize );
+        }
+        m_frameIdx   = 0;
+        m_frameCount = m_handle->recvBatch( m_frames, m_frameSizes );
+        if ( m_frameCount == 0 ) {
+            return false;
+        }
+    }
+    // Обмен буферами вместо копирования, освободившийся буфер будет переиспользован
+    m_recvSize = m_frameSizes[ m_frameIdx ];
+    m_buffer.swap( m_frames[ m_frameIdx++ ] );
+    // Пакет разбирается один раз, данные остаются в m_buffer
+    m_packet = deserializeView( m_buffer.data(), m_recvSize );
+    return true;
 }
 
 /*****************************************************************************
@@ -245,15 +520,18 @@ void C_Client::writeHeader()
     g_log << m_name << "received header with size: "
             << getHeaderSize() << std::endl;
 
-    T_NetPacket netPacket = deserialize(m_buffer);
-    print( toPacketHeaderPtr(  netPacket.Data.data() ) );
+    if ( m_packet.Size < T_FileHeaderView::size() ) {
+        g_log << m_name << "received header is too short" << std::endl;
+        return;
+    }
+    print( T_FileHeaderView( m_packet.Data ) );
 
     if ( !m_file.is_open() ) {
         g_log << m_name <<  "Error while opening file!\n";
         return;
     }
 
-    m_file.write( netPacket.Data.data(), getHeaderSize() );
+    m_file.write( m_packet.Data, getHeaderSize() );
     return;
 }
 
@@ -262,15 +540,17 @@ void C_Client::writeHeader()
  */
 void C_Client::writePacket()
 {
-    T_NetPacket netPacket = deserialize(m_buffer);
-
-    T_Packet *packetPtr  = toPacketPtr( netPacket.Data.data() );
-    unsigned int packetSize = getPacketSize( packetPtr );
+    T_PacketView packet( m_packet.Data );
+    if ( m_packet.Size < T_PacketView::headerSize() || m_packet.Size < packet.size() ) {
+        g_log << m_name << "received packet #" << m_counter++ << " is too short" << std::endl;
+        return;
+    }
+    unsigned int packetSize = getPacketSize( packet );
     g_log << m_name << "received packet #" << m_counter++ << " with size: "
             << packetSize << std::endl;
 
-    print( packetPtr );
-    m_file.write( netPacket.Data.data(), packetSize );
+    print( packet );
+    m_file.write( m_packet.Data, packetSize );
     return;
 }
 
@@ -285,7 +565,7 @@ void C_Client::writePacket()
 bool C_Client::setup()
 {
     if ( !m_handle ) {
-        m_handle = C_SocketFactory::createSocket( m_protoType );
+        m_handle = C_SocketFactory::createSocket( m_protoType, m_backend );
     }
     else {
         errno = enSockAlreadyCreated;
@@ -332,75 +612,69 @@ bool C_Client::connect()
 
     if ( m_handle->connect() ) {
         g_log << m_name << "establishing connection with server..." << std::endl;
-
-        if ( m_protoType == E_Protocol::UDP ) {
-            udpConHandler();
-            g_log << m_name << "connected to udp server" << std::endl;
-
-        }
         return true;
     }
 
-    g_log << m_name << "error with opening connection" << std::endl;
+    if ( !m_handle->wouldBlock() ) {
+        g_log << m_name << "error with opening connection" << std::endl;
+    }
     return false;
 }
 
 /*****************************************************************************
- * Проведение процедуры "handshake" с сервером по UDP протоколу
+ * Шаг процедуры "handshake" с сервером по UDP протоколу
+ *
+ * @param
+ *  [out] a_wait - событие, которое необходимо дождаться, если шаг не продвинул процедуру
  *
- * Функция синхронная, не передаст управление, пока не будет завершена процедура
+ * @return
+ *  true  - соединение с сервером установлено
+ *  false - процедура не завершена
  */
-void C_Client::udpConHandler()
+bool C_Client::udpConStep( T_Wait &a_wait )
 {
     using namespace std::chrono_literals;
-    bool isConnected = false;                                       // Статус флаг цикла
-    E_ConnectionStates state = E_ConnectionStates::EchoReqt;        // Текущее состояние стейт-машины
-    E_ConnectionStates prevState = E_ConnectionStates::EchoReqt;    // Предыдущее состояние стейт-машины
     std::chrono::milliseconds timeout = 100ms;                      // Время ожидания между запросами подтверждения, мсек
-    unsigned recvCounter = 0;
-
-    while( !isConnected ) {
-        prevState = state;
-        switch (state) {
-            // Отправка эхо-запроса
-            case E_ConnectionStates::EchoReqt: {
-                // Формирование пакета эхо-запроса
-                T_NetPacket packet;
-                packet.Head = Header::EchoReqt;
-                packet.Data = { s_approveCount };
-                if ( m_handle->send( serialize(packet) ) ) {
-                    state = E_ConnectionStates::WaitResp;
-                }
-            } break;
-            // Ожидание эхо-ответа
-            case E_ConnectionStates::WaitResp: {
-                m_buffer.clear();
-                m_buffer.resize(s_bufSize);
-                if ( m_handle->recv( m_buffer ) ) {
-                    // Десериализация пакета из массива принятых байтов
-                    T_NetPacket packet = deserialize(m_buffer);
-                    if( packet.Head == Header::EchoResp ) {
-                        recvCounter++;
-                    }
-                    state = E_ConnectionStates::VerifyStatus;
+
+    switch ( m_conState ) {
+        // Отправка эхо-запроса
+        case E_ConnectionStates::EchoReqt: {
+            // Формирование пакета эхо-запроса
+            T_NetPacket packet;
+            packet.Head = Header::EchoReqt;
+            packet.Data = { s_approveCount };
+            if ( m_handle->send( serialize(packet) ) ) {
+                m_conState = E_ConnectionStates::WaitResp;
+            }
+            else {
+                a_wait = { E_Readiness::Write, timeout };
+            }
+        } break;
+        // Ожидание эхо-ответа
+        case E_ConnectionStates::WaitResp: {
+            m_buffer.resize(s_bufSize);
+            if ( m_handle->recvInto( m_buffer.data(), m_buffer.size(), m_recvSize ) ) {
+                // Разбор пакета в массиве принятых байтов
+                T_NetPacketView packet = deserializeView( m_buffer.data(), m_recvSize );
+                if( packet.Head == Header::EchoResp ) {
+                    m_echoCounter++;
                 }
-            } break;
-            // Проверка условия установления соединения
-            case E_ConnectionStates::VerifyStatus:
-                    state = recvCounter < s_approveCount ? E_ConnectionStates::EchoReqt
-                                                         : E_ConnectionStates::Connected;
+                m_conState = E_ConnectionStates::VerifyStatus;
+            }
+            else {
+                a_wait = { E_Readiness::Read, timeout };
+            }
+        } break;
+        // Проверка условия установления соединения
+        case E_ConnectionStates::VerifyStatus:
+            m_conState = m_echoCounter < s_approveCount ? E_ConnectionStates::EchoReqt
+                                                        : E_ConnectionStates::Connected;
             break;
-            // Соединение установлено
-            case E_ConnectionStates::Connected:
-                isConnected = true;
-                break;
-        }
-
-        if ( state == prevState ) {
-           std::this_thread::sleep_for( timeout );
-        }
+        // Соединение установлено
+        case E_ConnectionStates::Connected:
+            return true;
     }
-    return;
+    return false;
 }
 
 /*****************************************************************************
@@ -439,6 +713,37 @@ bool C_Client::openFile( std::string a_filePath )
     return m_file.is_open();
 }
 
+/*****************************************************************************
+ * Подготовка к приему потока пакетов файла
+ *
+ * Из кадра Header::BulkResp извлекается длина потока, принятые ранее данные
+ * сбрасываются на диск и файл открывается на дозапись на уровне дескриптора,
+ * чтобы поток записывался в файл напрямую (см. I_Socket::recvFile())
+ *
+ * @return
+ *  true  - прием потока подготовлен
+ *  false - ошибка открытия файла
+ */
+bool C_Client::openBulk()
+{
+    // Длина потока передается в порядке байтов big-endian
+    std::uint64_t length = 0;
+    for ( size_t i = 0; i < sizeof(length) && i < m_packet.Size; i++ ) {
+        length = ( length << 8 ) | static_cast<unsigned char>( m_packet.Data[i] );
+    }
+
+    m_file.flush();
+    m_fileFd = openFileDescriptor( s_recvFilePath, E_FileMode::Writing );
+    if ( m_fileFd < 0 ) {
+        g_log << m_name << "file is not opened for bulk transfer" << std::endl;
+        return false;
+    }
+
+    m_bulkRemaining = static_cast<size_t>( length );
+    g_log << m_name << "receiving file stream of " << m_bulkRemaining << " bytes" << std::endl;
+    return true;
+}
+
 /*****************************************************************************
  * Разбор принятой от сервера байтовой последовательности
  *
@@ -450,11 +755,12 @@ bool C_Client::openFile( std::string a_filePath )
  */
 Comand C_Client::parseComand() const
 {
-    T_NetPacket recvPacket = deserialize(m_buffer);
-
-    if ( recvPacket.Head == Header::FileSent ) {
+    if ( m_packet.Head == Header::FileSent ) {
         return Comand::Finish;
     }
+    else if ( m_packet.Head == Header::BulkResp ) {
+        return Comand::Bulk;
+    }
     else {
         return Comand::Data;
     }
@@ -38,6 +38,29 @@
 
      cli.work();
 
+  3. По протоколу TCP кадры выделяются из потока по длине (см. C_StreamCodec.h):
+     все кадры, принятые одним вызовом recv(), обрабатываются по очереди.
+
+  4. Функция setWindow() включает управление потоком окном кредитов: вместо
+     запроса на каждый пакет клиент выдает серверу кредиты на a_packets пакетов
+     и пополняет их до размера окна, когда израсходована половина окна. Сервер
+     отправляет пакеты, не ожидая запросов, пока кредиты не израсходованы.
+     Прежний сервер без поддержки окна принимает такие запросы по UDP как
+     обычные (по TCP он не поддерживает разметку кадров):
+
+     cli.setWindow( 64 );
+
+  5. Если сервер работает в режиме потоковой передачи (см. C_Server::setBulkMode()),
+     клиент после кадра Header::BulkResp принимает пакеты файла одним потоком
+     вызовами I_Socket::recvFile() и записывает их в файл напрямую.
+
+  6. В ОС Linux клиент может обслуживаться общим с другими сессиями реактором
+     событий (см. C_Reactor.h):
+
+     C_Reactor reactor;
+     cli.attach( reactor );
+     reactor.run();
+
 *******************************************************************************/
 
 #pragma once
@@ -47,8 +70,10 @@
 #include <chrono>
 #include <fstream>
 #include <atomic>
+#include <mutex>
 
 #include "utils.h"
+#include "C_StreamCodec.h"
 #include "C_Logger.h"
 
 namespace network {
@@ -63,6 +88,8 @@ using namespace services;
   Forward Declarations
 *****************************************************************************/
 
+class C_Reactor;
+
 /*****************************************************************************
   Types and Classes Definitions
 *****************************************************************************/
@@ -86,6 +113,16 @@ public:
     // Остановить работу клиента
     void stop();
 
+    // Выбор реализации сокета (до вызова work())
+    void setSocketBackend( E_SocketBackend a_backend ) { m_backend = a_backend; }
+    // Окно кредитов в пакетах (0 - запрос на каждый пакет, до вызова work())
+    void setWindow( std::uint32_t a_packets ) { m_window = a_packets; }
+
+#ifdef __linux__
+    // Подключение клиента к реактору событий
+    void attach( C_Reactor &a_reactor );
+#endif
+
 public slots:
 
     // Главный цикл-обработчик клиента
@@ -98,6 +135,19 @@ signals:
 
 protected:
 
+    // Шаг машины состояний клиента
+    T_Wait step();
+    // Начальное состояние машины состояний клиента
+    void reset();
+#ifdef __linux__
+    // Продолжение работы машины состояний по событию реактора
+    void resume();
+    // Регистрация в реакторе ожидаемого машиной состояний события
+    void arm( const T_Wait &a_wait );
+    // Отключение клиента от реактора событий
+    void detach();
+#endif
+
     /**
      * Обработчики состояний
      */
@@ -118,10 +168,12 @@ protected:
 
     // Создание и открытие файла для сохранения входящих пакетов
     bool openFile( std::string a_filePath );
+    // Подготовка к приему потока пакетов файла
+    bool openBulk();
     // Разбор принятой от сервера байтовой последовательности
     Comand parseComand() const;
-    // Проведение процедуры "handshake" с сервером по UDP протоколу
-    void udpConHandler();
+    // Шаг процедуры "handshake" с сервером по UDP протоколу
+    bool udpConStep( T_Wait &a_wait );
 
 
 protected: // types
@@ -130,12 +182,15 @@ protected: // types
     enum class E_States {
         Setup,                                          // Настройка всех служб перед работой
         Connect,                                        // Подключение
+        Handshake,                                      // Установление сеанса по UDP протоколу
         SendPacket,                                     // Обработка запросов на сервер
         RecvPacket,                                     // Обработка ответов сервера
         ParseComand,                                    // Разбор принятого сообщения
         WriteHeader,                                    // Запись заголовка в файл
         WritePacket,                                    // Запись пакета в файл
-        Finish                                          // Завершение работы
+        RecvFile,                                       // Прием потока пакетов в файл
+        Finish,                                         // Завершение работы
+        Closed                                          // Работа завершена
     };
 
     // Промежуточные состояния установления соединения с сервером
@@ -163,17 +218,46 @@ protected:
 
     std::atomic<bool>           isRunning;              // Атомарный флаг работы главного цикла-обработчика событий клиента
     std::vector<char>           m_buffer;               // Буфер обмена для приема отправки
+    size_t                      m_recvSize = 0;         // Количество байтов, принятых в m_buffer
+    T_NetPacketView             m_packet;               // Последний принятый пакет (данные в m_buffer или m_codec)
+    C_StreamCodec               m_codec;                // Разметка кадров, принимаемых по TCP
     std::string                 m_name;                 // Лог-метка клиента
     std::string                 m_authority;            // Адреса и порты клиента и сервера в виде строки
     E_Protocol                  m_protoType;            // Протокол обмена
+    E_SocketBackend             m_backend = E_SocketBackend::Native;    // Реализация сокета
+    std::uint32_t               m_window  = 0;          // Окно кредитов в пакетах (0 - запрос на каждый пакет)
     std::shared_ptr<I_Socket>   m_handle;               // Файл дескриптор клиента
     std::ofstream               m_file;                 // Хендлер на файл с принятыми данными
     unsigned long long          m_counter = 0;          // Счетчик принятых пакетов
 
+    /**
+     * Состояние машины состояний, сохраняемое между шагами
+     */
+    E_States                    m_state       = E_States::Setup;                // Текущее состояние
+    E_ConnectionStates          m_conState    = E_ConnectionStates::EchoReqt;   // Состояние "handshake" по UDP
+    unsigned long long          m_recvCounter = 0;                              // Счетчик принятых ответов сервера
+    unsigned                    m_echoCounter = 0;                              // Счетчик принятых эхо-ответов
+    std::vector<std::vector<char>> m_frames;                                    // Буферы пакетного приема
+    size_t                      m_frameIdx    = 0;                              // Следующий необработанный буфер
+    size_t                      m_frameCount  = 0;                              // Количество принятых буферов
+    std::vector<size_t>         m_frameSizes;                                   // Количество байтов, принятых в каждый буфер
+    int                         m_fileFd      = -1;                             // Дескриптор файла для приема потока
+    size_t                      m_bulkRemaining = 0;                            // Непринятый остаток потока
+    std::uint32_t               m_credit      = 0;                              // Неизрасходованные сервером кредиты
+    std::chrono::steady_clock::time_point m_lastActivity;                       // Время последнего приема или выдачи кредитов
+
+    std::atomic<C_Reactor*>     m_reactor { nullptr };                          // Реактор, обслуживающий клиента
+    std::mutex                  m_reactorMutex;                                 // Защита m_reactor при обращении из stop()
+    int                         m_watchedFd   = -1;                             // Дескриптор, ожидаемый в реакторе
+    std::uint64_t               m_timerId     = 0;                              // Активный таймер в реакторе
+
 protected: // static
 
     static const size_t        s_bufSize;               // Максимальный размер буфера приема-передачи
+    static const size_t        s_batchSize;             // Количество буферов пакетного приема
     static const unsigned char s_approveCount;          // Количество подтверждений от сервера для установления соединения
+    static const char * const  s_recvFilePath;          // Файл для сохранения принятых данных
+    static const std::chrono::milliseconds s_regrantTimeout; // Время без пакетов до повторной выдачи окна (UDP)
 };
 
 /*****************************************************************************
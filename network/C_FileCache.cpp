@@ -0,0 +1,372 @@
+/*****************************************************************************
+
+  C_FileCache
+
+  Общий для всех сессий процесса кэш загруженных и размеченных файлов *.mes
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Файл загружается вне мьютекса кэша: запись о файле добавляется в кэш с
+    незавершенным std::shared_future, который остальные сессии ожидают без
+    блокировки кэша.
+
+  * Файл, прочитанный в буфер (без отображения в память), хранится вместе с
+    буфером в структуре T_Buffered. Сессиям выдается указатель на разметчик,
+    разделяющий владение всей структурой (конструктор std::shared_ptr с
+    псевдонимом), поэтому буфер удаляется вместе с последним пользователем.
+
+  * Файл, используемый сессией, определяется по числу владельцев разметчика:
+    кэш владеет одной ссылкой. Неиспользуемые файлы удаляются при следующем
+    запросе любого файла.
+
+  * При загрузке файла индекс только читается из файла индекса. Иначе файл
+    размечается по мере обращения сессий к пакетам, и первая сессия начинает
+    передачу, не дожидаясь разметки всего файла. Разметка общего разметчика
+    выполняется под его мьютексом (см. C_StreamAnalyzer.cpp), полный индекс
+    сохраняется сессией при закрытии (см. C_Server::close()).
+
+  * Если загрузка завершилась исключением, исключение передается сессиям,
+    ожидающим загрузки, а запись о файле удаляется из кэша.
+
+  * Фоновая загрузка выполняется одним потоком, принадлежащим кэшу: файлы
+    загружаются по очереди, поэтому предварительная загрузка нескольких
+    файлов не конкурирует за диск с загрузкой файлов сессиями. Поток не
+    удерживает загруженные файлы: они остаются в кэше, пока не будут удалены
+    при превышении бюджета. Поток завершается при уничтожении кэша (при
+    завершении процесса), дождавшись окончания загрузки текущего файла.
+
+*****************************************************************************/
+
+#include "C_FileCache.h"
+#include "C_IndexFile.h"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <vector>
+#ifdef __linux__
+#include "C_MappedStreamAnalyzer.h"
+#endif
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+namespace {
+
+// Файл, прочитанный в буфер, вместе с его разметчиком
+struct T_Buffered {
+    std::vector<char>                   Data;       // Данные файла
+    std::unique_ptr<C_StreamAnalyzer>   Provider;   // Разметчик данных Data
+};
+
+} // namespace
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const std::size_t C_FileCache::s_defaultBudget = 1024 * 1024 * 1024;    // 1 gigabyte
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Кэш процесса
+ *
+ * @return
+ *  - единственный объект кэша
+ */
+C_FileCache & C_FileCache::instance()
+{
+    static C_FileCache cache;
+    return cache;
+}
+
+/*****************************************************************************
+ * Деструктор
+ *
+ * Останавливает поток фоновой загрузки
+ */
+C_FileCache::~C_FileCache()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_prewarmMutex );
+        m_prewarmStop = true;
+        m_prewarmQueue.clear();
+    }
+    m_prewarmWakeup.notify_one();
+    if ( m_prewarmThread.joinable() ) {
+        m_prewarmThread.join();
+    }
+}
+
+/*****************************************************************************
+ * Получение размеченного файла
+ *
+ * Если файл отсутствует в кэше или изменился, он загружается. Исключение,
+ * возникшее при загрузке, получают все сессии, ожидающие ее окончания
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу с данными
+ *
+ * @return
+ *  - разметчик файла (если файл не удалось прочитать, размер данных разметчика
+ *    нулевой, и такой разметчик в кэше не сохраняется)
+ */
+C_FileCache::provider_t C_FileCache::acquire( const std::string &a_filePath )
+{
+    uint64_t size  = 0;
+    int64_t  mtime = 0;
+    if ( !C_IndexFile::fileStamp( a_filePath, size, mtime ) ) {
+        g_log << "file " << a_filePath << " is not accessible" << std::endl;
+        return load( a_filePath );
+    }
+
+    std::promise<provider_t> loading;
+    std::shared_future<provider_t> provider;
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto entry = std::find_if( m_entries.begin(), m_entries.end(),
+                                   [&a_filePath]( const T_Entry &a_entry ){ return a_entry.Path == a_filePath; } );
+        if ( entry != m_entries.end() && ( entry->Size != size || entry->MTime != mtime ) ) {
+            g_log << "file " << a_filePath << " changed, cached copy is dropped" << std::endl;
+            m_usage -= entry->Memory;
+            m_entries.erase( entry );
+            entry = m_entries.end();
+        }
+        if ( entry != m_entries.end() ) {
+            m_entries.splice( m_entries.begin(), m_entries, entry );
+            provider = entry->Provider;
+        }
+        else {
+            T_Entry added;
+            added.Path     = a_filePath;
+            added.Size     = size;
+            added.MTime    = mtime;
+            added.Provider = loading.get_future().share();
+            m_entries.push_front( added );
+        }
+    }
+
+    if ( provider.valid() ) {
+        g_log << "file " << a_filePath << " is taken from cache" << std::endl;
+        return provider.get();
+    }
+
+    auto isLoading = [&a_filePath, size, mtime]( const T_Entry &a_entry ) {
+        return a_entry.Path == a_filePath && a_entry.Size == size && a_entry.MTime == mtime && a_entry.Memory == 0;
+    };
+
+    provider_t loaded;
+    try {
+        loaded = load( a_filePath );
+    }
+    catch ( ... ) {
+        loading.set_exception( std::current_exception() );
+        std::lock_guard<std::mutex> lock( m_mutex );
+        auto entry = std::find_if( m_entries.begin(), m_entries.end(), isLoading );
+        if ( entry != m_entries.end() ) {
+            m_entries.erase( entry );
+        }
+        throw;
+    }
+    loading.set_value( loaded );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+    auto entry = std::find_if( m_entries.begin(), m_entries.end(), isLoading );
+    if ( entry != m_entries.end() ) {
+        if ( loaded->size() == 0 ) {
+            m_entries.erase( entry );
+        }
+        else {
+            entry->Memory = loaded->memoryUsage();
+            m_usage      += entry->Memory;
+        }
+    }
+    evict();
+    return loaded;
+}
+
+/*****************************************************************************
+ * Загрузка файла в фоновом потоке
+ *
+ * Функция не ожидает окончания загрузки. Файл, уже ожидающий загрузки, в
+ * очередь повторно не добавляется
+ *
+ * @param
+ *  [in] a_filePath   - путь к файлу с данными
+ *  [in] a_warmUpSize - объем начала файла, загружаемый в память (см.
+ *                      C_StreamAnalyzer::warmUp())
+ */
+void C_FileCache::prewarm( const std::string &a_filePath, std::size_t a_warmUpSize )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_prewarmMutex );
+        if ( m_prewarmStop ) {
+            return;
+        }
+        if ( std::none_of( m_prewarmQueue.begin(), m_prewarmQueue.end(),
+                           [&a_filePath]( const T_Prewarm &a_task ){ return a_task.Path == a_filePath; } ) ) {
+            T_Prewarm task;
+            task.Path       = a_filePath;
+            task.WarmUpSize = a_warmUpSize;
+            m_prewarmQueue.push_back( task );
+        }
+        if ( !m_prewarmThread.joinable() ) {
+            m_prewarmThread = std::thread( &C_FileCache::prewarmLoop, this );
+        }
+    }
+    m_prewarmWakeup.notify_one();
+}
+
+/*****************************************************************************
+ * Установка бюджета памяти
+ *
+ * @param
+ *  [in] a_budget - максимальный объем памяти, занимаемой файлами в кэше, в
+ *                  байтах (0 - не хранить файлы, не используемые сессиями)
+ */
+void C_FileCache::setBudget( std::size_t a_budget )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_budget = a_budget;
+    evict();
+}
+
+/*****************************************************************************
+ * Объем памяти, занимаемой файлами в кэше
+ *
+ * @return
+ *  - суммарный размер данных и индексов загруженных файлов в байтах
+ */
+std::size_t C_FileCache::usage()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_usage;
+}
+
+/*****************************************************************************
+ * Удаление из кэша всех файлов
+ *
+ * Файлы, используемые сессиями, остаются в памяти до завершения сессий
+ */
+void C_FileCache::clear()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_entries.remove_if( []( const T_Entry &a_entry ){ return a_entry.Memory != 0; } );
+    m_usage = 0;
+}
+
+/*****************************************************************************
+ * Загрузка и разметка файла
+ *
+ * В ОС Linux файл отображается в память (см. C_MappedStreamAnalyzer.h). Если
+ * отобразить файл не удалось, он читается в буфер. Индекс загружается из
+ * файла индекса, иначе пакеты размечаются по требованию сессий
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу с данными
+ *
+ * @return
+ *  - загруженный файл
+ */
+C_FileCache::provider_t C_FileCache::load( const std::string &a_filePath )
+{
+    provider_t provider;
+#ifdef __linux__
+    provider = std::make_shared<C_MappedStreamAnalyzer>( a_filePath );
+    if ( provider->size() == 0 ) {
+        provider.reset();
+    }
+#endif
+    if ( !provider ) {
+        auto buffered = std::make_shared<T_Buffered>();
+        std::ifstream file( a_filePath, std::ios::binary | std::ios::in );
+        g_log << "file open status: " << file.is_open() << std::endl;
+        buffered->Provider = std::make_unique<C_StreamAnalyzer>( file, buffered->Data );
+        provider = provider_t( buffered, buffered->Provider.get() );
+    }
+
+    if ( provider->loadIndex( C_IndexFile( a_filePath ) ) ) {
+        g_log << "index loaded from " << C_IndexFile::pathFor( a_filePath ) << std::endl;
+    }
+    else {
+        g_log << "file will be indexed on demand" << std::endl;
+    }
+    return provider;
+}
+
+/*****************************************************************************
+ * Цикл потока фоновой загрузки
+ *
+ * Файлы загружаются в порядке запросов до остановки потока в деструкторе
+ */
+void C_FileCache::prewarmLoop()
+{
+    std::unique_lock<std::mutex> lock( m_prewarmMutex );
+    for ( ;; ) {
+        m_prewarmWakeup.wait( lock, [this](){ return m_prewarmStop || !m_prewarmQueue.empty(); } );
+        if ( m_prewarmStop ) {
+            return;
+        }
+        T_Prewarm task = m_prewarmQueue.front();
+        m_prewarmQueue.pop_front();
+
+        lock.unlock();
+        try {
+            acquire( task.Path )->warmUp( task.WarmUpSize );
+        }
+        catch ( const std::exception &a_error ) {
+            g_log << "file " << task.Path << " is not prewarmed: " << a_error.what() << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+/*****************************************************************************
+ * Удаление неиспользуемых файлов при превышении бюджета
+ *
+ * Вызывается при захваченном мьютексе m_mutex. Индексы файлов дополняются
+ * сессиями, поэтому занимаемая файлами память предварительно пересчитывается.
+ * Файлы удаляются, начиная с давно не запрашивавшихся
+ */
+void C_FileCache::evict()
+{
+    m_usage = 0;
+    for ( T_Entry &entry : m_entries ) {
+        if ( entry.Memory != 0 ) {
+            entry.Memory = entry.Provider.get()->memoryUsage();
+            m_usage     += entry.Memory;
+        }
+    }
+
+    for ( auto entry = m_entries.end(); m_usage > m_budget && entry != m_entries.begin(); ) {
+        --entry;
+        // Загружаемые и используемые сессиями файлы не удаляются
+        if ( entry->Memory == 0 || entry->Provider.get().use_count() > 1 ) {
+            continue;
+        }
+        g_log << "file " << entry->Path << " is evicted from cache" << std::endl;
+        m_usage -= entry->Memory;
+        entry = m_entries.erase( entry );
+    }
+}
+
+} // namespace network
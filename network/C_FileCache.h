@@ -0,0 +1,169 @@
+/*****************************************************************************
+
+  C_FileCache
+
+  Общий для всех сессий процесса кэш загруженных и размеченных файлов *.mes
+
+
+  ОПИСАНИЕ
+
+  * Файл загружается (в ОС Linux - отображается в память) один раз, после
+    чего разметчик (C_StreamAnalyzer) разделяется всеми сессиями,
+    воспроизводящими этот файл. Файл размечается по мере обращения сессий к
+    пакетам, и каждый пакет размечается один раз. Повторное воспроизведение
+    файла, оставшегося в кэше, не требует ни загрузки, ни повторной разметки.
+
+  * Файл в кэше определяется путем, размером и временем последнего изменения:
+    если файл изменился, он загружается заново, а сессии, работающие с
+    прежней версией, продолжают использовать ее до завершения.
+
+  * Объем кэша (данные файлов и их индексы) ограничивается бюджетом памяти
+    (setBudget()). При превышении бюджета из кэша удаляются давно не
+    запрашивавшиеся файлы, которые не используются ни одной сессией.
+    Используемые файлы не удаляются, даже если бюджет превышен.
+
+  * Если файл одновременно запрашивается несколькими сессиями, загружает его
+    первая из них, остальные ожидают окончания загрузки. Загрузка разных
+    файлов выполняется параллельно.
+
+  * Файлы могут быть загружены заранее (prewarm()) фоновым потоком кэша:
+    запросивший загрузку не ожидает ее окончания, а сессия, запросившая файл
+    во время загрузки, ожидает ее в acquire().
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Получение разметчика файла:
+
+    std::shared_ptr<C_StreamAnalyzer> provider = C_FileCache::instance().acquire( a_filePath );
+
+  * Загрузка файла и первых 4 мегабайт его данных до запроса клиента:
+
+    C_FileCache::instance().prewarm( a_filePath, 4 * 1024 * 1024 );
+
+  * Ограничение объема кэша 4 гигабайтами:
+
+    C_FileCache::instance().setBudget( 4ull * 1024 * 1024 * 1024 );
+
+*****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "C_StreamAnalyzer.h"
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Кэш размеченных файлов
+ */
+class C_FileCache
+{
+
+public: // types
+
+    using provider_t = std::shared_ptr<C_StreamAnalyzer>;      // Тип разделяемого разметчика файла
+
+public:
+
+    C_FileCache( const C_FileCache&  ) = delete;
+    C_FileCache(       C_FileCache&& ) = delete;
+    C_FileCache & operator = ( const C_FileCache&  ) = delete;
+    C_FileCache & operator = (       C_FileCache&& ) = delete;
+
+    // Кэш процесса
+    static C_FileCache & instance();
+
+    // Получение размеченного файла a_filePath
+    provider_t acquire( const std::string &a_filePath );
+    // Загрузка файла a_filePath в фоновом потоке без ожидания ее окончания
+    void prewarm( const std::string &a_filePath, std::size_t a_warmUpSize );
+    // Установка бюджета памяти в байтах
+    void setBudget( std::size_t a_budget );
+    // Объем памяти, занимаемой файлами в кэше, в байтах
+    std::size_t usage();
+    // Удаление из кэша всех файлов
+    void clear();
+
+private: // types
+
+    // Файл в кэше
+    struct T_Entry {
+        std::string                     Path;           // Путь к файлу
+        uint64_t                        Size   = 0;     // Размер файла
+        int64_t                         MTime  = 0;     // Время изменения файла, нс
+        std::shared_future<provider_t>  Provider;       // Разметчик файла (после окончания загрузки)
+        std::size_t                     Memory = 0;     // Объем памяти, занимаемой файлом (0 - файл загружается)
+    };
+
+    // Запрос фоновой загрузки файла
+    struct T_Prewarm {
+        std::string                     Path;           // Путь к файлу
+        std::size_t                     WarmUpSize = 0; // Объем начала файла, загружаемый в память
+    };
+
+private:
+
+    C_FileCache() = default;
+    ~C_FileCache();
+
+    // Загрузка и разметка файла
+    static provider_t load( const std::string &a_filePath );
+    // Удаление неиспользуемых файлов при превышении бюджета
+    void evict();
+    // Цикл потока фоновой загрузки
+    void prewarmLoop();
+
+private:
+
+    std::mutex              m_mutex;                // Защита списка файлов
+    std::list<T_Entry>      m_entries;              // Файлы в порядке последнего обращения (первый - последний запрошенный)
+    std::size_t             m_budget = s_defaultBudget; // Бюджет памяти
+    std::size_t             m_usage  = 0;           // Объем памяти, занимаемой загруженными файлами
+
+    std::mutex              m_prewarmMutex;         // Защита очереди фоновой загрузки
+    std::condition_variable m_prewarmWakeup;        // Пробуждение потока фоновой загрузки
+    std::deque<T_Prewarm>   m_prewarmQueue;         // Файлы, ожидающие фоновой загрузки
+    bool                    m_prewarmStop = false;  // Завершение потока фоновой загрузки
+    std::thread             m_prewarmThread;        // Поток фоновой загрузки (запускается при первом запросе)
+
+private: // static
+
+    static const std::size_t s_defaultBudget;       // Бюджет памяти по умолчанию
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
@@ -0,0 +1,290 @@
+/*****************************************************************************
+
+  C_FileChecker
+
+  Проверка целостности файла с данными в формате *.mes
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Цепочка пакетов обходится только последовательно, поэтому векторизуется не
+    поиск границ пакетов, а проверка уже собранных заголовков: время и номер
+    потока пакетов пачки копируются в массивы, и каждые 4 пакета сравниваются
+    одной командой. Время сравнивается как беззнаковое число (у обоих операндов
+    инвертируется старший бит).
+
+  * Время растет только внутри потока (например, в test_data/data2.mes поток 1
+    начинается заново после окончания потока 0), поэтому при сборе пачки для
+    каждого пакета запоминается время предыдущего пакета того же потока (из
+    массива m_lastTimes на 256 потоков - номер потока занимает один байт), и
+    векторно сравниваются пары "предыдущее - текущее" время.
+
+  * Если количество потоков в заголовке равно 0, номер потока не проверяется
+    (номер потока занимает один байт, поэтому граница 256 не нарушается никогда).
+
+  * Если файл закончился ровно на границе пакета раньше, чем указано в заголовке,
+    или за последним указанным в заголовке пакетом есть данные, ошибкой считается
+    несовпадение количества пакетов: смещение ошибки - конец исправной цепочки.
+
+*****************************************************************************/
+
+#include "C_FileChecker.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const std::size_t C_FileChecker::s_batchSize = 256;    // 2 килобайта на массивы пачки
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ *
+ * @param
+ *  [in] a_provider - разметчик проверяемого файла
+ */
+C_FileChecker::C_FileChecker( C_StreamAnalyzer &a_provider )
+    : m_provider( a_provider )
+{
+}
+
+/*****************************************************************************
+ * Проверка файла
+ *
+ * @return
+ *  true  - файл исправен
+ *  false - найдена ошибка (см. result())
+ */
+bool C_FileChecker::check()
+{
+    m_result   = T_Result{};
+    m_checked  = 0;
+    m_lastTimes.fill( 0 );
+
+    T_FileHeaderView header = m_provider.fileHeader();
+    if ( !header ) {
+        return fail( E_Error::ShortHeader, 0, 0 );
+    }
+    m_result.RecordsInFile = header.recordsInFile();
+    m_streamQuan           = header.streamQuan();
+
+    // Разметка останавливается на первом пакете, выходящем за границы файла
+    bool indexed = m_provider.calcIndex();
+    const C_StreamAnalyzer::index_t &index = m_provider.index();
+
+    std::vector<uint64_t> offsets;
+    offsets.reserve( s_batchSize );
+    for ( std::size_t packNo = 0; packNo < index.size(); ) {
+        offsets.clear();
+        for ( ; packNo < index.size() && offsets.size() < s_batchSize; packNo++ ) {
+            offsets.push_back( index.offset( packNo ) );
+        }
+        if ( !checkPackets( offsets.data(), offsets.size() ) ) {
+            return false;
+        }
+    }
+
+    uint64_t chainEnd = index.empty() ? T_FileHeaderView::size() : index.endOffset();
+    if ( !indexed ) {
+        return fail( ( chainEnd == m_provider.size() ) ? E_Error::CountMismatch : E_Error::Overrun,
+                     m_checked, chainEnd );
+    }
+    if ( chainEnd != m_provider.size() ) {
+        return fail( E_Error::CountMismatch, m_checked, chainEnd );
+    }
+
+    m_result.Offset       = chainEnd;
+    m_result.ValidPackets = m_checked;
+    return true;
+}
+
+/*****************************************************************************
+ * Описание ошибки
+ *
+ * @param
+ *  [in] a_error - ошибка файла
+ *
+ * @return
+ *  - текстовое описание ошибки
+ */
+const char * C_FileChecker::errorText( E_Error a_error )
+{
+    switch ( a_error ) {
+        case E_Error::None:          return "no errors";
+        case E_Error::ShortHeader:   return "file is shorter than header";
+        case E_Error::Overrun:       return "packet overruns end of file";
+        case E_Error::TimeBackwards: return "packet time goes backwards";
+        case E_Error::BadStreamNum:  return "packet stream number is not below StreamQuan";
+        case E_Error::CountMismatch: return "RecordsInFile does not match packet chain";
+    }
+    return "unknown error";
+}
+
+/*****************************************************************************
+ * Обрезание файла по первому поврежденному пакету
+ *
+ * Файл обрезается до смещения a_result.Offset, в заголовок записывается
+ * количество оставшихся пакетов. Файл не должен быть открыт разметчиком
+ *
+ * @param
+ *  [in] a_filePath - путь к проверенному файлу
+ *  [in] a_result   - результат проверки файла
+ *
+ * @return
+ *  true  - файл обрезан
+ *  false - файл исправен, короче заголовка или не может быть изменен
+ */
+bool C_FileChecker::truncate( const std::string &a_filePath, const T_Result &a_result )
+{
+    if ( a_result.Error == E_Error::None || a_result.Error == E_Error::ShortHeader ) {
+        return false;
+    }
+    if ( !truncateFile( a_filePath, a_result.Offset ) ) {
+        g_log << a_filePath << " is not truncated" << std::endl;
+        return false;
+    }
+
+    std::fstream file( a_filePath, std::ios::binary | std::ios::in | std::ios::out );
+    std::vector<char> header( T_FileHeaderView::size() );
+    file.read( header.data(), static_cast<std::streamsize>( header.size() ) );
+    T_FileHeaderView::setRecordsInFile( header.data(), static_cast<uint32_t>( a_result.ValidPackets ) );
+    file.seekp( 0 );
+    file.write( header.data(), static_cast<std::streamsize>( header.size() ) );
+    if ( !file ) {
+        g_log << a_filePath << " header is not updated" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Проверка времени и номеров потоков пачки пакетов
+ *
+ * @param
+ *  [in] a_offsets - смещения пакетов (пакеты целиком находятся внутри файла)
+ *  [in] a_count   - количество пакетов (не больше s_batchSize)
+ *
+ * @return
+ *  true  - пакеты исправны
+ *  false - найдена ошибка
+ */
+bool C_FileChecker::checkPackets( const uint64_t *a_offsets, std::size_t a_count )
+{
+    uint32_t prevTimes[s_batchSize];
+    uint32_t times[s_batchSize];
+    uint32_t streams[s_batchSize];
+
+    // Время последнего пакета потока обновляется при сборе пачки: после
+    // найденной ошибки проверка не продолжается
+    for ( std::size_t i = 0; i < a_count; i++ ) {
+        T_PacketView packet( m_provider.data() + a_offsets[i] );
+        times[i]     = packet.time();
+        streams[i]   = packet.streamNum();
+        prevTimes[i] = m_lastTimes[ streams[i] & 0xFF ];
+        m_lastTimes[ streams[i] & 0xFF ] = times[i];
+    }
+
+    std::size_t invalid = findInvalid( prevTimes, times, streams, a_count, m_streamQuan );
+    if ( invalid < a_count ) {
+        E_Error error = ( m_streamQuan && streams[invalid] >= m_streamQuan ) ? E_Error::BadStreamNum
+                                                                            : E_Error::TimeBackwards;
+        return fail( error, m_checked + invalid, a_offsets[invalid] );
+    }
+    m_checked += a_count;
+    return true;
+}
+
+/*****************************************************************************
+ * Фиксация ошибки
+ *
+ * @param
+ *  [in] a_error  - найденная ошибка
+ *  [in] a_packNo - номер первого поврежденного пакета
+ *  [in] a_offset - смещение первого поврежденного пакета
+ *
+ * @return
+ *  false - для возврата из функции проверки
+ */
+bool C_FileChecker::fail( E_Error a_error, unsigned long a_packNo, uint64_t a_offset )
+{
+    m_result.Error        = a_error;
+    m_result.Offset       = a_offset;
+    m_result.ValidPackets = a_packNo;
+    return false;
+}
+
+/*****************************************************************************
+ * Поиск первого ошибочного пакета пачки
+ *
+ * @param
+ *  [in] a_prevTimes   - времена предыдущих пакетов тех же потоков
+ *  [in] a_times       - времена пакетов
+ *  [in] a_streams     - номера потоков пакетов
+ *  [in] a_count       - количество пакетов
+ *  [in] a_streamQuan  - количество потоков (0 - номер потока не проверяется)
+ *
+ * @return
+ *  - номер первого пакета с убывающим временем или неверным номером потока,
+ *    a_count - все пакеты исправны
+ */
+std::size_t C_FileChecker::findInvalid( const uint32_t *a_prevTimes, const uint32_t *a_times,
+                                        const uint32_t *a_streams, std::size_t a_count,
+                                        uint32_t a_streamQuan )
+{
+    uint32_t streamLimit = ( a_streamQuan == 0 ) ? 256 : std::min<uint32_t>( a_streamQuan, 256 );
+    std::size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i signBit = _mm_set1_epi32( static_cast<int>( 0x80000000u ) );
+    const __m128i limit   = _mm_set1_epi32( static_cast<int>( streamLimit ) );
+    for ( ; i + 4 <= a_count; i += 4 ) {
+        __m128i prev    = _mm_loadu_si128( reinterpret_cast<const __m128i*>( a_prevTimes + i ) );
+        __m128i cur     = _mm_loadu_si128( reinterpret_cast<const __m128i*>( a_times + i ) );
+        __m128i streams = _mm_loadu_si128( reinterpret_cast<const __m128i*>( a_streams + i ) );
+
+        __m128i backwards = _mm_cmplt_epi32( _mm_xor_si128( cur, signBit ), _mm_xor_si128( prev, signBit ) );
+        __m128i validNum  = _mm_cmplt_epi32( streams, limit );
+        if ( _mm_movemask_epi8( backwards ) != 0 || _mm_movemask_epi8( validNum ) != 0xffff ) {
+            break;
+        }
+    }
+#endif
+
+    for ( ; i < a_count; i++ ) {
+        if ( a_times[i] < a_prevTimes[i] || a_streams[i] >= streamLimit ) {
+            return i;
+        }
+    }
+    return a_count;
+}
+
+} // namespace network
@@ -0,0 +1,148 @@
+/*****************************************************************************
+
+  C_FileChecker
+
+  Проверка целостности файла с данными в формате *.mes
+
+
+  ОПИСАНИЕ
+
+  * Проверяется, что:
+    - ни один пакет не выходит за границы файла;
+    - время пакетов каждого потока не убывает (время отсчитывается в каждом
+      потоке отдельно, поэтому между пакетами разных потоков может убывать);
+    - номер потока пакета меньше количества потоков в заголовке (StreamQuan);
+    - количество пакетов в заголовке (RecordsInFile) совпадает с количеством
+      пакетов в цепочке, и за последним пакетом нет лишних данных.
+
+  * Границы пакетов рассчитываются через C_StreamAnalyzer (большие файлы
+    размечаются в несколько потоков, см. C_ParallelIndexer.h). Заголовки
+    размеченных пакетов собираются пачками по s_batchSize пакетов, и пачка
+    проверяется целиком: на x86 - командами SSE2 по 4 пакета за раз. Номер
+    первого ошибочного пакета ищется только в пачке, где найдена ошибка.
+
+  * Результат проверки - первая найденная ошибка и смещение, до которого файл
+    исправен. Функция truncate() обрезает файл по этому смещению и записывает в
+    заголовок количество оставшихся пакетов.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Проверка файла, отображенного в память:
+
+    C_MappedStreamAnalyzer provider( a_filePath );
+    C_FileChecker checker( provider );
+    if ( !checker.check() ) {
+        std::cout << C_FileChecker::errorText( checker.result().Error )
+                  << " at offset " << checker.result().Offset << std::endl;
+    }
+
+  * Обрезание файла по первому поврежденному пакету (объект provider, через
+    который файл был открыт, должен быть уже удален):
+
+    C_FileChecker::truncate( a_filePath, result );
+
+*****************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "C_StreamAnalyzer.h"
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Проверка целостности файла *.mes
+ */
+class C_FileChecker
+{
+
+public: // types
+
+    // Ошибки файла
+    enum class E_Error {
+        None,               // Ошибок нет
+        ShortHeader,        // Файл короче заголовка
+        Overrun,            // Пакет выходит за границы файла
+        TimeBackwards,      // Время пакета меньше времени предыдущего пакета того же потока
+        BadStreamNum,       // Номер потока не меньше количества потоков в заголовке
+        CountMismatch       // Количество пакетов в заголовке не совпадает с цепочкой пакетов
+    };
+
+    // Результат проверки
+    struct T_Result {
+        E_Error         Error         = E_Error::None;  // Первая найденная ошибка
+        uint64_t        Offset        = 0;  // Смещение первого поврежденного пакета (размер исправной части файла)
+        unsigned long   ValidPackets  = 0;  // Количество исправных пакетов до Offset
+        unsigned long   RecordsInFile = 0;  // Количество пакетов в заголовке
+    };
+
+public:
+
+    explicit C_FileChecker( C_StreamAnalyzer &a_provider );
+
+    // Проверка файла
+    bool check();
+    // Результат последней проверки
+    const T_Result & result() const { return m_result; }
+
+    // Описание ошибки
+    static const char * errorText( E_Error a_error );
+    // Обрезание файла по первому поврежденному пакету
+    static bool truncate( const std::string &a_filePath, const T_Result &a_result );
+
+private:
+
+    // Проверка времени и номеров потоков пакетов по смещениям a_offsets
+    bool checkPackets( const uint64_t *a_offsets, std::size_t a_count );
+    // Фиксация ошибки a_error в пакете a_packNo по смещению a_offset
+    bool fail( E_Error a_error, unsigned long a_packNo, uint64_t a_offset );
+
+    // Номер первого пакета пачки с убывающим временем или неверным номером потока
+    static std::size_t findInvalid( const uint32_t *a_prevTimes, const uint32_t *a_times,
+                                    const uint32_t *a_streams, std::size_t a_count,
+                                    uint32_t a_streamQuan );
+
+private:
+
+    C_StreamAnalyzer   &m_provider;             // Разметчик проверяемого файла
+    T_Result            m_result;               // Результат проверки
+    uint32_t            m_streamQuan  = 0;      // Количество потоков в заголовке (0 - не проверяется)
+    unsigned long       m_checked     = 0;      // Количество проверенных пакетов
+    std::array<uint32_t, 256> m_lastTimes{};    // Время последнего проверенного пакета каждого потока
+
+private: // static
+
+    static const std::size_t s_batchSize;       // Количество пакетов в пачке
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
@@ -0,0 +1,271 @@
+/*****************************************************************************
+
+  C_IndexFile
+
+  Файл индекса пакетов (*.mes.idx), сохраняемый рядом с файлом данных *.mes
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Файл индекса состоит из заголовка T_Header и массива записей T_Entry.
+    Размеры структур зафиксированы (static_assert), поэтому файл индекса не
+    зависит от модели данных платформы (размера long).
+
+  * Время изменения файла данных хранится в наносекундах. В ОС Windows время
+    известно с точностью до секунды.
+
+  * Файл индекса недействителен, если размер файла индекса не соответствует
+    количеству записей в заголовке, поэтому усеченный файл не будет загружен.
+
+*****************************************************************************/
+
+#include "C_IndexFile.h"
+#include "C_Logger.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace network {
+
+using namespace services;
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+static_assert( sizeof(C_IndexFile::T_Entry)  == 24, "index entry layout must not depend on platform" );
+static_assert( sizeof(C_IndexFile::T_Header) == 48, "index header layout must not depend on platform" );
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const char     C_IndexFile::s_magic[8]  = { 'M', 'E', 'S', 'I', 'D', 'X', 0, 0 };  // Сигнатура формата
+const uint32_t C_IndexFile::s_version   = 1;                                        // Версия формата
+const uint32_t C_IndexFile::s_byteOrder = 0x01020304;                               // Метка порядка байтов
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ *
+ * Файл индекса загружается, если он существует и соответствует файлу данных
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу данных
+ */
+C_IndexFile::C_IndexFile( const std::string &a_filePath )
+{
+    uint64_t fileSize  = 0;
+    int64_t  fileMTime = 0;
+    if ( !fileStamp( a_filePath, fileSize, fileMTime ) ) {
+        return;
+    }
+    std::string indexPath = pathFor( a_filePath );
+
+#ifndef _WIN32
+    int fd = ::open( indexPath.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 ) {
+        return;
+    }
+    struct stat info;
+    if ( fstat( fd, &info ) < 0 || static_cast<std::size_t>( info.st_size ) < sizeof(T_Header) ) {
+        ::close( fd );
+        return;
+    }
+    std::size_t size = static_cast<std::size_t>( info.st_size );
+    void *mapping = mmap( nullptr, size, PROT_READ, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if ( mapping == MAP_FAILED ) {
+        g_log << indexPath << " is not mapped: " << strerror(errno) << std::endl;
+        return;
+    }
+    m_mapping = mapping;
+    m_mapSize = size;
+    const char *data = static_cast<const char*>( mapping );
+#else
+    std::ifstream stream( indexPath, std::ios::binary | std::ios::ate );
+    if ( !stream.is_open() ) {
+        return;
+    }
+    std::size_t size = static_cast<std::size_t>( stream.tellg() );
+    if ( size < sizeof(T_Header) ) {
+        return;
+    }
+    m_buffer.resize( size );
+    stream.seekg( 0, std::ios_base::beg );
+    if ( !stream.read( m_buffer.data(), static_cast<std::streamsize>( size ) ) ) {
+        return;
+    }
+    const char *data = m_buffer.data();
+#endif
+
+    const T_Header *header = reinterpret_cast<const T_Header*>( data );
+    if ( !checkHeader( *header, fileSize, fileMTime, size ) ) {
+        g_log << indexPath << " is outdated or damaged" << std::endl;
+        return;
+    }
+    m_entries = reinterpret_cast<const T_Entry*>( data + sizeof(T_Header) );
+    m_count   = static_cast<std::size_t>( header->Count );
+}
+
+/*****************************************************************************
+ * Деструктор
+ */
+C_IndexFile::~C_IndexFile()
+{
+#ifndef _WIN32
+    if ( m_mapping ) {
+        munmap( m_mapping, m_mapSize );
+    }
+#endif
+}
+
+/*****************************************************************************
+ * Путь к файлу индекса для файла данных
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу данных
+ *
+ * @return
+ *  - путь к файлу индекса (путь к файлу данных с расширением .idx)
+ */
+std::string C_IndexFile::pathFor( const std::string &a_filePath )
+{
+    return a_filePath + ".idx";
+}
+
+/*****************************************************************************
+ * Сохранение индекса для файла данных
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу данных
+ *  [in] a_entries  - записи индекса
+ *
+ * @return
+ *  true  - файл индекса записан
+ *  false - ошибка записи
+ */
+bool C_IndexFile::write( const std::string &a_filePath, const std::vector<T_Entry> &a_entries )
+{
+    T_Header header;
+    memset( &header, 0, sizeof(header) );
+    if ( !fileStamp( a_filePath, header.FileSize, header.FileMTime ) ) {
+        return false;
+    }
+    memcpy( header.Magic, s_magic, sizeof(header.Magic) );
+    header.Version   = s_version;
+    header.ByteOrder = s_byteOrder;
+    header.EntrySize = sizeof(T_Entry);
+    header.Count     = a_entries.size();
+
+    std::string indexPath = pathFor( a_filePath );
+    std::string tempPath  = indexPath + "."
+                          + std::to_string( std::chrono::steady_clock::now().time_since_epoch().count() );
+    {
+        std::ofstream stream( tempPath, std::ios::binary | std::ios::trunc );
+        stream.write( reinterpret_cast<const char*>( &header ), sizeof(header) );
+        stream.write( reinterpret_cast<const char*>( a_entries.data() ),
+                      static_cast<std::streamsize>( a_entries.size() * sizeof(T_Entry) ) );
+        if ( !stream ) {
+            g_log << tempPath << " is not written" << std::endl;
+            stream.close();
+            std::remove( tempPath.c_str() );
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    // В ОС Windows rename() не заменяет существующий файл
+    std::remove( indexPath.c_str() );
+#endif
+    if ( std::rename( tempPath.c_str(), indexPath.c_str() ) != 0 ) {
+        g_log << indexPath << " is not written: " << strerror(errno) << std::endl;
+        std::remove( tempPath.c_str() );
+        return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Получение размера и времени изменения файла данных
+ *
+ * @param
+ *  [in]  a_filePath - путь к файлу данных
+ *  [out] a_size     - размер файла
+ *  [out] a_mtime    - время последнего изменения файла, нс
+ *
+ * @return
+ *  true  - параметры файла получены
+ *  false - файл недоступен
+ */
+bool C_IndexFile::fileStamp( const std::string &a_filePath, uint64_t &a_size, int64_t &a_mtime )
+{
+#ifdef _WIN32
+    struct _stat64 info;
+    if ( _stat64( a_filePath.c_str(), &info ) != 0 ) {
+        return false;
+    }
+    a_mtime = static_cast<int64_t>( info.st_mtime ) * 1000000000;
+#else
+    struct stat info;
+    if ( stat( a_filePath.c_str(), &info ) != 0 ) {
+        return false;
+    }
+    a_mtime = static_cast<int64_t>( info.st_mtim.tv_sec ) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+    a_size = static_cast<uint64_t>( info.st_size );
+    return true;
+}
+
+/*****************************************************************************
+ * Проверка заголовка файла индекса
+ *
+ * @param
+ *  [in] a_header    - заголовок файла индекса
+ *  [in] a_fileSize  - размер файла данных
+ *  [in] a_fileMTime - время изменения файла данных
+ *  [in] a_indexSize - размер файла индекса
+ *
+ * @return
+ *  true  - файл индекса соответствует файлу данных
+ *  false - файл индекса устарел или поврежден
+ */
+bool C_IndexFile::checkHeader( const T_Header &a_header, uint64_t a_fileSize,
+                               int64_t a_fileMTime, uint64_t a_indexSize )
+{
+    return memcmp( a_header.Magic, s_magic, sizeof(s_magic) ) == 0
+        && a_header.Version   == s_version
+        && a_header.ByteOrder == s_byteOrder
+        && a_header.EntrySize == sizeof(T_Entry)
+        && a_header.FileSize  == a_fileSize
+        && a_header.FileMTime == a_fileMTime
+        && a_header.Count     == ( a_indexSize - sizeof(T_Header) ) / sizeof(T_Entry)
+        && ( a_indexSize - sizeof(T_Header) ) % sizeof(T_Entry) == 0;
+}
+
+} // namespace network
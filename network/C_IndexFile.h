@@ -0,0 +1,151 @@
+/*****************************************************************************
+
+  C_IndexFile
+
+  Файл индекса пакетов (*.mes.idx), сохраняемый рядом с файлом данных *.mes
+
+
+  ОПИСАНИЕ
+
+  * Файл индекса содержит для каждого пакета файла данных смещение от начала
+    файла, размер, время и номер потока. При повторном открытии того же файла
+    данных индекс загружается из файла индекса без обхода цепочки пакетов.
+
+  * В заголовке файла индекса хранятся размер и время последнего изменения файла
+    данных. Если файл данных изменился, файл индекса считается недействительным.
+
+  * Записи имеют фиксированный размер и порядок байтов платформы, на которой
+    файл индекса был создан. Файл индекса, созданный на платформе с другим
+    порядком байтов или другой версией формата, считается недействительным.
+
+  * Файл индекса отображается в память одним вызовом mmap() (в ОС Windows -
+    читается целиком), записи доступны без копирования до удаления объекта.
+
+  * Запись выполняется во временный файл, который затем переименовывается,
+    поэтому параллельно работающие сессии не увидят частично записанный индекс.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Загрузка индекса для файла данных a_filePath:
+
+    C_IndexFile indexFile( a_filePath );
+    if ( indexFile.isValid() ) {
+        const C_IndexFile::T_Entry *entries = indexFile.entries();
+        ... indexFile.count() записей ...
+    }
+
+  * Сохранение индекса:
+
+    C_IndexFile::write( a_filePath, entries );
+
+*****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Файл индекса пакетов
+ */
+class C_IndexFile
+{
+
+public: // types
+
+    // Запись индекса об одном пакете
+    struct T_Entry {
+        uint64_t    Offset;             // Смещение пакета от начала файла данных
+        uint64_t    Time;               // Время пакета T_Packet::Time
+        uint32_t    Size;               // Размер пакета вместе с заголовком T_Packet
+        uint8_t     StreamNum;          // Номер потока T_Packet::StreamNum
+        uint8_t     Reserved[3];        // Выравнивание
+    };
+
+    // Заголовок файла индекса
+    struct T_Header {
+        char        Magic[8];           // Сигнатура формата "MESIDX"
+        uint32_t    Version;            // Версия формата
+        uint32_t    ByteOrder;          // Метка порядка байтов
+        uint32_t    EntrySize;          // Размер записи T_Entry
+        uint32_t    Reserved;           // Выравнивание
+        uint64_t    FileSize;           // Размер файла данных
+        int64_t     FileMTime;          // Время изменения файла данных, нс
+        uint64_t    Count;              // Количество записей
+    };
+
+public:
+
+    explicit C_IndexFile( const std::string &a_filePath );
+    ~C_IndexFile();
+
+    C_IndexFile( const C_IndexFile&  ) = delete;
+    C_IndexFile(       C_IndexFile&& ) = delete;
+    C_IndexFile & operator = ( const C_IndexFile&  ) = delete;
+    C_IndexFile & operator = (       C_IndexFile&& ) = delete;
+
+    // Файл индекса существует и соответствует файлу данных
+    bool isValid() const { return m_entries != nullptr; }
+    // Количество записей
+    std::size_t count() const { return m_count; }
+    // Записи индекса
+    const T_Entry * entries() const { return m_entries; }
+
+    // Путь к файлу индекса для файла данных
+    static std::string pathFor( const std::string &a_filePath );
+    // Сохранение индекса для файла данных
+    static bool write( const std::string &a_filePath, const std::vector<T_Entry> &a_entries );
+    // Получение размера и времени изменения файла данных
+    static bool fileStamp( const std::string &a_filePath, uint64_t &a_size, int64_t &a_mtime );
+
+private:
+
+    // Проверка заголовка файла индекса
+    static bool checkHeader( const T_Header &a_header, uint64_t a_fileSize,
+                             int64_t a_fileMTime, uint64_t a_indexSize );
+
+private:
+
+    void               *m_mapping  = nullptr;   // Отображение файла индекса
+    std::size_t         m_mapSize  = 0;         // Размер отображения
+    std::vector<char>   m_buffer;               // Содержимое файла индекса (без mmap())
+    const T_Entry      *m_entries  = nullptr;   // Записи индекса
+    std::size_t         m_count    = 0;         // Количество записей
+
+private: // static
+
+    static const char       s_magic[8];         // Сигнатура формата
+    static const uint32_t   s_version;          // Версия формата
+    static const uint32_t   s_byteOrder;        // Метка порядка байтов
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
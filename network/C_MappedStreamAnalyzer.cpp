@@ -0,0 +1,107 @@
+/*****************************************************************************
+
+  C_MappedStreamAnalyzer
+
+  Класс для индексации пакетов внутри файла *.mes, отображенного в память
+  (ОС Linux)
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Дескриптор файла закрывается сразу после создания отображения: отображение
+    остается действительным до вызова munmap() в деструкторе.
+
+  * Если файл не удается открыть или отобразить, размер данных остается нулевым,
+    и расчет индекса завершается ошибкой.
+
+*****************************************************************************/
+
+#include "C_MappedStreamAnalyzer.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const std::size_t C_MappedStreamAnalyzer::s_prefetchSize = 4 * 1024 * 1024;    // 4 megabytes
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу с данными
+ */
+C_MappedStreamAnalyzer::C_MappedStreamAnalyzer( const std::string &a_filePath )
+    : C_StreamAnalyzer( nullptr, 0 )
+{
+    int fd = ::open( a_filePath.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 ) {
+        g_log << "file " << a_filePath << " is not opened: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    struct stat info;
+    if ( fstat( fd, &info ) < 0 || info.st_size <= 0 ) {
+        g_log << "file " << a_filePath << " is empty or not accessible" << std::endl;
+        ::close( fd );
+        return;
+    }
+
+    std::size_t length = static_cast<std::size_t>( info.st_size );
+    void *mapping = mmap( nullptr, length, PROT_READ, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if ( mapping == MAP_FAILED ) {
+        g_log << "file " << a_filePath << " is not mapped: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    // Подсказки носят рекомендательный характер, ошибки не влияют на работу
+    madvise( mapping, length, MADV_SEQUENTIAL );
+    madvise( mapping, std::min( length, s_prefetchSize ), MADV_WILLNEED );
+
+    m_mapping = mapping;
+    m_data    = static_cast<const char*>( mapping );
+    m_size    = length;
+    g_log << "file size: " << length << " (mapped)" << std::endl;
+}
+
+/*****************************************************************************
+ * Деструктор
+ */
+C_MappedStreamAnalyzer::~C_MappedStreamAnalyzer()
+{
+    if ( m_mapping ) {
+        munmap( m_mapping, m_size );
+    }
+}
+
+} // namespace network
@@ -0,0 +1,89 @@
+/*****************************************************************************
+
+  C_MappedStreamAnalyzer
+
+  Класс для индексации пакетов внутри файла *.mes, отображенного в память
+  (ОС Linux)
+
+
+  ОПИСАНИЕ
+
+  * В отличие от C_StreamAnalyzer, файл не копируется в буфер процесса, а
+    отображается в память только для чтения (mmap()). Страницы файла загружаются
+    с диска при первом обращении и разделяются через страничный кэш между всеми
+    сессиями, работающими с одним файлом.
+
+  * Отображению задается подсказка последовательного чтения (MADV_SEQUENTIAL),
+    а для начала файла запрашивается упреждающее чтение (MADV_WILLNEED).
+
+  * Интерфейс headerRange()/packetRange()/getPacket() совпадает с интерфейсом
+    C_StreamAnalyzer, итераторы указывают на отображенную память и действительны
+    до удаления объекта.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Отображение файла и расчет индекса:
+
+    auto provider = std::make_unique<C_MappedStreamAnalyzer>( a_filePath );
+    if ( provider->size() == 0 ) { ... файл не удалось отобразить ... }
+    provider->calcIndex();
+
+  * Далее использование совпадает с C_StreamAnalyzer (см. C_StreamAnalyzer.h)
+
+*****************************************************************************/
+
+#pragma once
+
+#include <string>
+
+#include "C_StreamAnalyzer.h"
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Класс для индексации пакетов внутри файла, отображенного в память
+ */
+class C_MappedStreamAnalyzer : public C_StreamAnalyzer
+{
+
+public:
+
+    explicit C_MappedStreamAnalyzer( const std::string &a_filePath );
+    virtual ~C_MappedStreamAnalyzer() override;
+
+private:
+
+    void       *m_mapping = nullptr;    // Начало отображения файла
+
+private: // static
+
+    static const std::size_t s_prefetchSize;    // Объем упреждающего чтения начала файла
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
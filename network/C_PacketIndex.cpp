@@ -0,0 +1,129 @@
+/*****************************************************************************
+
+  C_PacketIndex
+
+  Компактный индекс пакетов файла с данными в формате *.mes
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Размер блока выбран так, чтобы s_blockSize пакетов максимального размера
+    (заголовок T_Packet и 65535 байт данных) не превышали 4 гигабайт.
+
+*****************************************************************************/
+
+#include "C_PacketIndex.h"
+#include "record_views.h"
+
+#include <limits>
+#include <utility>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const unsigned    C_PacketIndex::s_blockShift;
+const std::size_t C_PacketIndex::s_blockSize;
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Добавление пакета
+ *
+ * @param
+ *  [in] a_offset - смещение пакета (для непустого индекса - endOffset())
+ *  [in] a_size   - размер пакета вместе с заголовком
+ */
+void C_PacketIndex::push_back( uint64_t a_offset, uint32_t a_size )
+{
+    static_assert( ( T_PacketView::headerSize() + std::numeric_limits<uint16_t>::max() ) * s_blockSize
+                   <= std::numeric_limits<uint32_t>::max(), "packet offsets inside a block must fit in 32 bits" );
+
+    if ( m_deltas.size() % s_blockSize == 0 ) {
+        m_bases.push_back( a_offset );
+    }
+    m_deltas.push_back( static_cast<uint32_t>( a_offset - m_bases.back() ) );
+    m_end = a_offset + a_size;
+}
+
+/*****************************************************************************
+ * Резервирование памяти
+ *
+ * @param
+ *  [in] a_count - ожидаемое количество пакетов
+ */
+void C_PacketIndex::reserve( std::size_t a_count )
+{
+    m_bases.reserve( ( a_count + s_blockSize - 1 ) / s_blockSize );
+    m_deltas.reserve( a_count );
+}
+
+/*****************************************************************************
+ * Удаление всех пакетов
+ */
+void C_PacketIndex::clear()
+{
+    m_bases.clear();
+    m_deltas.clear();
+    m_end = 0;
+}
+
+/*****************************************************************************
+ * Обмен содержимым с другим индексом
+ *
+ * @param
+ *  [in] a_other - индекс, с которым производится обмен
+ */
+void C_PacketIndex::swap( C_PacketIndex &a_other )
+{
+    m_bases.swap( a_other.m_bases );
+    m_deltas.swap( a_other.m_deltas );
+    std::swap( m_end, a_other.m_end );
+}
+
+/*****************************************************************************
+ * Объем памяти, занимаемой индексом
+ *
+ * @return
+ *  - размер выделенной под индекс памяти в байтах
+ */
+std::size_t C_PacketIndex::memoryUsage() const
+{
+    return m_bases.capacity() * sizeof(uint64_t) + m_deltas.capacity() * sizeof(uint32_t);
+}
+
+/*****************************************************************************
+ * Сравнение индексов
+ *
+ * @param
+ *  [in] a_other - индекс для сравнения
+ *
+ * @return
+ *  true - индексы содержат одни и те же пакеты
+ */
+bool C_PacketIndex::operator == ( const C_PacketIndex &a_other ) const
+{
+    return m_end == a_other.m_end && m_bases == a_other.m_bases && m_deltas == a_other.m_deltas;
+}
+
+} // namespace network
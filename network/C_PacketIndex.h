@@ -0,0 +1,162 @@
+/*****************************************************************************
+
+  C_PacketIndex
+
+  Компактный индекс пакетов файла с данными в формате *.mes
+
+
+  ОПИСАНИЕ
+
+  * Индекс хранит смещения пакетов от начала данных файла. Пакеты файла следуют
+    друг за другом без промежутков, поэтому конец пакета совпадает с началом
+    следующего, и отдельно хранится только конец последнего пакета.
+
+  * Смещения хранятся блоками по s_blockSize пакетов: для блока хранится полное
+    64-битное смещение первого пакета, для каждого пакета - 32-битное смещение
+    относительно начала блока. Пакет занимает не более 64 килобайт, поэтому
+    смещение внутри блока всегда умещается в 32 бита. На пакет приходится чуть
+    больше 4 байт индекса вместо пары указателей.
+
+  * Индекс не содержит указателей, поэтому не зависит от адреса, по которому
+    загружены данные файла.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Заполнение индекса (каждый пакет начинается в конце предыдущего):
+
+    C_PacketIndex index;
+    index.push_back( T_FileHeaderView::size(), packetSize );
+    index.push_back( index.endOffset(), nextPacketSize );
+
+  * Границы пакета a_packNo:
+
+    uint64_t begin = index.offset( a_packNo );
+    uint64_t end   = index.endOffset( a_packNo );
+
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Компактный индекс пакетов
+ */
+class C_PacketIndex
+{
+
+public:
+
+    // Добавление пакета, начинающегося в конце последнего пакета индекса
+    void push_back( uint64_t a_offset, uint32_t a_size );
+    // Резервирование памяти под a_count пакетов
+    void reserve( std::size_t a_count );
+    // Удаление всех пакетов
+    void clear();
+    // Обмен содержимым с другим индексом
+    void swap( C_PacketIndex &a_other );
+
+    // Количество пакетов в индексе
+    std::size_t size() const { return m_deltas.size(); }
+    // Индекс не содержит пакетов
+    bool empty() const { return m_deltas.empty(); }
+
+    // Смещение начала пакета a_packNo
+    uint64_t offset( std::size_t a_packNo ) const;
+    // Смещение конца пакета a_packNo
+    uint64_t endOffset( std::size_t a_packNo ) const;
+    // Смещение конца последнего пакета
+    uint64_t endOffset() const { return m_end; }
+    // Размер пакета a_packNo вместе с заголовком
+    uint32_t packetSize( std::size_t a_packNo ) const;
+
+    // Объем памяти, занимаемой индексом, в байтах
+    std::size_t memoryUsage() const;
+
+    bool operator == ( const C_PacketIndex &a_other ) const;
+
+private:
+
+    std::vector<uint64_t>   m_bases;    // Смещения первых пакетов блоков
+    std::vector<uint32_t>   m_deltas;   // Смещения пакетов относительно начала блока
+    uint64_t                m_end = 0;  // Смещение конца последнего пакета
+
+private: // static
+
+    static const unsigned   s_blockShift = 12;                  // Двоичный логарифм размера блока
+    static const std::size_t s_blockSize = 1u << s_blockShift;  // Количество пакетов в блоке
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Смещение начала пакета
+ *
+ * @param
+ *  [in] a_packNo - номер пакета (меньше size())
+ *
+ * @return
+ *  - смещение пакета от начала данных файла
+ */
+inline uint64_t C_PacketIndex::offset( std::size_t a_packNo ) const
+{
+    return m_bases[a_packNo >> s_blockShift] + m_deltas[a_packNo];
+}
+
+/*****************************************************************************
+ * Смещение конца пакета
+ *
+ * @param
+ *  [in] a_packNo - номер пакета (меньше size())
+ *
+ * @return
+ *  - смещение первого байта за пакетом от начала данных файла
+ */
+inline uint64_t C_PacketIndex::endOffset( std::size_t a_packNo ) const
+{
+    return ( a_packNo + 1 < m_deltas.size() ) ? offset( a_packNo + 1 ) : m_end;
+}
+
+/*****************************************************************************
+ * Размер пакета
+ *
+ * @param
+ *  [in] a_packNo - номер пакета (меньше size())
+ *
+ * @return
+ *  - размер пакета вместе с заголовком T_Packet
+ */
+inline uint32_t C_PacketIndex::packetSize( std::size_t a_packNo ) const
+{
+    return static_cast<uint32_t>( endOffset( a_packNo ) - offset( a_packNo ) );
+}
+
+} // namespace network
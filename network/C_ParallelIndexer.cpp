@@ -0,0 +1,244 @@
+/*****************************************************************************
+
+  C_ParallelIndexer
+
+  Многопоточный расчет смещений пакетов внутри файла с данными в формате *.mes
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Участок k обрабатывается потоком k, первый участок (начинающийся с первого
+    пакета) проходится сшивкой последовательно, поэтому для него поток не создается.
+
+  * Предположительная цепочка участка содержит смещения пакетов, начинающихся
+    внутри участка, в порядке возрастания, поэтому вхождение истинного смещения
+    в цепочку проверяется двоичным поиском.
+
+  * При сшивке проверка выхода пакета за границы данных выполняется для каждого
+    пакета истинной цепочки, поэтому поврежденный пакет обнаруживается так же,
+    как при последовательном обходе.
+
+*****************************************************************************/
+
+#include "C_ParallelIndexer.h"
+#include "record_views.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const std::size_t C_ParallelIndexer::s_minChunkSize = 16 * 1024 * 1024;  // Минимальный размер участка 16 megabytes
+const unsigned    C_ParallelIndexer::s_syncPackets  = 8;                 // Длина цепочки для проверки правдоподобия
+const uint64_t    C_ParallelIndexer::s_maxTimeGap   = 60 * 60 * 1000;    // Максимальная разница времени пакетов 1 час
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ *
+ * @param
+ *  [in] a_data        - данные файла
+ *  [in] a_size        - размер данных файла
+ *  [in] a_firstOffset - смещение первого пакета (размер заголовка файла)
+ *  [in] a_packCount   - количество пакетов в файле
+ *  [in] a_streamQuan  - количество потоков в файле (0 - номер потока не проверяется)
+ */
+C_ParallelIndexer::C_ParallelIndexer( const char *a_data, std::size_t a_size, std::size_t a_firstOffset,
+                                      std::size_t a_packCount, unsigned a_streamQuan )
+    : m_data( a_data ),
+      m_size( a_size ),
+      m_firstOffset( a_firstOffset ),
+      m_packCount( a_packCount ),
+      m_streamQuan( a_streamQuan )
+{
+}
+
+/*****************************************************************************
+ * Расчет смещений пакетов
+ *
+ * @param
+ *  [in]  a_threadCount - количество потоков (с учетом вызывающего)
+ *  [out] a_index       - индекс пакетов
+ *
+ * @return
+ *  true  - найдены смещения всех пакетов
+ *  false - данные повреждены, a_index содержит пакеты до поврежденного
+ */
+bool C_ParallelIndexer::run( unsigned a_threadCount, C_PacketIndex &a_index ) const
+{
+    a_index.clear();
+    if ( m_firstOffset > m_size ) {
+        return m_packCount == 0;
+    }
+
+    std::size_t chunkCount = std::max<std::size_t>( 1, std::min<std::size_t>(
+                                 a_threadCount, ( m_size - m_firstOffset ) / s_minChunkSize ) );
+    std::size_t chunkSize  = ( m_size - m_firstOffset + chunkCount - 1 ) / chunkCount;
+
+    std::vector<T_Chain>     chains( chunkCount );
+    std::vector<std::thread> threads;
+    for ( std::size_t k = 1; k < chunkCount; k++ ) {
+        uint64_t begin = m_firstOffset + k * chunkSize;
+        uint64_t end   = std::min<uint64_t>( begin + chunkSize, m_size );
+        threads.emplace_back( [this, begin, end, &chains, k](){ speculate( begin, end, chains[k] ); } );
+    }
+
+    // Резервирование с учетом того, что количество пакетов в заголовке может быть неверным
+    a_index.reserve( std::min<std::size_t>( m_packCount, ( m_size - m_firstOffset ) / T_PacketView::headerSize() ) );
+
+    for ( auto &thread : threads ) {
+        thread.join();
+    }
+
+    // Сшивка участков по истинной цепочке
+    uint64_t offset = m_firstOffset;
+    for ( std::size_t k = 0; k < chunkCount && a_index.size() < m_packCount; k++ ) {
+        uint64_t end = std::min<uint64_t>( m_firstOffset + ( k + 1 ) * chunkSize, m_size );
+        const std::vector<uint64_t> &spec = chains[k].Offsets;
+
+        while ( offset < end && a_index.size() < m_packCount ) {
+            auto found = std::lower_bound( spec.begin(), spec.end(), offset );
+            if ( found != spec.end() && *found == offset ) {
+                // Цепочки встретились: остаток участка берется из предположительной цепочки
+                std::size_t count = std::min<std::size_t>( spec.end() - found,
+                                                           m_packCount - a_index.size() );
+                for ( auto it = found; it != found + count; ++it ) {
+                    a_index.push_back( *it, static_cast<uint32_t>( next( *it ) - *it ) );
+                }
+                offset = ( found + count == spec.end() ) ? chains[k].Exit : *( found + count );
+                break;
+            }
+            if ( !fits( offset ) ) {
+                return false;
+            }
+            a_index.push_back( offset, static_cast<uint32_t>( next( offset ) - offset ) );
+            offset = next( offset );
+        }
+    }
+
+    // Пакеты после конца данных (количество пакетов в заголовке больше фактического)
+    while ( a_index.size() < m_packCount ) {
+        if ( !fits( offset ) ) {
+            return false;
+        }
+        a_index.push_back( offset, static_cast<uint32_t>( next( offset ) - offset ) );
+        offset = next( offset );
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Поиск и обход предположительной цепочки пакетов участка
+ *
+ * @param
+ *  [in]  a_begin - начало участка
+ *  [in]  a_end   - конец участка
+ *  [out] a_chain - цепочка пакетов, начинающихся внутри участка
+ */
+void C_ParallelIndexer::speculate( uint64_t a_begin, uint64_t a_end, T_Chain &a_chain ) const
+{
+    for ( uint64_t candidate = a_begin; candidate < a_end; candidate++ ) {
+        if ( !isPlausible( candidate ) ) {
+            continue;
+        }
+        uint64_t offset = candidate;
+        while ( offset < a_end && fits( offset ) ) {
+            a_chain.Offsets.push_back( offset );
+            offset = next( offset );
+        }
+        a_chain.Exit = offset;
+        return;
+    }
+}
+
+/*****************************************************************************
+ * Проверка правдоподобия цепочки пакетов
+ *
+ * @param
+ *  [in] a_offset - предполагаемое смещение пакета
+ *
+ * @return
+ *  true  - s_syncPackets пакетов подряд (или все пакеты до конца данных) правдоподобны
+ *  false - смещение не является началом пакета
+ */
+bool C_ParallelIndexer::isPlausible( uint64_t a_offset ) const
+{
+    uint64_t offset = a_offset;
+    for ( unsigned n = 0; n < s_syncPackets; n++ ) {
+        if ( offset == m_size ) {
+            return n > 0;
+        }
+        if ( !fits( offset ) ) {
+            return false;
+        }
+        T_PacketView packet( m_data + offset );
+        if ( m_streamQuan && packet.streamNum() >= m_streamQuan ) {
+            return false;
+        }
+        uint64_t nextOffset = next( offset );
+        if ( nextOffset + T_PacketView::headerSize() <= m_size ) {
+            T_PacketView nextPacket( m_data + nextOffset );
+            uint64_t gap = ( nextPacket.time() > packet.time() ) ? nextPacket.time() - packet.time()
+                                                                 : packet.time() - nextPacket.time();
+            if ( gap > s_maxTimeGap ) {
+                return false;
+            }
+        }
+        offset = nextOffset;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Проверка того, что пакет целиком находится внутри данных
+ *
+ * @param
+ *  [in] a_offset - смещение пакета
+ *
+ * @return
+ *  true  - заголовок и данные пакета не выходят за границы данных
+ *  false - пакет выходит за границы данных
+ */
+bool C_ParallelIndexer::fits( uint64_t a_offset ) const
+{
+    return a_offset + T_PacketView::headerSize() <= m_size && next( a_offset ) <= m_size;
+}
+
+/*****************************************************************************
+ * Смещение следующего пакета
+ *
+ * @param
+ *  [in] a_offset - смещение пакета (заголовок пакета должен находиться внутри данных)
+ *
+ * @return
+ *  - смещение пакета, следующего за пакетом по смещению a_offset
+ */
+uint64_t C_ParallelIndexer::next( uint64_t a_offset ) const
+{
+    return a_offset + T_PacketView( m_data + a_offset ).size();
+}
+
+} // namespace network
@@ -0,0 +1,125 @@
+/*****************************************************************************
+
+  C_ParallelIndexer
+
+  Многопоточный расчет смещений пакетов внутри файла с данными в формате *.mes
+
+
+  ОПИСАНИЕ
+
+  * Смещение каждого пакета определяется размером предыдущего, поэтому цепочка
+    пакетов не может быть обойдена параллельно напрямую. Индексатор делит данные
+    на участки и в каждом участке отдельным потоком предположительно находит
+    начало какого-либо пакета: смещение принимается, если начинающаяся с него
+    цепочка из нескольких пакетов правдоподобна (пакеты не выходят за границы
+    данных, номер потока меньше количества потоков в заголовке, время соседних
+    пакетов отличается не более чем на час). Затем поток проходит цепочку до конца
+    участка.
+
+  * Следующее смещение однозначно определяется текущим, поэтому если истинная
+    цепочка, пришедшая из предыдущего участка, попадает в одно из смещений
+    предположительной цепочки участка, дальше обе цепочки совпадают. При сшивке
+    участков истинная цепочка сверяется с предположительной, а там, где они
+    не встретились, участок проходится последовательно. Результат всегда
+    совпадает с результатом последовательного обхода.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Расчет смещений 1000 пакетов, первый из которых начинается после заголовка:
+
+    C_ParallelIndexer indexer( data, size, T_FileHeaderView::size(), 1000, streamQuan );
+    C_PacketIndex index;
+    if ( !indexer.run( 4, index ) ) {
+        ... данные повреждены, index содержит пакеты до поврежденного ...
+    }
+
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "C_PacketIndex.h"
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Многопоточный расчет смещений пакетов
+ */
+class C_ParallelIndexer
+{
+
+public:
+
+    C_ParallelIndexer( const char *a_data, std::size_t a_size, std::size_t a_firstOffset,
+                       std::size_t a_packCount, unsigned a_streamQuan );
+
+    // Расчет смещений пакетов в a_threadCount потоков
+    bool run( unsigned a_threadCount, C_PacketIndex &a_index ) const;
+
+    // Минимальный размер участка, обрабатываемого отдельным потоком
+    static std::size_t minChunkSize() { return s_minChunkSize; }
+
+private: // types
+
+    // Предположительная цепочка пакетов участка
+    struct T_Chain {
+        std::vector<uint64_t>   Offsets;            // Смещения пакетов цепочки внутри участка
+        uint64_t                Exit = 0;           // Смещение первого пакета за цепочкой
+    };
+
+private:
+
+    // Поиск и обход предположительной цепочки пакетов участка [a_begin, a_end)
+    void speculate( uint64_t a_begin, uint64_t a_end, T_Chain &a_chain ) const;
+    // Проверка правдоподобия цепочки из s_syncPackets пакетов начиная с a_offset
+    bool isPlausible( uint64_t a_offset ) const;
+    // Пакет по смещению a_offset целиком находится внутри данных
+    bool fits( uint64_t a_offset ) const;
+    // Смещение пакета, следующего за пакетом по смещению a_offset
+    uint64_t next( uint64_t a_offset ) const;
+
+private:
+
+    const char         *m_data;             // Данные файла
+    std::size_t         m_size;             // Размер данных файла
+    std::size_t         m_firstOffset;      // Смещение первого пакета
+    std::size_t         m_packCount;        // Количество пакетов в файле
+    unsigned            m_streamQuan;       // Количество потоков (0 - не проверяется)
+
+private: // static
+
+    static const std::size_t    s_minChunkSize;     // Минимальный размер участка
+    static const unsigned       s_syncPackets;      // Длина цепочки для проверки правдоподобия
+    static const uint64_t       s_maxTimeGap;       // Максимальная разница времени соседних пакетов, мсек
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
@@ -0,0 +1,567 @@
+/*****************************************************************************
+
+  C_PosixSocket
+
+  Класс сокета, частично реализующий интерфейс I_Socket поверх системного API
+  сокетов ОС Linux, общий для UDP/TCP сокетов
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * В отличие от C_Socket, инициализация библиотеки сокетов не требуется:
+    функция open() сразу создает файловый дескриптор сокета вызовом socket()
+    с флагом SOCK_CLOEXEC, чтобы дескриптор не наследовался дочерними процессами.
+
+  * Неблокирующий режим устанавливается через fcntl( F_SETFL, O_NONBLOCK ).
+
+  * Ошибки системных вызовов выводятся в лог по значению errno через strerror().
+
+  * Класс реализует стратегию RAII: в деструкторе производится вызов функции close(),
+    закрывающей файловый дескриптор сокета.
+
+*****************************************************************************/
+
+#include "C_PosixSocket.h"
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const size_t C_PosixSocket::s_fileChunkSize = 64 * 1024;   // Размер блока файла 64 kilobytes
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ */
+C_PosixSocket::C_PosixSocket( E_Protocol  a_proto,
+                              std::string a_name )
+                            : m_protoType( a_proto ),
+                              m_name     ( a_name  )
+{
+    switch ( m_protoType ) {
+        case E_Protocol::TCP:
+            m_protoCred = { AF_INET, SOCK_STREAM, IPPROTO_TCP };
+            break;
+
+        case E_Protocol::UDP:
+            m_protoCred = { AF_INET, SOCK_DGRAM, IPPROTO_UDP };
+            break;
+
+        default:
+            m_protoCred = { AF_INET, SOCK_DGRAM, IPPROTO_UDP };
+            m_protoType = E_Protocol::UDP;
+            break;
+    }
+
+    memset( &m_myService,   0, sizeof(m_myService)   );
+    memset( &m_peerService, 0, sizeof(m_peerService) );
+}
+
+/*****************************************************************************
+ * Деструктор
+ */
+C_PosixSocket::~C_PosixSocket()
+{
+    close();
+}
+
+/*****************************************************************************
+ * Инициализация параметров сокета, задание адреса и порта созданного сокета
+ *
+ * @param
+ *  [in] configuration - строка с настройками для сокета
+ *
+ * @return
+ *  true  - сокет успешно настроен
+ *  false - во время настройки произошла ошибка
+ */
+bool C_PosixSocket::setup( const std::string &a_configuration )
+{
+    std::vector<I_Socket::endpoint> endpoints = parseEndpointStr( a_configuration );
+    if ( endpoints.empty() ) {
+        g_log << name() << "setup: no endpoints in configuration" << std::endl;
+        return false;
+    }
+    m_socketType = endpoints.size() > 1 ? E_SocketType::Client : E_SocketType::Server;
+
+    I_Socket::endpoint firstEndpoint = *endpoints.begin();
+    bool setStat = configSock( firstEndpoint );
+
+    if ( m_socketType == E_SocketType::Client ) {
+        auto secondEndpoint = *endpoints.rbegin();
+        setPeerAddr( secondEndpoint );
+    }
+    return setStat;
+}
+
+/*****************************************************************************
+ * Сброс настроек сокета к начальным значениям
+ *
+ * @return
+ *  true  - сброс произведен успешно
+ *  false - во время сброса настроек произошла ошибка
+ */
+bool C_PosixSocket::flush()
+{
+    int on = 1;
+    int rc = setsockopt( m_masterSock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on) );
+
+    if ( rc < 0 ) {
+        g_log << name() << "setsockopt() failed: " << lastError() << std::endl;
+        return false;
+    }
+
+    if ( !setNonBlocking( E_SocketMode::Blocking ) ) {
+        g_log << name() << "problem with setting socket to blocking mode" << std::endl;
+        return false;
+    }
+
+    memset( &m_myService,   0, sizeof(m_myService)   );
+    memset( &m_peerService, 0, sizeof(m_peerService) );
+
+    m_name.clear();
+    m_socketType = E_SocketType::Invalid;
+    m_protoType  = E_Protocol::Invalid;
+
+    return true;
+}
+
+/*****************************************************************************
+ * Вызов системного API для создания сокета нужного типа
+ *
+ * @return
+ *  Статус успешности создания сокета нужного типа
+ *  true  - создание сокета произошло успешно
+ *  false - во время создания сокета произошла ошибка
+ */
+bool C_PosixSocket::open()
+{
+    if ( m_masterSock >= 0 ) {
+        g_log << "error: current socket descriptor has already been created!" << std::endl;
+        return false;
+    }
+
+    m_masterSock = ::socket( m_protoCred.domain,
+                             m_protoCred.type | SOCK_CLOEXEC,
+                             m_protoCred.protocol );
+
+    if ( m_masterSock < 0 ) {
+        g_log << name() << "socket() failed with error: " << lastError() << std::endl;
+        return false;
+    }
+    else {
+        g_log << name() << "initialized" << std::endl;
+        return true;
+    }
+}
+
+/*****************************************************************************
+ * Закрытие файлового дескриптора сокета
+ */
+void C_PosixSocket::close()
+{
+    if ( m_masterSock >= 0 ) {
+        ::close( m_masterSock );
+        m_masterSock = -1;
+    }
+}
+
+/*****************************************************************************
+ * Установка режима сокета (блокирующий/неблокирующий)
+ *
+ * @param
+ *  [in] a_mode - E_SocketMode::Blocking     - блокирующий режим
+ *              - E_SocketMode::NonBlocking  - неблокирующий режим
+ *
+ * @return
+ *  true  - режим успешно установлен
+ *  false - во время установки режима произошла ошибка
+ */
+bool C_PosixSocket::setNonBlocking( E_SocketMode a_mode )
+{
+    if ( m_masterSock < 0 ) {
+        g_log << "error: socket is not initialized" << std::endl;
+        return false;
+    }
+
+    int flags = fcntl( m_masterSock, F_GETFL, 0 );
+    if ( flags < 0 ) {
+        g_log << name() << "fcntl(F_GETFL) failed: " << lastError() << std::endl;
+        return false;
+    }
+
+    flags = ( a_mode == E_SocketMode::NonBlocking ) ? ( flags |  O_NONBLOCK )
+                                                    : ( flags & ~O_NONBLOCK );
+
+    if ( fcntl( m_masterSock, F_SETFL, flags ) < 0 ) {
+        g_log << name() << "fcntl(F_SETFL) failed: " << lastError() << std::endl;
+        return false;
+    }
+
+    m_mode = a_mode;
+    g_log << name() << ( a_mode == E_SocketMode::NonBlocking ? "socket non blocking mode set"
+                                                              : "socket is blocking" ) << std::endl;
+    return true;
+}
+
+/*****************************************************************************
+ * Текстовое описание последней ошибки системного вызова
+ *
+ * @return
+ *  - строка вида "errno (описание)"
+ */
+std::string C_PosixSocket::lastError()
+{
+    int err = errno;
+    return std::to_string( err ) + " (" + strerror( err ) + ")";
+}
+
+/*****************************************************************************
+ * Запоминание признака "операция не может быть выполнена без блокировки" по errno
+ *
+ * Вызывается сразу после неуспешного системного вызова, до вывода в лог. Каждая
+ * операция сокета сбрасывает признак в начале, поэтому wouldBlock() относится
+ * только к последней операции, а не к одной из предыдущих
+ */
+void C_PosixSocket::updateWouldBlock()
+{
+    m_wouldBlock = ( errno == EAGAIN      || errno == EWOULDBLOCK ||
+                     errno == EINPROGRESS || errno == EALREADY );
+}
+
+/*****************************************************************************
+ * Установка адреса и порта назначения (для клиента)
+ *
+ * Функция не производит проверку входных параметров
+ *
+ * @param
+ *  [in] a_endpoint - кортеж из адреса и порта получателя и режима работы сокета
+ */
+void C_PosixSocket::setPeerAddr( const I_Socket::endpoint &a_endpoint )
+{
+    std::string  addr;
+    uint16_t     port;
+    E_SocketMode mode;
+    std::tie( addr, port, mode ) = a_endpoint;
+
+    memset( &m_peerService, 0, sizeof(m_peerService) );
+
+    // Настройка IPv4
+    m_peerService.sin_family = AF_INET;
+    // Задание порта
+    m_peerService.sin_port   = htons( port );
+    // Установка адреса
+    inet_pton( AF_INET, addr.data(), &m_peerService.sin_addr );
+
+    g_log << name() << "destination is configured: "
+            << "[" + addr + ":" + std::to_string(port) + "]" << std::endl;
+    return;
+}
+
+/*****************************************************************************
+ * Пакетная отправка данных
+ *
+ * Реализация по умолчанию отправляет буферы последовательными вызовами send()
+ * до первой неудачной отправки
+ *
+ * @param
+ *  [in] a_buffs - буферы, данные из которых отправляются по сокету
+ *
+ * @return
+ *  - количество отправленных буферов
+ */
+size_t C_PosixSocket::sendBatch( const std::vector<std::vector<char>> &a_buffs )
+{
+    size_t sent = 0;
+    for ( const auto &buff : a_buffs ) {
+        if ( !send( buff ) ) {
+            break;
+        }
+        sent++;
+    }
+    return sent;
+}
+
+/*****************************************************************************
+ * Отправка кадров
+ *
+ * Реализация по умолчанию склеивает каждый кадр в буфере m_frameBuf и
+ * отправляет его вызовом send() до первой неудачной отправки
+ *
+ * @param
+ *  [in] a_frames - кадры
+ *  [in] a_count  - количество кадров
+ *
+ * @return
+ *  - количество отправленных кадров
+ */
+size_t C_PosixSocket::sendFrames( const T_Frame *a_frames, size_t a_count )
+{
+    size_t sent = 0;
+    for ( ; sent < a_count; sent++ ) {
+        const T_Frame &frame = a_frames[sent];
+        m_frameBuf.assign( frame.Head, frame.Head + frame.HeadSize );
+        m_frameBuf.insert( m_frameBuf.end(), frame.Data, frame.Data + frame.Size );
+        if ( !send( m_frameBuf ) ) {
+            break;
+        }
+    }
+    return sent;
+}
+
+/*****************************************************************************
+ * Прием данных через сокет
+ *
+ * Данные принимаются в текущий размер буфера, после приема размер буфера
+ * уменьшается до количества принятых байтов
+ *
+ * @param
+ *  [out] a_buff - ссылка на буфер, в который помещаются принятые данные
+ *
+ * @return
+ *  true  - прием данных произошел успешно
+ *  false - во время приема данных произошла ошибка
+ */
+bool C_PosixSocket::recv( std::vector<char> &a_buff )
+{
+    size_t received = 0;
+    if ( !recvInto( a_buff.data(), a_buff.size(), received ) ) {
+        return false;
+    }
+    a_buff.resize( received );
+    return true;
+}
+
+/*****************************************************************************
+ * Пакетный прием данных
+ *
+ * Реализация по умолчанию принимает данные одним вызовом recvInto() в первый
+ * буфер, чтобы не блокироваться в ожидании следующих данных
+ *
+ * @param
+ *  [out] a_buffs - буферы, в которые помещаются принятые данные
+ *  [out] a_sizes - количество байтов, принятых в каждый буфер
+ *
+ * @return
+ *  - количество заполненных буферов (0 или 1)
+ */
+size_t C_PosixSocket::recvBatch( std::vector<std::vector<char>> &a_buffs, std::vector<size_t> &a_sizes )
+{
+    a_sizes.resize( a_buffs.size() );
+    if ( a_buffs.empty() || !recvInto( a_buffs.front().data(), a_buffs.front().size(), a_sizes.front() ) ) {
+        return 0;
+    }
+    return 1;
+}
+
+/*****************************************************************************
+ * Отправка кадра из заголовка и полезной нагрузки
+ *
+ * Реализация по умолчанию не поддерживает отправку без копирования и
+ * отправляет склеенный кадр одним вызовом send() (см. sendFrames())
+ *
+ * @param
+ *  [in] a_frame - кадр
+ *
+ * @return
+ *  Статус успешности отправки кадра
+ */
+bool C_PosixSocket::sendZeroCopy( const T_Frame &a_frame )
+{
+    return sendFrames( &a_frame, 1 ) == 1;
+}
+
+/*****************************************************************************
+ * Отправка части файла
+ *
+ * Реализация по умолчанию читает блок файла вызовом pread() и отправляет его
+ * вызовом send() через рабочий сокет
+ *
+ * @param
+ *  [in]     a_fd     - дескриптор файла, открытого на чтение
+ *  [in,out] a_offset - смещение первого неотправленного байта в файле
+ *  [in,out] a_count  - количество байтов, которое осталось отправить
+ *
+ * @return
+ *  Статус успешности отправки
+ *  true  - отправлена часть данных, a_offset и a_count сдвинуты
+ *  false - ошибка чтения или отправки (wouldBlock() - отправка невозможна без блокировки)
+ */
+bool C_PosixSocket::sendFile( int a_fd, uint64_t &a_offset, size_t &a_count )
+{
+    m_wouldBlock = false;
+    std::vector<char> chunk( std::min( a_count, s_fileChunkSize ) );
+    auto numRead = ::pread( a_fd, chunk.data(), chunk.size(), static_cast<off_t>( a_offset ) );
+    if ( numRead <= 0 ) {
+        g_log << name() << "sendFile: read failed: "
+              << ( numRead < 0 ? lastError() : std::string( "unexpected end of file" ) ) << std::endl;
+        return false;
+    }
+
+    auto numBytes = ::send( handle(), chunk.data(), static_cast<size_t>( numRead ), MSG_NOSIGNAL );
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+
+    a_offset += static_cast<uint64_t>( numBytes );
+    a_count  -= static_cast<size_t>( numBytes );
+    return true;
+}
+
+/*****************************************************************************
+ * Прием потока с записью в файл
+ *
+ * Реализация по умолчанию принимает блок вызовом recv() и дописывает его
+ * в файл вызовом write()
+ *
+ * @param
+ *  [in]     a_fd    - дескриптор файла, открытого на запись
+ *  [in,out] a_count - количество байтов, которое осталось принять
+ *
+ * @return
+ *  Статус успешности приема
+ *  true  - часть данных принята и записана, a_count уменьшен
+ *  false - ошибка приема или записи (wouldBlock() - данных пока нет)
+ */
+bool C_PosixSocket::recvFile( int a_fd, size_t &a_count )
+{
+    m_wouldBlock = false;
+    std::vector<char> chunk( std::min( a_count, s_fileChunkSize ) );
+    auto numBytes = ::recv( handle(), chunk.data(), chunk.size(), 0 );
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+    if ( numBytes == 0 ) {
+        g_log << name() << "recvFile: connection closed" << std::endl;
+        return false;
+    }
+
+    for ( ssize_t written = 0; written < numBytes; ) {
+        auto numWritten = ::write( a_fd, chunk.data() + written,
+                                   static_cast<size_t>( numBytes - written ) );
+        if ( numWritten < 0 ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+            g_log << name() << "recvFile: write failed: " << lastError() << std::endl;
+            return false;
+        }
+        written += numWritten;
+    }
+
+    a_count -= static_cast<size_t>( numBytes );
+    return true;
+}
+
+/*****************************************************************************
+ * Лог-метка сокета
+ *
+ * @return
+ *  std::string - возвращает строковую метку сокета в формате:
+ *                 "logLabel [_tag_ socket addr:port]"
+ */
+std::string C_PosixSocket::name() const
+{
+    char addr[ INET_ADDRSTRLEN ] = { 0 };
+    inet_ntop( AF_INET, &m_myService.sin_addr, addr, sizeof(addr) );
+    uint16_t port = ntohs( m_myService.sin_port );
+
+    return "[" + m_name + std::string(" ")
+            + std::string(addr) + ":" + std::to_string(port) + "] ";
+}
+
+/*****************************************************************************
+ * Конфигурация параметров сокета
+ *
+ * Задание адреса и порта структуры
+ * Связывание (биндинг) файлового дескриптора сокета со структурой
+ *
+ * Функция не производит проверку входных параметров
+ *
+ * @param
+ *  [in] a_endpoint - кортеж из адреса и порта сокета и режима работы сокета
+ *
+ * @return
+ *   true  - сокет успешно инициализирован
+ *   false - во время инициализации сокета произошла ошибка
+ */
+bool C_PosixSocket::configSock( const I_Socket::endpoint &a_endpoint )
+{
+    std::string  addr;
+    uint16_t     port;
+    E_SocketMode blockingMode;
+    std::tie( addr, port, blockingMode ) = a_endpoint;
+
+    if ( !setSockOptions() ) {
+        return false;
+    }
+
+    if ( !setNonBlocking( blockingMode ) ) {
+        return false;
+    }
+
+    /*
+     * В ОС Linux порт сервера остается занятым в состоянии TIME_WAIT после
+     * завершения предыдущей сессии, поэтому адрес разрешается переиспользовать
+     * до вызова bind()
+     */
+    int on = 1;
+    if ( setsockopt( m_masterSock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on) ) < 0 ) {
+        g_log << name() << "setsockopt(SO_REUSEADDR) failed: " << lastError() << std::endl;
+        return false;
+    }
+
+    memset( &m_myService, 0, sizeof(m_myService) );
+
+    m_myService.sin_family = AF_INET;
+    m_myService.sin_port   = htons( port );
+    if ( inet_pton( AF_INET, addr.data(), &m_myService.sin_addr ) != 1 ) {
+        g_log << name() << "invalid address: " << addr << std::endl;
+        return false;
+    }
+
+    int bindStat = ::bind( m_masterSock,
+                           reinterpret_cast<sockaddr*>(&m_myService),
+                           sizeof(m_myService) );
+    if ( bindStat < 0 ) {
+       g_log << name() << "binding failed with error: " << lastError() << std::endl;
+       return false;
+    }
+    else {
+        g_log << name() << "binding done" << std::endl;
+    }
+    return true;
+}
+
+} // namespace network
@@ -0,0 +1,174 @@
+/*****************************************************************************
+
+  C_PosixSocket
+
+  Базовый абстрактный класс сокета, частично реализующий интерфейс I_Socket
+  поверх системного API сокетов ОС Linux (POSIX), общий для UDP/TCP сокетов
+
+
+  ОПИСАНИЕ
+
+  * Класс С_PosixSocket является аналогом C_Socket для ОС Linux: реализует
+    настройку сокета, перевод сокета в неблокирующий режим через fcntl(O_NONBLOCK)
+    и содержит общие для UDP/TCP поля данных.
+
+  * Файловые дескрипторы создаются с флагом SOCK_CLOEXEC, ошибки системных
+    вызовов сообщаются через errno.
+
+  * Класс служит основой для специфичных для ОС Linux ускоренных путей
+    приема-передачи данных (epoll, sendmmsg, sendfile).
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Использование объектов класса C_PosixSocket равносильно работе с объектами,
+    реализующими интерфейс I_Socket (см. I_Socket).
+
+  * Создание сокета производится через фабрику C_SocketFactory::createSocket()
+    с типом реализации E_SocketBackend::Posix (см. common_types.h).
+
+*****************************************************************************/
+
+#pragma once
+
+#include <netinet/in.h>
+#include <memory>
+
+#include "I_Socket.h"
+#include "utils.h"
+#include "C_Logger.h"
+
+namespace network {
+
+using namespace services;
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Базовый класс POSIX-сокета, частично реализующий интерфейс I_Socket
+ */
+class C_PosixSocket : public I_Socket
+{
+
+public:
+
+    C_PosixSocket( E_Protocol a_proto, std::string a_name );
+    virtual ~C_PosixSocket() override;
+
+public:
+
+    /**
+     * Интерфейс I_Socket
+     */
+
+    // Инициализация параметров сокета, задание адреса и порта созданного сокета
+    virtual bool setup( const std::string &a_configuration ) override;
+    // Сброс настроек сокета к начальным значениям
+    virtual bool flush() override;
+
+    // Вызов системного API для создания сокета
+    virtual bool open() override;
+    // Закрытие файлового дескриптора сокета
+    virtual void close() override;
+
+    // Лог-метка сокета
+    virtual std::string name() const override;
+
+    // Пакетная отправка данных (последовательными вызовами send())
+    virtual size_t sendBatch( const std::vector<std::vector<char>> &a_buffs ) override;
+    // Отправка кадров (со склейкой кадра, последовательными вызовами send())
+    virtual size_t sendFrames( const T_Frame *a_frames, size_t a_count ) override;
+    // Прием данных (через recvInto())
+    virtual bool recv(       std::vector<char> &a_buff ) override;
+    // Пакетный прием данных (одним вызовом recvInto())
+    virtual size_t recvBatch(       std::vector<std::vector<char>> &a_buffs,
+                                    std::vector<size_t> &a_sizes ) override;
+    // Отправка кадра (с копированием, одним вызовом send())
+    virtual bool sendZeroCopy( const T_Frame &a_frame ) override;
+    // Отправка части файла (чтение pread() и отправка send() блоками)
+    virtual bool sendFile( int a_fd, uint64_t &a_offset, size_t &a_count ) override;
+    // Прием потока с записью в файл (прием recv() и запись write() блоками)
+    virtual bool recvFile( int a_fd, size_t &a_count ) override;
+
+    // Системный дескриптор рабочего сокета
+    virtual int handle() const override { return m_masterSock; }
+    // Последняя неуспешная операция не могла быть выполнена без блокировки
+    virtual bool wouldBlock() const override { return m_wouldBlock; }
+    // Отправка выполняется сразу, отложенных операций нет
+    virtual bool submit() override { return true; }
+    // Данные кадров всегда копируются, отправок без копирования нет
+    virtual uint32_t zeroCopySent() const override { return 0; }
+    virtual uint32_t zeroCopyDone() const override { return 0; }
+
+protected:
+
+    /**
+     * Возможность добавить необходимые настроки сокету на этапе конфигурации сокета
+     * Вызов этого метода производится в теле функции configSock()
+     */
+    virtual bool setSockOptions() { return true; }
+
+    // Конфигурация параметров сокета
+    virtual bool configSock ( const I_Socket::endpoint &a_endpoint );
+
+    // Настройка параметров адресата (для клиента)
+    virtual void setPeerAddr( const I_Socket::endpoint &a_endpoint );
+
+    // Установка режима сокета (блокирующий/неблокирующий)
+    bool setNonBlocking( E_SocketMode a_mode );
+
+    // Текстовое описание последней ошибки системного вызова
+    static std::string lastError();
+
+    // Запоминание признака "операция не может быть выполнена без блокировки" по errno
+    void updateWouldBlock();
+
+protected: //types
+
+    struct ProtoCredentials {                       // Параметры используемого протокола
+        int domain;
+        int type;
+        int protocol;
+    } m_protoCred;
+
+protected:
+
+    int             m_masterSock = -1;                      // Файловый дескриптор сокета
+    E_Protocol      m_protoType;                            // Тип протокола создаваемого сокета
+    E_SocketType    m_socketType = E_SocketType::Invalid;   // Тип сокета: клиентский/серверный
+    E_SocketMode    m_mode       = E_SocketMode::Blocking;  // Режим работы сокета
+    sockaddr_in     m_myService;                            // Структура сокета
+    sockaddr_in     m_peerService;                          // Структура для хранения адреса получателя
+    std::string     m_name;                                 // Метка сокета
+    bool            m_wouldBlock = false;                   // Последняя операция не выполнена без блокировки
+    std::vector<char> m_frameBuf;                           // Буфер склейки кадра (см. sendFrames())
+
+protected: // static
+
+    static const size_t s_fileChunkSize;                    // Размер блока файла при копировании
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
@@ -0,0 +1,692 @@
+/*****************************************************************************
+
+  C_PosixTcpSocket
+
+  Класс TCP-сокета, реализующий интерфейс I_Socket поверх системного API
+  сокетов ОС Linux
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Для клиентского сокета рабочим является сам сокет m_masterSock, для серверного -
+    сокет, возвращаемый accept4(). Поэтому при закрытии рабочий сокет закрывается
+    отдельно только в том случае, если он не совпадает с m_masterSock.
+
+  * Флаг MSG_NOSIGNAL при отправке защищает процесс от сигнала SIGPIPE
+    в случае разрыва соединения клиентом.
+
+  * В отличие от C_TcpSocket, нулевой таймаут SO_LINGER не устанавливается: при
+    нем close() сбрасывает соединение (RST) и теряет еще не отправленные данные,
+    например Header::FileSent. Рабочий сокет закрывается после shutdown(SHUT_WR),
+    и ядро досылает очередь отправки перед завершением соединения (FIN).
+
+  * Ядро нумерует отправки с MSG_ZEROCOPY по порядку и сообщает о завершении
+    диапазонами номеров [ee_info, ee_data], поэтому для учета достаточно двух
+    счетчиков: отправленных и завершенных. Если ядро сообщает, что данные все же
+    были скопированы (SO_EE_CODE_ZEROCOPY_COPIED, например, на loopback), или
+    исчерпан лимит optmem (ENOBUFS), отправка выполняется обычным способом.
+
+  * Отправка файла выполняется вызовом sendfile(), а прием в файл - двумя
+    вызовами splice(): из сокета в канал (pipe) и из канала в файл, поэтому
+    данные не копируются в пространство пользователя. Канал создается при первом
+    приеме в файл. Если файловая система не поддерживает эти вызовы (EINVAL),
+    используется копирование блоками (см. C_PosixSocket).
+
+  * Остаток кадра после частичной отправки хранится в m_unsent и дописывается
+    обычным вызовом send() перед любой отправкой и при приеме. Отправка с
+    MSG_ZEROCOPY, отправившая кадр частично, учитывается как обычно: ядро
+    ссылается на отправленную часть буфера, остаток уже скопирован.
+
+*****************************************************************************/
+
+#include "C_PosixTcpSocket.h"
+
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const int C_PosixTcpSocket::s_pipeSize = 1024 * 1024;   // Запрашиваемая емкость канала 1 megabyte
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Деструктор
+ */
+C_PosixTcpSocket::~C_PosixTcpSocket()
+{
+    close();
+}
+
+/*****************************************************************************
+ * Закрытие сокета
+ *
+ * Закрывается рабочий сокет (если класс представляет клиентский сокет)
+ * Закрывается рабочий и слушающий сокет (если класс представляет серверный сокет)
+ */
+void C_PosixTcpSocket::close()
+{
+    if ( m_acceptedSocket >= 0 ) {
+        if ( ::shutdown( m_acceptedSocket, SHUT_WR ) < 0 ) {
+            g_log << name() << "shutdown: failed with error: " << lastError() << std::endl;
+        }
+        else {
+            g_log << name() << "shutdown: successfull " << std::endl;
+        }
+
+        if ( m_acceptedSocket != m_masterSock ) {
+            ::close( m_acceptedSocket );
+        }
+        m_acceptedSocket = -1;
+    }
+
+    for ( int &fd : m_pipe ) {
+        if ( fd >= 0 ) {
+            ::close( fd );
+            fd = -1;
+        }
+    }
+
+    m_unsent.clear();
+    m_isListening = false;
+    m_zeroCopy    = false;
+    m_zeroCopyOff = false;
+    m_zcSent      = 0;
+    m_zcDone      = 0;
+    C_PosixSocket::close();
+}
+
+/*****************************************************************************
+ * Отправка данных через сокет
+ *
+ * @param
+ *  [in] a_buff - ссылка на буфер, данные из которого отправляются по сокету
+ *
+ * @return
+ *  Статус успешности отправки данных через сокет
+ *  true  - данные отправлены (неотправленный остаток будет дописан позже)
+ *  false - во время отправки данных произошла ошибка
+ */
+bool C_PosixTcpSocket::send( const std::vector<char> &a_buff )
+{
+    m_wouldBlock = false;
+    if ( !flushUnsent() ) {
+        return false;
+    }
+    auto numBytes = ::send( m_acceptedSocket,
+                            a_buff.data(),
+                            a_buff.size(),
+                            MSG_NOSIGNAL );
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+    if ( static_cast<size_t>(numBytes) != a_buff.size() ) {
+        iovec iov;
+        iov.iov_base = const_cast<char*>( a_buff.data() );
+        iov.iov_len  = a_buff.size();
+        keepUnsent( &iov, 1, static_cast<size_t>(numBytes) );
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Прием данных через сокет
+ *
+ * @param
+ *  [out] a_data     - буфер, в который пишутся данные из сокета
+ *  [in]  a_capacity - размер буфера
+ *  [out] a_received - количество принятых байтов
+ *
+ * @return
+ *  Статус успешности приема данных через сокет
+ *  true  - прием данных произошел успешно
+ *  false - во время приема данных произошла ошибка
+ */
+bool C_PosixTcpSocket::recvInto( char *a_data, size_t a_capacity, size_t &a_received )
+{
+    if ( !m_unsent.empty() ) {
+        flushUnsent();
+    }
+
+    m_wouldBlock = false;
+    auto numBytes = ::recv( m_acceptedSocket,
+                            a_data,
+                            a_capacity,
+                            0 );
+
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+    else if ( numBytes == 0 ) {
+        g_log << name() << "recv: connection closed" << std::endl;
+        return false;
+    }
+    else {
+        a_received = static_cast<size_t>( numBytes );
+        return true;
+    }
+}
+
+/*****************************************************************************
+ * Настройка дополнительных параметров сокета
+ *
+ * @return
+ *  Статус успешности дополнительной настроки сокета
+ *  true  - настройка сокета произошло успешно
+ *  false - во время настройки сокета произошла ошибка
+ */
+bool C_PosixTcpSocket::setSockOptions()
+{
+    if ( m_masterSock < 0 ) {
+        g_log << "error: socket is not initialized" << std::endl;
+        return false;
+    }
+
+    /*
+     * Как и в C_TcpSocket, для уменьшения задержек на передачу маленьких пакетов
+     * отключается алгоритм Нагла. Буфер отправки SO_SNDBUF в ОС Linux не обнуляется:
+     * ядро ограничивает его снизу и такая настройка лишь замедлила бы отправку
+     */
+    if ( m_socketType == E_SocketType::Server ) {
+        int value = 1;
+        if ( setsockopt( m_masterSock, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value) ) < 0 ) {
+            g_log << name() << "setsockopt() failed while configuring no_delay option: "
+                    << lastError() << std::endl;
+            return false;
+        }
+    }
+
+    g_log << name() << "setsock configured successfully" << std::endl;
+    return true;
+}
+
+/*****************************************************************************
+ * Инициализация соединения
+ * Поведение функции разное в зависимости от типа сокета
+ *
+ * @return
+ *  Статус успешности инициализации соединения
+ *  true - соединение установлено
+ *  false - во время установки соединения произошла ошибка
+ */
+bool C_PosixTcpSocket::connect()
+{
+    switch ( m_socketType ) {
+
+        case E_SocketType::Client:
+            return this->connectToServer();
+
+        case E_SocketType::Server:
+            return this->connectToClient();
+
+        default:
+            return false;
+    }
+}
+
+/*****************************************************************************
+ * Системный дескриптор рабочего сокета
+ *
+ * @return
+ *  - дескриптор принятого соединения, если оно установлено, иначе - дескриптор
+ *    слушающего (для сервера) или подключаемого (для клиента) сокета
+ */
+int C_PosixTcpSocket::handle() const
+{
+    return m_acceptedSocket >= 0 ? m_acceptedSocket : m_masterSock;
+}
+
+/*****************************************************************************
+ * Отправка кадров вызовами sendmsg()
+ *
+ * Заголовок и данные кадра передаются ядру двумя iovec одного вызова, данные
+ * копируются ядром напрямую из буфера вызывающей стороны. Отправка
+ * прекращается на первом кадре, отправленном частично: его остаток
+ * сохраняется и дописывается позже
+ *
+ * @param
+ *  [in] a_frames - кадры
+ *  [in] a_count  - количество кадров
+ *
+ * @return
+ *  - количество отправленных кадров
+ */
+size_t C_PosixTcpSocket::sendFrames( const T_Frame *a_frames, size_t a_count )
+{
+    m_wouldBlock = false;
+    if ( !flushUnsent() ) {
+        return 0;
+    }
+    size_t sent = 0;
+    for ( ; sent < a_count; sent++ ) {
+        const T_Frame &frame = a_frames[sent];
+        iovec iov[2];
+        iov[0].iov_base = const_cast<char*>( frame.Head );
+        iov[0].iov_len  = frame.HeadSize;
+        iov[1].iov_base = const_cast<char*>( frame.Data );
+        iov[1].iov_len  = frame.Size;
+
+        msghdr msg = {};
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = 2;
+
+        auto numBytes = ::sendmsg( m_acceptedSocket, &msg, MSG_NOSIGNAL );
+        if ( numBytes < 0 ) {
+            updateWouldBlock();
+            break;
+        }
+        if ( static_cast<size_t>(numBytes) != frame.HeadSize + frame.Size ) {
+            keepUnsent( iov, 2, static_cast<size_t>(numBytes) );
+            sent++;
+            break;
+        }
+    }
+    return sent;
+}
+
+/*****************************************************************************
+ * Отправка кадра без копирования полезной нагрузки
+ *
+ * Заголовок и данные кадра передаются одним вызовом sendmsg() с флагом
+ * MSG_ZEROCOPY. Кадр и данные должны оставаться неизменными, пока submit()
+ * не вернет true
+ *
+ * @param
+ *  [in] a_frame - кадр
+ *
+ * @return
+ *  true  - кадр отправлен (неотправленный остаток будет дописан позже)
+ *  false - во время отправки произошла ошибка
+ */
+bool C_PosixTcpSocket::sendZeroCopy( const T_Frame &a_frame )
+{
+    m_wouldBlock = false;
+    if ( !m_zeroCopy && !m_zeroCopyOff ) {
+        int on = 1;
+        if ( setsockopt( m_acceptedSocket, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on) ) == 0 ) {
+            m_zeroCopy = true;
+        }
+        else {
+            g_log << name() << "SO_ZEROCOPY is not supported: " << lastError() << std::endl;
+            m_zeroCopyOff = true;
+        }
+    }
+    drainZeroCopy();
+    if ( !flushUnsent() ) {
+        return false;
+    }
+
+    iovec iov[2];
+    iov[0].iov_base = const_cast<char*>( a_frame.Head );
+    iov[0].iov_len  = a_frame.HeadSize;
+    iov[1].iov_base = const_cast<char*>( a_frame.Data );
+    iov[1].iov_len  = a_frame.Size;
+
+    msghdr msg = {};
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = 2;
+
+    bool zeroCopy = m_zeroCopy;
+    auto numBytes = ::sendmsg( m_acceptedSocket, &msg, MSG_NOSIGNAL | ( zeroCopy ? MSG_ZEROCOPY : 0 ) );
+    if ( numBytes < 0 && zeroCopy && errno == ENOBUFS ) {
+        zeroCopy = false;
+        numBytes = ::sendmsg( m_acceptedSocket, &msg, MSG_NOSIGNAL );
+    }
+
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+    if ( zeroCopy ) {
+        m_zcSent++;
+    }
+    if ( static_cast<size_t>(numBytes) != a_frame.HeadSize + a_frame.Size ) {
+        keepUnsent( iov, 2, static_cast<size_t>(numBytes) );
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Отправка части файла вызовом sendfile()
+ *
+ * @param
+ *  [in]     a_fd     - дескриптор файла, открытого на чтение
+ *  [in,out] a_offset - смещение первого неотправленного байта в файле
+ *  [in,out] a_count  - количество байтов, которое осталось отправить
+ *
+ * @return
+ *  true  - отправлена часть данных, a_offset и a_count сдвинуты
+ *  false - во время отправки произошла ошибка (wouldBlock() - буфер сокета заполнен)
+ */
+bool C_PosixTcpSocket::sendFile( int a_fd, uint64_t &a_offset, size_t &a_count )
+{
+    m_wouldBlock = false;
+    if ( !flushUnsent() ) {
+        return false;
+    }
+    off_t offset = static_cast<off_t>( a_offset );
+    auto numBytes = ::sendfile( m_acceptedSocket, a_fd, &offset, a_count );
+    if ( numBytes < 0 && ( errno == EINVAL || errno == ENOSYS ) ) {
+        return C_PosixSocket::sendFile( a_fd, a_offset, a_count );
+    }
+
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+    if ( numBytes == 0 ) {
+        g_log << name() << "sendFile: unexpected end of file" << std::endl;
+        return false;
+    }
+
+    a_offset += static_cast<uint64_t>( numBytes );
+    a_count  -= static_cast<size_t>( numBytes );
+    return true;
+}
+
+/*****************************************************************************
+ * Прием потока с записью в файл вызовами splice()
+ *
+ * Данные, перемещенные из сокета в канал, сразу же перемещаются из канала в файл,
+ * поэтому между вызовами канал всегда пуст. Неотправленный остаток потока
+ * (например, подтверждение потока) дописывается в сокет перед приемом
+ *
+ * @param
+ *  [in]     a_fd    - дескриптор файла, открытого на запись
+ *  [in,out] a_count - количество байтов, которое осталось принять
+ *
+ * @return
+ *  true  - часть данных принята и записана, a_count уменьшен
+ *  false - во время приема произошла ошибка (wouldBlock() - данных пока нет)
+ */
+bool C_PosixTcpSocket::recvFile( int a_fd, size_t &a_count )
+{
+    if ( !m_unsent.empty() ) {
+        flushUnsent();
+    }
+
+    m_wouldBlock = false;
+    if ( m_pipe[0] < 0 ) {
+        if ( ::pipe2( m_pipe, O_CLOEXEC | O_NONBLOCK ) < 0 ) {
+            g_log << name() << "pipe2: failed with error: " << lastError() << std::endl;
+            m_pipe[0] = m_pipe[1] = -1;
+            return C_PosixSocket::recvFile( a_fd, a_count );
+        }
+        // Емкость канала ограничивает объем данных одного вызова splice()
+        fcntl( m_pipe[1], F_SETPIPE_SZ, s_pipeSize );
+    }
+
+    auto numBytes = ::splice( m_acceptedSocket, nullptr, m_pipe[1], nullptr, a_count,
+                              SPLICE_F_MOVE | SPLICE_F_NONBLOCK );
+    if ( numBytes < 0 && errno == EINVAL ) {
+        return C_PosixSocket::recvFile( a_fd, a_count );
+    }
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+    if ( numBytes == 0 ) {
+        g_log << name() << "recvFile: connection closed" << std::endl;
+        return false;
+    }
+
+    for ( ssize_t written = 0; written < numBytes; ) {
+        auto numMoved = ::splice( m_pipe[0], nullptr, a_fd, nullptr,
+                                  static_cast<size_t>( numBytes - written ), SPLICE_F_MOVE );
+        if ( numMoved <= 0 ) {
+            if ( numMoved < 0 && errno == EINTR ) {
+                continue;
+            }
+            g_log << name() << "recvFile: splice to file failed: " << lastError() << std::endl;
+            return false;
+        }
+        written += numMoved;
+    }
+
+    a_count -= static_cast<size_t>( numBytes );
+    return true;
+}
+
+/*****************************************************************************
+ * Дозапись неотправленного остатка и ожидание завершения отправок без копирования
+ *
+ * @return
+ *  true  - остаток дописан, все отправки без копирования завершены
+ *  false - остаток не дописан или часть отправок еще не завершена
+ *          (wouldBlock() == true), либо произошла ошибка
+ */
+bool C_PosixTcpSocket::submit()
+{
+    m_wouldBlock = false;
+    drainZeroCopy();
+    if ( !flushUnsent() ) {
+        return false;
+    }
+    if ( m_zcDone != m_zcSent ) {
+        m_wouldBlock = true;
+        return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Вычитывание уведомлений о завершении отправок без копирования
+ *
+ * Чтение очереди ошибок сокета никогда не блокируется
+ */
+void C_PosixTcpSocket::drainZeroCopy()
+{
+    while ( m_zcDone != m_zcSent ) {
+        char control[ 128 ];
+        msghdr msg = {};
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+
+        if ( ::recvmsg( m_acceptedSocket, &msg, MSG_ERRQUEUE ) < 0 ) {
+            return;
+        }
+
+        for ( cmsghdr *cmsg = CMSG_FIRSTHDR( &msg ); cmsg; cmsg = CMSG_NXTHDR( &msg, cmsg ) ) {
+            bool isRecvErr = ( cmsg->cmsg_level == SOL_IP   && cmsg->cmsg_type == IP_RECVERR ) ||
+                             ( cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR );
+            if ( !isRecvErr ) {
+                continue;
+            }
+
+            sock_extended_err err;
+            memcpy( &err, CMSG_DATA( cmsg ), sizeof(err) );
+            if ( err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY ) {
+                continue;
+            }
+
+            m_zcDone += err.ee_data - err.ee_info + 1;
+            if ( ( err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED ) && m_zeroCopy ) {
+                g_log << name() << "zerocopy send was copied by kernel, using regular send" << std::endl;
+                m_zeroCopy    = false;
+                m_zeroCopyOff = true;
+            }
+        }
+    }
+}
+
+/*****************************************************************************
+ * Сохранение неотправленного остатка данных
+ *
+ * @param
+ *  [in] a_iov   - отправлявшиеся буферы
+ *  [in] a_count - количество буферов
+ *  [in] a_sent  - количество отправленных байтов
+ */
+void C_PosixTcpSocket::keepUnsent( const iovec *a_iov, size_t a_count, size_t a_sent )
+{
+    for ( size_t idx = 0; idx < a_count; idx++ ) {
+        const char *data = static_cast<const char*>( a_iov[idx].iov_base );
+        size_t skipped = std::min( a_sent, a_iov[idx].iov_len );
+        a_sent -= skipped;
+        m_unsent.insert( m_unsent.end(), data + skipped, data + a_iov[idx].iov_len );
+    }
+}
+
+/*****************************************************************************
+ * Дозапись неотправленного остатка в сокет
+ *
+ * @return
+ *  true  - остатка нет
+ *  false - остаток дописан не полностью (wouldBlock() == true), либо произошла ошибка
+ */
+bool C_PosixTcpSocket::flushUnsent()
+{
+    if ( m_unsent.empty() ) {
+        return true;
+    }
+    auto numBytes = ::send( m_acceptedSocket, m_unsent.data(), m_unsent.size(), MSG_NOSIGNAL );
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+    m_unsent.erase( m_unsent.begin(), m_unsent.begin() + numBytes );
+    if ( !m_unsent.empty() ) {
+        m_wouldBlock = true;
+        return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Установка соединения с сервером (если класс представляет клиентский сокет)
+ *
+ * В неблокирующем режиме первый вызов вернет EINPROGRESS, повторные вызовы -
+ * EALREADY до момента установления соединения и EISCONN после него
+ *
+ * @return
+ *  Статус успешности инициализации соединения
+ *  true  - соединение клиента с сервером установлено
+ *  false - во время установки соединения клиента с сервером произошла ошибка
+ */
+bool C_PosixTcpSocket::connectToServer()
+{
+    g_log << name() << "start connecting..." << std::endl;
+
+    m_wouldBlock = false;
+    int retVal = ::connect( m_masterSock,
+                            reinterpret_cast<sockaddr*>(&m_peerService),
+                            sizeof(m_peerService) );
+
+    if ( retVal == 0 || errno == EISCONN ) {
+        // Клиентский сокет является одновременно и рабочим сокетом (см. C_TcpSocket)
+        m_acceptedSocket = m_masterSock;
+
+        g_log << name() << "connection success" << std::endl;
+        return true;
+    }
+    updateWouldBlock();
+    return false;
+}
+
+/*****************************************************************************
+ * Установка соединения с клиентом (для серверного сокета)
+ *
+ * @return
+ *  Статус успешности инициализации соединения
+ *  true  - соединение сервера с клиентом установлено
+ *  false - во время установки соединения сервера с клиентом произошла ошибка
+ */
+bool C_PosixTcpSocket::connectToClient()
+{
+    if ( !m_isListening && !listen( m_backlog ) ) {
+        return false;
+    }
+    if ( !accept() ) {
+        return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Установка прослушивания входящих соединений
+ * (если класс представляет серверный сокет)
+ *
+ * @param
+ *  [in] backlog - количество возможных входящий соединений
+ *
+ * @return
+ *  Статус успешности начала прослушивания
+ */
+bool C_PosixTcpSocket::listen( int a_backlog )
+{
+    g_log << name() << "start listening" << std::endl;
+
+    if ( ::listen( m_masterSock, a_backlog ) < 0 ) {
+        g_log << name() << "listen() failed with error: " << lastError() << std::endl;
+        return false;
+    }
+
+    m_isListening = true;
+    g_log << name() << "listening mode on" << std::endl;
+    return true;
+}
+
+/*****************************************************************************
+ * Принятие соединения (если класс представляет серверный сокет)
+ *
+ * Рабочий сокет наследует режим слушающего сокета через флаг SOCK_NONBLOCK
+ *
+ * @return
+ *  Статус успешности принятия соединения
+ */
+bool C_PosixTcpSocket::accept()
+{
+    int flags = SOCK_CLOEXEC;
+    if ( m_mode == E_SocketMode::NonBlocking ) {
+        flags |= SOCK_NONBLOCK;
+    }
+
+    m_wouldBlock = false;
+    m_acceptedSocket = ::accept4( m_masterSock, nullptr, nullptr, flags );
+
+    if ( m_acceptedSocket < 0 ) {
+        updateWouldBlock();
+        if ( !m_wouldBlock ) {
+            g_log << name() << "accept failed with error: " << lastError() << std::endl;
+        }
+        return false;
+    }
+    else {
+        g_log << name() << "client accepted" << std::endl;
+        return true;
+    }
+}
+
+} // namespace network
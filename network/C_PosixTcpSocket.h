@@ -0,0 +1,170 @@
+/*****************************************************************************
+
+  C_PosixTcpSocket
+
+  Класс TCP-сокета, реализующий интерфейс I_Socket поверх системного API
+  сокетов ОС Linux
+
+  ОПИСАНИЕ
+
+  * TCP-сокет представляет собой сетевой интерфейс для взаимодействия по
+    TCP-протоколу
+
+  * Принятие соединения производится вызовом accept4(), благодаря чему
+    рабочий сокет сразу получает флаги SOCK_CLOEXEC и, при необходимости,
+    SOCK_NONBLOCK без дополнительных системных вызовов
+
+  * Функция sendZeroCopy() отправляет кадр флагом MSG_ZEROCOPY: ядро ссылается
+    на страницы буфера пользователя вместо копирования. Уведомления о завершении
+    таких отправок вычитываются из очереди ошибок сокета (MSG_ERRQUEUE) в
+    sendZeroCopy() и submit(); submit() возвращает true, только когда все
+    отправки без копирования завершены и буферы можно изменять. Счетчики
+    zeroCopySent()/zeroCopyDone() позволяют освобождать кадры по одному, по мере
+    завершения их отправок
+
+  * Частичная отправка не нарушает разметку потока (см. C_StreamCodec.h):
+    неотправленный остаток кадра копируется во внутренний буфер, кадр считается
+    отправленным, а остаток дописывается в сокет раньше любых новых данных.
+    Пока остаток не дописан, функции отправки и submit() возвращают false,
+    а wouldBlock() - true
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Использование объектов класса C_PosixTcpSocket равносильно работе с объектами,
+    реализующими интерфейс I_Socket (см. I_Socket)
+
+*****************************************************************************/
+
+#pragma once
+
+#include "C_PosixSocket.h"
+#include "C_Logger.h"
+
+#include <sys/uio.h>
+
+namespace network {
+
+using namespace services;
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Класс TCP-сокета, реализующий интерфейс I_Socket поверх системного API
+ * сокетов ОС Linux
+ */
+class C_PosixTcpSocket : public C_PosixSocket
+{
+
+public:
+
+    C_PosixTcpSocket() : C_PosixSocket( E_Protocol::TCP, "tcp socket" ) { }
+    virtual ~C_PosixTcpSocket() override;
+
+    /**
+     * Реализация интерфейса I_Socket
+     */
+
+    // Закрытие сокета
+    virtual void close() override;
+
+    /**
+     * Отправка и прием данных
+     */
+
+    virtual bool send( const std::vector<char> &a_buff ) override;
+    virtual bool recvInto( char *a_data, size_t a_capacity, size_t &a_received ) override;
+
+    // Инициализация соединения
+    virtual bool connect() override;
+
+    // Системный дескриптор рабочего сокета
+    virtual int handle() const override;
+
+    // Отправка кадров без склейки заголовка и данных (sendmsg())
+    virtual size_t sendFrames( const T_Frame *a_frames, size_t a_count ) override;
+    // Отправка кадра без копирования полезной нагрузки (MSG_ZEROCOPY)
+    virtual bool sendZeroCopy( const T_Frame &a_frame ) override;
+    // Ожидание завершения отправок без копирования
+    virtual bool submit() override;
+    // Количество отправок с MSG_ZEROCOPY
+    virtual uint32_t zeroCopySent() const override { return m_zcSent; }
+    // Количество завершенных отправок с MSG_ZEROCOPY
+    virtual uint32_t zeroCopyDone() const override { return m_zcDone; }
+
+    // Отправка части файла (sendfile())
+    virtual bool sendFile( int a_fd, uint64_t &a_offset, size_t &a_count ) override;
+    // Прием потока с записью в файл (splice())
+    virtual bool recvFile( int a_fd, size_t &a_count ) override;
+
+protected:
+
+    // Установка соединения с сервером (для клиентского сокета)
+    bool connectToServer();
+
+    // Установка соединения с клиентом (для серверного сокета)
+    bool connectToClient();
+
+private:
+
+    // Настройка дополнительных параметров сокета
+    virtual bool setSockOptions() override;
+
+    // Установка прослушивания входящих соединений
+    bool listen( int a_backlog );
+
+    // Принятие соединения
+    bool accept();
+
+    // Вычитывание уведомлений о завершении отправок без копирования
+    void drainZeroCopy();
+
+    // Сохранение неотправленного остатка данных a_iov после отправки a_sent байтов
+    void keepUnsent( const iovec *a_iov, size_t a_count, size_t a_sent );
+    // Дозапись неотправленного остатка в сокет
+    bool flushUnsent();
+
+protected:
+
+    int     m_acceptedSocket = -1;  // Файловый дескриптор сокета приема-отправки
+    int     m_backlog        = 5;   // Количество возможных соединений
+    bool    m_isListening    = false; // Признак перевода сокета в режим прослушивания
+
+    bool        m_zeroCopy      = false;    // Отправка без копирования включена (SO_ZEROCOPY)
+    bool        m_zeroCopyOff   = false;    // Отправка без копирования недоступна или невыгодна
+    uint32_t    m_zcSent        = 0;        // Количество отправок с MSG_ZEROCOPY
+    uint32_t    m_zcDone        = 0;        // Количество завершенных отправок с MSG_ZEROCOPY
+
+    int         m_pipe[2]       = { -1, -1 };   // Канал для приема в файл через splice()
+
+    std::vector<char> m_unsent;             // Неотправленный остаток потока
+
+private: // static
+
+    static const int s_pipeSize;            // Запрашиваемая емкость канала
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
@@ -0,0 +1,486 @@
+/*****************************************************************************
+
+  C_PosixUdpSocket
+
+  Класс UDP-сокета, реализующий интерфейс I_Socket поверх системного API
+  сокетов ОС Linux
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * C_PosixUdpSocket наследует C_PosixSocket, в котором распологается основной
+    функционал по работе с сокетами на уровне POSIX API (см. C_PosixSocket.h).
+
+  * Адрес отправителя последней принятой датаграммы запоминается в m_peerService,
+    поэтому серверный сокет отвечает тому клиенту, от которого пришел запрос.
+
+  * Заголовки сообщений для sendmmsg()/recvmmsg() хранятся в членах класса и
+    переиспользуются между вызовами, поэтому пакетный обмен не выделяет память.
+
+  * Поддержка UDP_SEGMENT проверяется вызовом getsockopt() при настройке сокета.
+    Если ядро все же отвергает сообщение с сегментацией (например, размер
+    сегмента превышает MTU интерфейса), сегментация отключается и неотправленные
+    датаграммы отправляются повторно по одной.
+
+  * При включенном UDP_GRO даже одиночный recvInto() выполняется через буфер
+    объединенного приема, иначе несколько объединенных ядром датаграмм были бы
+    приняты как одна.
+
+*****************************************************************************/
+
+#include "C_PosixUdpSocket.h"
+
+#include <sys/socket.h>
+#include <netinet/udp.h>
+#include <cerrno>
+#include <cstring>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const size_t C_PosixUdpSocket::s_maxBatch    = 64;          // Максимальное количество датаграмм за вызов
+const int    C_PosixUdpSocket::s_sockBufSize = 1024 * 1024; // Размер буферов сокета 1 megabyte
+const size_t C_PosixUdpSocket::s_maxGsoBytes = 65507;       // Максимальный размер полезной нагрузки UDP
+const size_t C_PosixUdpSocket::s_maxSegments = 64;          // Ограничение ядра UDP_MAX_SEGMENTS
+const size_t C_PosixUdpSocket::s_groBatch    = 8;           // Количество объединенных буферов за вызов
+const size_t C_PosixUdpSocket::s_groBufSize  = 64 * 1024;   // Размер объединенного буфера 64 kilobytes
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Отправка данных через сокет
+ *
+ * @param
+ *  [in] a_buff - ссылка на буфер, данные из которого отправляются по сокету
+ *
+ * @return
+ *  true  - датаграмма отправлена целиком
+ *  false - во время отправки произошла ошибка
+ */
+bool C_PosixUdpSocket::send( const std::vector<char> &a_buff )
+{
+    m_wouldBlock = false;
+    auto numBytes = ::sendto( m_masterSock,
+                              a_buff.data(),
+                              a_buff.size(),
+                              0,
+                              reinterpret_cast<const sockaddr*>(&m_peerService),
+                              sizeof(m_peerService) );
+
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+    return static_cast<size_t>(numBytes) == a_buff.size();
+}
+
+/*****************************************************************************
+ * Прием данных через сокет
+ *
+ * Датаграмма длиннее буфера усекается до его размера
+ *
+ * @param
+ *  [out] a_data     - буфер, в который помещаются принятые данные из сокета
+ *  [in]  a_capacity - размер буфера
+ *  [out] a_received - длина принятой датаграммы
+ *
+ * @return
+ *  true  - датаграмма успешно принята
+ *  false - во время приема произошла ошибка
+ */
+bool C_PosixUdpSocket::recvInto( char *a_data, size_t a_capacity, size_t &a_received )
+{
+    m_wouldBlock = false;
+    if ( m_gro ) {
+        return recvCoalesced( &a_data, &a_capacity, &a_received, 1 ) == 1;
+    }
+
+    socklen_t socketAddrSize = sizeof( m_peerService );
+
+    auto numBytes = ::recvfrom( m_masterSock,
+                                a_data,
+                                a_capacity,
+                                0,
+                                reinterpret_cast<sockaddr*>(&m_peerService),
+                                &socketAddrSize );
+
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        return false;
+    }
+    else if ( numBytes == 0 ) {
+        g_log << name() << "recv: connection closed" << std::endl;
+        return false;
+    }
+    else {
+        a_received = static_cast<size_t>( numBytes );
+        return true;
+    }
+}
+
+/*****************************************************************************
+ * Пакетная отправка датаграмм одним вызовом sendmmsg()
+ *
+ * @param
+ *  [in] a_buffs - буферы, каждый из которых отправляется отдельной датаграммой
+ *
+ * @return
+ *  - количество отправленных датаграмм
+ */
+size_t C_PosixUdpSocket::sendBatch( const std::vector<std::vector<char>> &a_buffs )
+{
+    m_wouldBlock = false;
+    size_t count = std::min( a_buffs.size(), s_maxBatch );
+    if ( count == 0 ) {
+        return 0;
+    }
+
+    prepareMessages( count );
+    for ( size_t idx = 0; idx < count; idx++ ) {
+        m_iovs[idx].iov_base = const_cast<char*>( a_buffs[idx].data() );
+        m_iovs[idx].iov_len  = a_buffs[idx].size();
+        m_dgramSizes[idx]    = a_buffs[idx].size();
+    }
+    return sendPrepared( count, 1 );
+}
+
+/*****************************************************************************
+ * Пакетная отправка кадров одним вызовом sendmmsg()
+ *
+ * Каждый кадр отправляется отдельной датаграммой из двух iovec: заголовка
+ * кадра и данных, на которые он ссылается
+ *
+ * @param
+ *  [in] a_frames - кадры
+ *  [in] a_count  - количество кадров
+ *
+ * @return
+ *  - количество отправленных кадров
+ */
+size_t C_PosixUdpSocket::sendFrames( const T_Frame *a_frames, size_t a_count )
+{
+    m_wouldBlock = false;
+    size_t count = std::min( a_count, s_maxBatch );
+    if ( count == 0 ) {
+        return 0;
+    }
+
+    prepareMessages( count, 2 );
+    for ( size_t idx = 0; idx < count; idx++ ) {
+        const T_Frame &frame = a_frames[idx];
+        m_iovs[ 2 * idx     ].iov_base = const_cast<char*>( frame.Head );
+        m_iovs[ 2 * idx     ].iov_len  = frame.HeadSize;
+        m_iovs[ 2 * idx + 1 ].iov_base = const_cast<char*>( frame.Data );
+        m_iovs[ 2 * idx + 1 ].iov_len  = frame.Size;
+        m_dgramSizes[idx] = frame.HeadSize + frame.Size;
+    }
+    return sendPrepared( count, 2 );
+}
+
+/*****************************************************************************
+ * Отправка подготовленных датаграмм одним вызовом sendmmsg()
+ *
+ * При поддержке UDP_SEGMENT подряд идущие датаграммы одинакового размера
+ * (последняя может быть короче) объединяются в одно сообщение: ядро делит
+ * данные сообщения на сегменты по размеру, а не по границам iovec
+ *
+ * @param
+ *  [in] a_count   - количество датаграмм (описания буферов - в m_iovs,
+ *                   размеры датаграмм - в m_dgramSizes)
+ *  [in] a_iovsPer - количество iovec на одну датаграмму
+ *
+ * @return
+ *  - количество отправленных датаграмм
+ */
+size_t C_PosixUdpSocket::sendPrepared( size_t a_count, size_t a_iovsPer )
+{
+    size_t numMsgs = 0;
+    for ( size_t idx = 0; idx < a_count; numMsgs++ ) {
+        size_t segSize = m_dgramSizes[idx];
+        size_t run     = 1;
+        size_t total   = segSize;
+        while ( m_gso && idx + run < a_count && run < s_maxSegments ) {
+            size_t size = m_dgramSizes[ idx + run ];
+            if ( size == 0 || size > segSize || total + size > s_maxGsoBytes ) {
+                break;
+            }
+            total += size;
+            run++;
+            if ( size < segSize ) {
+                break;
+            }
+        }
+
+        msghdr &hdr = m_msgs[numMsgs].msg_hdr;
+        hdr.msg_name    = &m_peerService;
+        hdr.msg_namelen = sizeof(m_peerService);
+        hdr.msg_iov     = &m_iovs[ idx * a_iovsPer ];
+        hdr.msg_iovlen  = run * a_iovsPer;
+        if ( run > 1 ) {
+            hdr.msg_control    = m_controls[numMsgs].Buf;
+            hdr.msg_controllen = CMSG_SPACE( sizeof(uint16_t) );
+            cmsghdr *cmsg = CMSG_FIRSTHDR( &hdr );
+            cmsg->cmsg_level = IPPROTO_UDP;
+            cmsg->cmsg_type  = UDP_SEGMENT;
+            cmsg->cmsg_len   = CMSG_LEN( sizeof(uint16_t) );
+            uint16_t gsoSize = static_cast<uint16_t>( segSize );
+            memcpy( CMSG_DATA( cmsg ), &gsoSize, sizeof(gsoSize) );
+        }
+        m_runs[numMsgs] = run;
+        idx += run;
+    }
+
+    int sentMsgs = ::sendmmsg( m_masterSock, m_msgs.data(), static_cast<unsigned>( numMsgs ), 0 );
+    if ( sentMsgs < 0 ) {
+        updateWouldBlock();
+        if ( !m_wouldBlock && m_runs[0] > 1 ) {
+            g_log << name() << "UDP_SEGMENT rejected (" << lastError()
+                    << "), sending datagrams one by one" << std::endl;
+            m_gso = false;
+            // Описания буферов сохраняются, сбрасываются только заголовки сообщений
+            prepareMessages( a_count, a_iovsPer );
+            return sendPrepared( a_count, a_iovsPer );
+        }
+        return 0;
+    }
+
+    size_t sent = 0;
+    for ( int msg = 0; msg < sentMsgs; msg++ ) {
+        sent += m_runs[msg];
+    }
+    return sent;
+}
+
+/*****************************************************************************
+ * Пакетный прием датаграмм одним вызовом recvmmsg()
+ *
+ * Вызов завершается после приема первой датаграммы (MSG_WAITFORONE), если
+ * остальные еще не поступили
+ *
+ * @param
+ *  [out] a_buffs - буферы, в которые помещаются принятые датаграммы
+ *  [out] a_sizes - длины принятых датаграмм
+ *
+ * @return
+ *  - количество принятых датаграмм
+ */
+size_t C_PosixUdpSocket::recvBatch( std::vector<std::vector<char>> &a_buffs, std::vector<size_t> &a_sizes )
+{
+    m_wouldBlock = false;
+    a_sizes.resize( a_buffs.size() );
+    size_t count = std::min( a_buffs.size(), s_maxBatch );
+    if ( count == 0 ) {
+        return 0;
+    }
+    if ( m_gro ) {
+        m_bufPtrs.resize( count );
+        m_bufSizes.resize( count );
+        for ( size_t idx = 0; idx < count; idx++ ) {
+            m_bufPtrs[idx]  = a_buffs[idx].data();
+            m_bufSizes[idx] = a_buffs[idx].size();
+        }
+        return recvCoalesced( m_bufPtrs.data(), m_bufSizes.data(), a_sizes.data(), count );
+    }
+
+    prepareMessages( count );
+    for ( size_t idx = 0; idx < count; idx++ ) {
+        m_iovs[idx].iov_base = a_buffs[idx].data();
+        m_iovs[idx].iov_len  = a_buffs[idx].size();
+        m_msgs[idx].msg_hdr.msg_name    = &m_addrs[idx];
+        m_msgs[idx].msg_hdr.msg_namelen = sizeof(m_addrs[idx]);
+    }
+
+    int numMsgs = ::recvmmsg( m_masterSock, m_msgs.data(), static_cast<unsigned>( count ),
+                              MSG_WAITFORONE, nullptr );
+    if ( numMsgs < 0 ) {
+        updateWouldBlock();
+        return 0;
+    }
+    else if ( numMsgs == 0 ) {
+        g_log << name() << "recv: connection closed" << std::endl;
+        return 0;
+    }
+
+    for ( int idx = 0; idx < numMsgs; idx++ ) {
+        a_sizes[idx] = m_msgs[idx].msg_len;
+    }
+    m_peerService = m_addrs[ numMsgs - 1 ];
+    return static_cast<size_t>( numMsgs );
+}
+
+/*****************************************************************************
+ * Прием объединенных датаграмм (UDP_GRO) в a_count буферов
+ *
+ * Новый прием выполняется только после выдачи всех ранее принятых датаграмм
+ *
+ * @param
+ *  [out] a_buffs      - буферы, в которые помещаются датаграммы
+ *  [in]  a_capacities - размеры буферов
+ *  [out] a_sizes      - длины датаграмм
+ *  [in]  a_count      - количество буферов
+ *
+ * @return
+ *  - количество заполненных буферов
+ */
+size_t C_PosixUdpSocket::recvCoalesced( char *const *a_buffs, const size_t *a_capacities,
+                                        size_t *a_sizes, size_t a_count )
+{
+    if ( m_segmentIdx < m_segments.size() ) {
+        return takeSegments( a_buffs, a_capacities, a_sizes, a_count );
+    }
+
+    m_groBuf.resize( s_groBatch * s_groBufSize );
+    prepareMessages( s_groBatch );
+    for ( size_t idx = 0; idx < s_groBatch; idx++ ) {
+        m_iovs[idx].iov_base = &m_groBuf[ idx * s_groBufSize ];
+        m_iovs[idx].iov_len  = s_groBufSize;
+        msghdr &hdr = m_msgs[idx].msg_hdr;
+        hdr.msg_name       = &m_addrs[idx];
+        hdr.msg_namelen    = sizeof(m_addrs[idx]);
+        hdr.msg_control    = m_controls[idx].Buf;
+        hdr.msg_controllen = sizeof(m_controls[idx].Buf);
+    }
+
+    int numMsgs = ::recvmmsg( m_masterSock, m_msgs.data(), static_cast<unsigned>( s_groBatch ),
+                              MSG_WAITFORONE, nullptr );
+    if ( numMsgs < 0 ) {
+        updateWouldBlock();
+        return 0;
+    }
+    else if ( numMsgs == 0 ) {
+        g_log << name() << "recv: connection closed" << std::endl;
+        return 0;
+    }
+
+    m_segments.clear();
+    m_segmentIdx = 0;
+    for ( int idx = 0; idx < numMsgs; idx++ ) {
+        size_t size    = m_msgs[idx].msg_len;
+        size_t segSize = size;
+        msghdr &hdr = m_msgs[idx].msg_hdr;
+        for ( cmsghdr *cmsg = CMSG_FIRSTHDR( &hdr ); cmsg; cmsg = CMSG_NXTHDR( &hdr, cmsg ) ) {
+            if ( cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO ) {
+                int gsoSize = 0;
+                memcpy( &gsoSize, CMSG_DATA( cmsg ), sizeof(gsoSize) );
+                if ( gsoSize > 0 ) {
+                    segSize = static_cast<size_t>( gsoSize );
+                }
+            }
+        }
+        // Датаграмма нулевой длины также выдается получателю
+        size_t offset = 0;
+        do {
+            m_segments.push_back( { idx * s_groBufSize + offset, std::min( segSize, size - offset ) } );
+            offset += segSize;
+        } while ( offset < size );
+    }
+    m_peerService = m_addrs[ numMsgs - 1 ];
+    return takeSegments( a_buffs, a_capacities, a_sizes, a_count );
+}
+
+/*****************************************************************************
+ * Выдача ранее принятых датаграмм из объединенных буферов
+ *
+ * Датаграмма длиннее буфера усекается до его размера
+ *
+ * @param
+ *  [out] a_buffs      - буферы, в которые копируются датаграммы
+ *  [in]  a_capacities - размеры буферов
+ *  [out] a_sizes      - длины скопированных датаграмм
+ *  [in]  a_count      - количество буферов
+ *
+ * @return
+ *  - количество заполненных буферов
+ */
+size_t C_PosixUdpSocket::takeSegments( char *const *a_buffs, const size_t *a_capacities,
+                                       size_t *a_sizes, size_t a_count )
+{
+    size_t filled = 0;
+    for ( ; filled < a_count && m_segmentIdx < m_segments.size(); filled++, m_segmentIdx++ ) {
+        const T_Segment &segment = m_segments[ m_segmentIdx ];
+        a_sizes[filled] = std::min( segment.Size, a_capacities[filled] );
+        memcpy( a_buffs[filled], &m_groBuf[ segment.Offset ], a_sizes[filled] );
+    }
+    return filled;
+}
+
+/*****************************************************************************
+ * Настройка дополнительных параметров сокета
+ *
+ * Буферы сокета увеличиваются, чтобы пачка датаграмм максимального размера,
+ * отправленная одним вызовом sendmmsg(), не отбрасывалась ядром на приеме.
+ * Ядро ограничивает размер значениями net.core.rmem_max/wmem_max, поэтому
+ * неудачная настройка не считается ошибкой
+ *
+ * @return
+ *  true - настройка сокета завершена
+ */
+bool C_PosixUdpSocket::setSockOptions()
+{
+    if ( setsockopt( m_masterSock, SOL_SOCKET, SO_RCVBUF, &s_sockBufSize, sizeof(s_sockBufSize) ) < 0 ||
+         setsockopt( m_masterSock, SOL_SOCKET, SO_SNDBUF, &s_sockBufSize, sizeof(s_sockBufSize) ) < 0 ) {
+        g_log << name() << "setsockopt() failed while configuring buffers: "
+                << lastError() << std::endl;
+    }
+
+    // Ядра без поддержки UDP_SEGMENT/UDP_GRO возвращают ENOPROTOOPT
+    int gsoSize = 0;
+    socklen_t optLen = sizeof(gsoSize);
+    m_gso = getsockopt( m_masterSock, IPPROTO_UDP, UDP_SEGMENT, &gsoSize, &optLen ) == 0;
+
+    int on = 1;
+    m_gro = setsockopt( m_masterSock, IPPROTO_UDP, UDP_GRO, &on, sizeof(on) ) == 0;
+
+    g_log << name() << "udp segmentation offload: " << ( m_gso ? "on" : "off" )
+            << ", receive coalescing: " << ( m_gro ? "on" : "off" ) << std::endl;
+    return true;
+}
+
+/*****************************************************************************
+ * Подготовка заголовков сообщений для a_count датаграмм
+ *
+ * @param
+ *  [in] a_count   - количество датаграмм
+ *  [in] a_iovsPer - количество iovec на одну датаграмму
+ */
+void C_PosixUdpSocket::prepareMessages( size_t a_count, size_t a_iovsPer )
+{
+    if ( m_msgs.size() < a_count ) {
+        m_msgs.resize      ( a_count );
+        m_addrs.resize     ( a_count );
+        m_controls.resize  ( a_count );
+        m_runs.resize      ( a_count );
+        m_dgramSizes.resize( a_count );
+    }
+    if ( m_iovs.size() < a_count * a_iovsPer ) {
+        m_iovs.resize( a_count * a_iovsPer );
+    }
+    for ( size_t idx = 0; idx < a_count; idx++ ) {
+        memset( &m_msgs[idx], 0, sizeof(m_msgs[idx]) );
+        m_msgs[idx].msg_hdr.msg_iov    = &m_iovs[ idx * a_iovsPer ];
+        m_msgs[idx].msg_hdr.msg_iovlen = a_iovsPer;
+    }
+}
+
+} // namespace network
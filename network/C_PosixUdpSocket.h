@@ -0,0 +1,150 @@
+/*****************************************************************************
+
+  C_PosixUdpSocket
+
+  Класс UDP-сокета, реализующий интерфейс I_Socket поверх системного API
+  сокетов ОС Linux
+
+
+  ОПИСАНИЕ
+
+  * UDP-сокет представляет собой сетевой интерфейс для взаимодействия по UDP
+
+  * Пакетные отправка и прием выполняются вызовами sendmmsg()/recvmmsg(),
+    перемещающими до s_maxBatch датаграмм за один системный вызов
+
+  * Если ядро поддерживает сегментацию UDP (UDP_SEGMENT, GSO), подряд идущие
+    датаграммы одинакового размера передаются ядру одним сообщением, которое
+    ядро разрезает на датаграммы. На приеме включается объединение датаграмм
+    (UDP_GRO): ядро возвращает несколько датаграмм одним буфером, который
+    сокет разрезает обратно на отдельные датаграммы. При отсутствии поддержки
+    обмен выполняется по одной датаграмме без изменения интерфейса
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Использование объектов класса C_PosixUdpSocket равносильно работе с объектами,
+    реализующими интерфейс I_Socket (см. I_Socket.h)
+
+*****************************************************************************/
+
+#pragma once
+
+#include "C_PosixSocket.h"
+#include "C_Logger.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+namespace network {
+
+using namespace services;
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Класс UDP-сокета, реализующий интерфейс I_Socket поверх системного API
+ * сокетов ОС Linux
+ */
+class C_PosixUdpSocket : public C_PosixSocket
+{
+
+public:
+
+    C_PosixUdpSocket() : C_PosixSocket( E_Protocol::UDP, "udp socket" ) { }
+    virtual ~C_PosixUdpSocket() override = default;
+
+    /**
+     * Отправка и прием данных
+     */
+
+    virtual bool send( const std::vector<char> &a_buff ) override;
+    virtual bool recvInto( char *a_data, size_t a_capacity, size_t &a_received ) override;
+
+    virtual size_t sendBatch( const std::vector<std::vector<char>> &a_buffs ) override;
+    virtual size_t sendFrames( const T_Frame *a_frames, size_t a_count ) override;
+    virtual size_t recvBatch(       std::vector<std::vector<char>> &a_buffs,
+                                    std::vector<size_t> &a_sizes ) override;
+
+    // Инициализация подключения (заглушка для UDP-протокола)
+    virtual bool connect() override { return true; }
+
+private:
+
+    // Настройка дополнительных параметров сокета
+    virtual bool setSockOptions() override;
+
+    // Подготовка заголовков сообщений для a_count датаграмм
+    void prepareMessages( size_t a_count, size_t a_iovsPer = 1 );
+    // Отправка подготовленных датаграмм
+    size_t sendPrepared( size_t a_count, size_t a_iovsPer );
+
+    // Прием объединенных датаграмм (UDP_GRO) в a_count буферов
+    size_t recvCoalesced( char *const *a_buffs, const size_t *a_capacities, size_t *a_sizes, size_t a_count );
+    // Выдача ранее принятых датаграмм из объединенных буферов
+    size_t takeSegments ( char *const *a_buffs, const size_t *a_capacities, size_t *a_sizes, size_t a_count );
+
+private: // types
+
+    // Буфер управляющего сообщения (UDP_SEGMENT/UDP_GRO)
+    struct T_Control {
+        alignas(cmsghdr) char Buf[ CMSG_SPACE( sizeof(int) ) ];
+    };
+
+    // Датаграмма внутри буфера объединенного приема
+    struct T_Segment {
+        size_t      Offset;                         // Смещение в m_groBuf
+        size_t      Size;                           // Размер датаграммы
+    };
+
+private:
+
+    std::vector<mmsghdr>        m_msgs;             // Заголовки сообщений sendmmsg()/recvmmsg()
+    std::vector<iovec>          m_iovs;             // Описания буферов датаграмм
+    std::vector<sockaddr_in>    m_addrs;            // Адреса отправителей принятых датаграмм
+    std::vector<T_Control>      m_controls;         // Управляющие сообщения
+    std::vector<size_t>         m_runs;             // Количество датаграмм в каждом сообщении отправки
+    std::vector<size_t>         m_dgramSizes;       // Размеры отправляемых датаграмм
+
+    bool                        m_gso = false;      // Сегментация на отправке поддерживается
+    bool                        m_gro = false;      // Объединение на приеме включено
+    std::vector<char>           m_groBuf;           // Буфер объединенного приема
+    std::vector<T_Segment>      m_segments;         // Принятые, но не выданные датаграммы
+    size_t                      m_segmentIdx = 0;   // Следующая выдаваемая датаграмма
+    std::vector<char*>          m_bufPtrs;          // Буферы пакетного приема с объединением
+    std::vector<size_t>         m_bufSizes;         // Размеры буферов пакетного приема с объединением
+
+private: // static
+
+    static const size_t         s_maxBatch;         // Максимальное количество датаграмм за вызов
+    static const int            s_sockBufSize;      // Запрашиваемый размер буферов сокета
+    static const size_t         s_maxGsoBytes;      // Максимальный размер сообщения с сегментацией
+    static const size_t         s_maxSegments;      // Максимальное количество сегментов в сообщении
+    static const size_t         s_groBatch;         // Количество объединенных буферов за вызов
+    static const size_t         s_groBufSize;       // Размер одного объединенного буфера
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} //namespace network
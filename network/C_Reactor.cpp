@@ -0,0 +1,330 @@
+/*****************************************************************************
+
+  C_Reactor
+
+  Реактор событий ввода-вывода на основе epoll (ОС Linux)
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Дескрипторы регистрируются в режиме EPOLLONESHOT, поэтому повторная
+    регистрация выполняется через EPOLL_CTL_MOD, а отмена - через EPOLL_CTL_DEL.
+
+  * Обработчик события перед вызовом копируется из таблицы, так как внутри него
+    сессия может перерегистрировать или снять с наблюдения свой дескриптор.
+
+  * Отмена таймера удаляет только его обработчик: запись в куче остается и
+    удаляется, когда оказывается на вершине кучи (при расчете таймаута или
+    извлечении), поэтому отмененный таймер не пробуждает реактор.
+
+  * Работой реактора считаются только взведенные дескрипторы (m_armed), активные
+    таймеры и отложенные обработчики. Дескриптор сессии, завершившейся без
+    detach(), остается зарегистрированным, но не взведенным, и не удерживает
+    цикл событий в epoll_wait().
+
+*****************************************************************************/
+
+#include "C_Reactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ostream>
+
+#include "C_Logger.h"
+
+namespace network {
+
+using namespace services;
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+static const int s_maxEvents = 64;      // Максимальное количество событий за один вызов epoll_wait()
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ */
+C_Reactor::C_Reactor()
+    : m_isRunning( false )
+{
+    m_epollFd = epoll_create1( EPOLL_CLOEXEC );
+    m_wakeFd  = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+
+    if ( m_epollFd < 0 || m_wakeFd < 0 ) {
+        g_log << "reactor: epoll/eventfd creation failed: " << errno << std::endl;
+        return;
+    }
+
+    epoll_event ev = {};
+    ev.events  = EPOLLIN;
+    ev.data.fd = m_wakeFd;
+    epoll_ctl( m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev );
+}
+
+/*****************************************************************************
+ * Деструктор
+ */
+C_Reactor::~C_Reactor()
+{
+    if ( m_wakeFd >= 0 ) {
+        ::close( m_wakeFd );
+    }
+    if ( m_epollFd >= 0 ) {
+        ::close( m_epollFd );
+    }
+}
+
+/*****************************************************************************
+ * Однократное ожидание готовности дескриптора на чтение или запись
+ *
+ * @param
+ *  [in] a_fd       - файловый дескриптор
+ *  [in] a_what     - E_Readiness::Read или E_Readiness::Write
+ *  [in] a_callback - обработчик, вызываемый при готовности дескриптора
+ *
+ * @return
+ *  true  - дескриптор зарегистрирован
+ *  false - ошибка регистрации дескриптора
+ */
+bool C_Reactor::watch( int a_fd, E_Readiness a_what, callback_t a_callback )
+{
+    if ( a_fd < 0 ) {
+        return false;
+    }
+
+    epoll_event ev = {};
+    ev.events  = EPOLLONESHOT | ( a_what == E_Readiness::Write ? EPOLLOUT : EPOLLIN );
+    ev.data.fd = a_fd;
+
+    bool isKnown = m_watches.count( a_fd ) != 0;
+    int rc = epoll_ctl( m_epollFd, isKnown ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, a_fd, &ev );
+    if ( rc < 0 ) {
+        g_log << "reactor: epoll_ctl failed for fd " << a_fd << ": " << errno << std::endl;
+        return false;
+    }
+
+    callback_t &watch = m_watches[ a_fd ];
+    if ( !watch ) {
+        m_armed++;
+    }
+    watch = std::move( a_callback );
+    return true;
+}
+
+/*****************************************************************************
+ * Снятие дескриптора с наблюдения
+ *
+ * Должно вызываться до закрытия дескриптора
+ *
+ * @param
+ *  [in] a_fd - файловый дескриптор
+ */
+void C_Reactor::unwatch( int a_fd )
+{
+    auto it = m_watches.find( a_fd );
+    if ( it == m_watches.end() ) {
+        return;
+    }
+    epoll_ctl( m_epollFd, EPOLL_CTL_DEL, a_fd, nullptr );
+    if ( it->second ) {
+        m_armed--;
+    }
+    m_watches.erase( it );
+}
+
+/*****************************************************************************
+ * Запуск таймера
+ *
+ * @param
+ *  [in] a_delay    - задержка до срабатывания таймера, мсек
+ *  [in] a_callback - обработчик, вызываемый при срабатывании таймера
+ *
+ * @return
+ *  - идентификатор таймера
+ */
+C_Reactor::timer_id_t C_Reactor::addTimer( std::chrono::milliseconds a_delay, callback_t a_callback )
+{
+    timer_id_t id = m_nextTimerId++;
+    m_timerQueue.push( { clock_t::now() + a_delay, id } );
+    m_timers[ id ] = std::move( a_callback );
+    return id;
+}
+
+/*****************************************************************************
+ * Отмена таймера
+ *
+ * @param
+ *  [in] a_id - идентификатор таймера
+ */
+void C_Reactor::cancelTimer( timer_id_t a_id )
+{
+    m_timers.erase( a_id );
+}
+
+/*****************************************************************************
+ * Передача обработчика на выполнение в поток реактора
+ *
+ * @param
+ *  [in] a_callback - обработчик
+ */
+void C_Reactor::post( callback_t a_callback )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_postMutex );
+        m_posted.push_back( std::move( a_callback ) );
+    }
+    std::uint64_t one = 1;
+    auto rc = ::write( m_wakeFd, &one, sizeof(one) );
+    (void)rc;
+}
+
+/*****************************************************************************
+ * Остановка цикла событий
+ */
+void C_Reactor::stop()
+{
+    m_isRunning = false;
+    std::uint64_t one = 1;
+    auto rc = ::write( m_wakeFd, &one, sizeof(one) );
+    (void)rc;
+}
+
+/*****************************************************************************
+ * Цикл событий
+ *
+ * Работает до тех пор, пока есть взведенные дескрипторы или активные таймеры,
+ * либо до вызова stop()
+ */
+void C_Reactor::run()
+{
+    if ( m_epollFd < 0 ) {
+        return;
+    }
+
+    epoll_event events[ s_maxEvents ];
+    m_isRunning = true;
+
+    while ( m_isRunning && hasWork() ) {
+        int count = epoll_wait( m_epollFd, events, s_maxEvents, nextTimeout() );
+        if ( count < 0 && errno != EINTR ) {
+            g_log << "reactor: epoll_wait failed: " << errno << std::endl;
+            break;
+        }
+
+        for ( int i = 0; i < count; i++ ) {
+            int fd = events[i].data.fd;
+            if ( fd == m_wakeFd ) {
+                std::uint64_t value;
+                auto rc = ::read( m_wakeFd, &value, sizeof(value) );
+                (void)rc;
+                continue;
+            }
+
+            auto it = m_watches.find( fd );
+            if ( it == m_watches.end() || !it->second ) {
+                continue;
+            }
+            // Дескриптор остается зарегистрированным, но не взведенным
+            callback_t callback = std::move( it->second );
+            it->second = nullptr;
+            m_armed--;
+            callback();
+        }
+
+        runPosted();
+        fireTimers();
+    }
+    m_isRunning = false;
+}
+
+/*****************************************************************************
+ * Наличие взведенных дескрипторов, активных таймеров или отложенных обработчиков
+ */
+bool C_Reactor::hasWork()
+{
+    std::lock_guard<std::mutex> lock( m_postMutex );
+    return m_armed != 0 || !m_timers.empty() || !m_posted.empty();
+}
+
+/*****************************************************************************
+ * Таймаут epoll_wait() до ближайшего активного таймера
+ *
+ * Записи отмененных таймеров с вершины кучи удаляются
+ *
+ * @return
+ *  -1 - активных таймеров нет, ожидание без ограничения по времени
+ *  >= 0 - время до срабатывания ближайшего таймера, мсек
+ */
+int C_Reactor::nextTimeout()
+{
+    while ( !m_timerQueue.empty() && m_timers.count( m_timerQueue.top().Id ) == 0 ) {
+        m_timerQueue.pop();
+    }
+    if ( m_timerQueue.empty() ) {
+        return -1;
+    }
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    m_timerQueue.top().Deadline - clock_t::now() ).count();
+    return left > 0 ? static_cast<int>( left ) : 0;
+}
+
+/*****************************************************************************
+ * Вызов обработчиков сработавших таймеров
+ */
+void C_Reactor::fireTimers()
+{
+    auto now = clock_t::now();
+    while ( !m_timerQueue.empty() && m_timerQueue.top().Deadline <= now ) {
+        timer_id_t id = m_timerQueue.top().Id;
+        m_timerQueue.pop();
+
+        auto it = m_timers.find( id );
+        if ( it == m_timers.end() ) {
+            // Таймер был отменен
+            continue;
+        }
+        callback_t callback = std::move( it->second );
+        m_timers.erase( it );
+        callback();
+    }
+}
+
+/*****************************************************************************
+ * Вызов обработчиков, переданных через post()
+ */
+void C_Reactor::runPosted()
+{
+    std::vector<callback_t> posted;
+    {
+        std::lock_guard<std::mutex> lock( m_postMutex );
+        posted.swap( m_posted );
+    }
+    for ( auto &callback : posted ) {
+        callback();
+    }
+}
+
+} // namespace network
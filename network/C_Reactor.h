@@ -0,0 +1,161 @@
+/*****************************************************************************
+
+  C_Reactor
+
+  Реактор событий ввода-вывода на основе epoll (ОС Linux)
+
+
+  ОПИСАНИЕ
+
+  * Реактор владеет ожиданием готовности файловых дескрипторов сокетов на чтение
+    или запись, а также таймерами. Вместо фиксированных задержек между неуспешными
+    итерациями машины состояний клиент и сервер регистрируют в реакторе то событие,
+    которого они ждут, и продолжают работу только по его наступлению.
+
+  * Ожидание готовности дескриптора однократное (EPOLLONESHOT): после вызова
+    обработчика дескриптор остается зарегистрированным, но не взведенным, до
+    следующего вызова watch().
+
+  * Таймеры хранятся в двоичной куче по времени срабатывания, ближайший таймер
+    задает таймаут вызова epoll_wait().
+
+  * Один поток реактора может обслуживать любое количество сессий клиентов и
+    серверов. Функции post() и stop() потокобезопасны и пробуждают реактор через eventfd.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Создание реактора и регистрация сессий:
+
+    C_Reactor reactor;
+    server.attach( reactor );
+    client.attach( reactor );
+
+  * Запуск цикла событий (возврат происходит, когда не осталось ни одного
+    взведенного дескриптора и активного таймера, либо после вызова stop()):
+
+    reactor.run();
+
+*****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "common_types.h"
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Реактор событий ввода-вывода на основе epoll
+ */
+class C_Reactor
+{
+
+public: // types
+
+    using callback_t = std::function<void()>;           // Обработчик события
+    using timer_id_t = std::uint64_t;                   // Идентификатор таймера
+    using clock_t    = std::chrono::steady_clock;       // Часы таймеров
+
+public:
+
+    C_Reactor();
+    ~C_Reactor();
+
+    C_Reactor( const C_Reactor&  ) = delete;
+    C_Reactor(       C_Reactor&& ) = delete;
+    C_Reactor & operator = ( const C_Reactor&  ) = delete;
+    C_Reactor & operator = (       C_Reactor&& ) = delete;
+
+    // Однократное ожидание готовности дескриптора на чтение или запись
+    bool watch( int a_fd, E_Readiness a_what, callback_t a_callback );
+    // Снятие дескриптора с наблюдения
+    void unwatch( int a_fd );
+
+    // Запуск таймера
+    timer_id_t addTimer( std::chrono::milliseconds a_delay, callback_t a_callback );
+    // Отмена таймера
+    void cancelTimer( timer_id_t a_id );
+
+    // Передача обработчика на выполнение в поток реактора (потокобезопасно)
+    void post( callback_t a_callback );
+
+    // Цикл событий
+    void run();
+    // Остановка цикла событий (потокобезопасно)
+    void stop();
+
+private:
+
+    // Наличие взведенных дескрипторов, активных таймеров или отложенных обработчиков
+    bool hasWork();
+    // Таймаут epoll_wait() до ближайшего активного таймера, мсек
+    int nextTimeout();
+    // Вызов обработчиков сработавших таймеров
+    void fireTimers();
+    // Вызов обработчиков, переданных через post()
+    void runPosted();
+
+private: // types
+
+    // Элемент кучи таймеров
+    struct T_TimerEntry {
+        clock_t::time_point Deadline;                   // Время срабатывания
+        timer_id_t          Id;                         // Идентификатор таймера
+
+        bool operator > ( const T_TimerEntry &a_other ) const {
+            return Deadline > a_other.Deadline;
+        }
+    };
+
+private:
+
+    int                                         m_epollFd = -1;     // Дескриптор epoll
+    int                                         m_wakeFd  = -1;     // Дескриптор eventfd для пробуждения
+    std::atomic<bool>                           m_isRunning;        // Флаг работы цикла событий
+    std::unordered_map<int, callback_t>         m_watches;          // Обработчики готовности дескрипторов
+    std::size_t                                 m_armed = 0;        // Количество взведенных дескрипторов
+    std::priority_queue< T_TimerEntry,
+                         std::vector<T_TimerEntry>,
+                         std::greater<T_TimerEntry> > m_timerQueue; // Куча таймеров
+    std::map<timer_id_t, callback_t>            m_timers;           // Обработчики активных таймеров
+    timer_id_t                                  m_nextTimerId = 1;  // Идентификатор следующего таймера
+    std::mutex                                  m_postMutex;        // Мьютекс очереди отложенных обработчиков
+    std::vector<callback_t>                     m_posted;           // Очередь отложенных обработчиков
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
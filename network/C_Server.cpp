@@ -22,11 +22,20 @@
   * Ответ на запрос клиента "отправь данные" формируется из  файла, который
     индексируется анализатором потока (C_StreamAnalyzer.h). Индексация файла заключается в нахождении
     байтовых границ каждого пакета, включая заголовок. Границы определяются парами итераторов на начало
-    и конец пакета.
+    и конец пакета. При загрузке размечаются только первые пакеты, остальные - по мере отправки,
+    поэтому передача большого файла начинается без полного прохода по нему. Полностью рассчитанный
+    индекс сохраняется при закрытии сессии в файл *.mes.idx и загружается из него при следующих
+    сессиях (C_IndexFile.h).
 
   * Для UDP протокола реализован отдельный протокол установления сеанса соединения для того, чтобы
     можно было удостовериться, что соединение с клиентом установлено.
 
+  * Функция step() выполняет один шаг машины состояний и возвращает событие, которого
+    необходимо дождаться перед следующим шагом: готовность сокета на чтение/запись или
+    таймер (например, время отправки следующего пакета). В ОС Linux ожидание выполняет
+    реактор на основе epoll (C_Reactor.h), поэтому задержка ответа на запрос клиента не
+    ограничена снизу периодом опроса сокета.
+
   * Каждый принятый пакет данных от клиента парсится с помощью функции
     parseComand(packet) для того, чтобы распознать команду, отправленную клиентом.
 
@@ -38,8 +47,15 @@
 #include <thread>
 #include <functional>
 #include <chrono>
+#include <algorithm>
+#include <iterator>
 
+#include "C_FileCache.h"
 #include "C_SocketFactory.h"
+#ifdef __linux__
+#include "C_Reactor.h"
+#include "C_WindowedStreamAnalyzer.h"
+#endif
 
 namespace network {
 
@@ -63,7 +79,9 @@ namespace network {
   Variables Definitions
 *****************************************************************************/
 
-const size_t C_Server::s_bufSize = 8 * 1024;   // Размер буфера приема/отправки 8 kilobytes
+const size_t C_Server::s_bufSize   = 8 * 1024;  // Размер буфера приема/отправки 8 kilobytes
+const size_t C_Server::s_batchSize = 32;        // Количество пакетов в одной отправке
+const size_t C_Server::s_prewarmSize = 4 * 1024 * 1024;    // 4 megabytes
 
 /*****************************************************************************
   Functions Definitions
@@ -79,6 +97,7 @@ C_Server::C_Server( std::string a_logLabel,
                     std::string a_filePath,
                     E_Protocol a_protoType )
                   : m_buffer   ( s_bufSize         ),
+                    m_codec    ( s_bufSize         ),
                     m_name     ( a_logLabel + ": " ),
                     m_authority( a_authority       ),
                     m_protoType( a_protoType       ),
@@ -95,127 +114,410 @@ C_Server::C_Server( std::string a_logLabel,
 void C_Server::stop()
 {
     isRunning = false;
+#ifdef __linux__
+    // Пробуждение реактора для завершения работы сервера в его потоке. Реактор не
+    // может быть уничтожен, пока захвачен мьютекс: detach() ожидает его освобождения
+    std::lock_guard<std::mutex> lock( m_reactorMutex );
+    C_Reactor *reactor = m_reactor;
+    if ( reactor ) {
+        reactor->post( [this](){ resume(); } );
+    }
+#endif
 }
 
 /*****************************************************************************
  * Главный цикл-обработчик сервера
+ *
+ * В ОС Linux сервер обслуживается собственным реактором событий, в остальных
+ * системах - циклом с ожиданием между неуспешными шагами машины состояний
  */
 void C_Server::work()
+{
+#ifdef __linux__
+    C_Reactor reactor;
+    attach( reactor );
+    reactor.run();
+    // Реактор уничтожается при выходе из функции, stop() не должен к нему обращаться
+    detach();
+#else
+    reset();
+    while ( m_state != E_States::Closed ) {
+        if ( !isRunning ) {
+            close();
+            break;
+        }
+        T_Wait wait = step();
+        if ( wait.What != E_Readiness::None ) {
+            sleep( wait.Timeout );
+        }
+    }
+#endif
+}
+
+/*****************************************************************************
+ * Начальное состояние машины состояний сервера
+ */
+void C_Server::reset()
+{
+    using namespace std::chrono_literals;
+
+    m_state            = E_States::Setup;
+    m_conState         = E_ConnectionStates::WaitReqt;
+    m_packetIdx        = 0;
+    m_previousTime     = 0ms;
+    m_nextSendTime     = std::chrono::steady_clock::time_point();
+    m_headerIsSent     = false;
+    m_bulkHeaderIsSent = false;
+    m_bulkOffset       = 0;
+    m_bulkRemaining    = 0;
+    m_sendCounter      = 0;
+    m_approveCount     = 0;
+    m_window           = 0;
+    m_credit           = 0;
+    isRunning          = true;
+    m_codec.reset();
+}
+
+/*****************************************************************************
+ * Шаг машины состояний сервера
+ *
+ * @return
+ *  - событие, которое необходимо дождаться перед следующим шагом
+ *    (E_Readiness::None - следующий шаг можно выполнять сразу)
+ */
+T_Wait C_Server::step()
 {
     using namespace std::chrono_literals;
 
-    E_States state     = E_States::Setup;   // Текущее состояние стейт-машины
-    E_States prevState = E_States::Setup;   // Предыдущее состояние стейт-машины
+    T_Wait wait;
+
+    switch ( m_state ) {
+
+        case E_States::Setup:
+            if ( !m_prewarmStarted ) {
+                startPrewarm();
+            }
+            if ( setup() ) {
+                m_state = E_States::Connect;
+            }
+            else {
+                g_log << m_name + "socket setup error: " << errno << std::endl;
+                wait = { E_Readiness::Timer, 1000ms };
+            }
+            break;
 
-    unsigned long             packetIdx    = 0;
-    std::chrono::milliseconds sleepTime    = 1000ms;    // Время ожидания между двумя неуспешными операциями, мсек
-    std::chrono::milliseconds previousTime = 0ms;       // Предыдущее время ожидания между итерациями цикла событий машины состояний
+        case E_States::Connect:
+            if ( connect() ) {
+                m_state = ( m_protoType == E_Protocol::UDP ) ? E_States::Handshake
+                                                             : E_States::RecvPacket;
+            }
+            else {
+                // Ожидание входящего соединения на слушающем сокете
+                wait = { m_handle->wouldBlock() ? E_Readiness::Read : E_Readiness::Timer, 1000ms };
+            }
+            break;
 
-    isRunning = true;
-    bool headerIsSent = false;
+        case E_States::Handshake:
+            if ( udpConStep( wait ) ) {
+                g_log << m_name << "connected to udp client" << std::endl;
+                m_state = E_States::RecvPacket;
+            }
+            break;
 
-    while (isRunning) {
-        prevState = state;
-        switch ( state ) {
+        case E_States::RecvPacket:
+            if ( recvPacket() ) {
+                m_state = E_States::ParsePacket;
+            }
+            else if ( m_codec.isBroken() ) {
+                // Длина кадра недопустима, границы следующих кадров неизвестны
+                g_log << m_name << "tcp stream framing is broken" << std::endl;
+                close();
+            }
+            else {
+                wait = { m_handle->wouldBlock() ? E_Readiness::Read : E_Readiness::Timer, 10ms };
+            }
+            break;
 
-            case E_States::Setup:
-                sleepTime = 1000ms;
-                if ( setup() ) {
-                    state = E_States::Connect;
+        case E_States::ParsePacket:
+            if ( parseComand() == Comand::Data ) {
+                takeCredit();
+                if ( !m_headerIsSent ) {
+                    m_state = E_States::LoadFile;
                 }
                 else {
-                    g_log << m_name + "socket setup error: " << errno << std::endl;
+                    m_state = ( m_fileFd < 0 )      ? E_States::SendPacket
+                            : m_bulkHeaderIsSent ? E_States::SendFile
+                                                 : E_States::SendBulkHeader;
                 }
-                break;
+            }
+            else {
+                m_state = E_States::RecvPacket;
+            }
+            break;
 
-            case E_States::Connect:
-                sleepTime = 1000ms;
-                if ( connect() ) {
-                    state = E_States::RecvPacket;
-                }
-                break;
+        case E_States::LoadFile:
+            loadFile(m_filePath);
+            m_streamFilter = !m_streams.empty() || m_streamProto != E_StreamProto::Unknown;
+            if ( m_packetProvider && m_streamFilter ) {
+                selectStreams();
+            }
+            if ( m_packetProvider && m_startTime > 0ms ) {
+                seekStartTime();
+            }
+            if ( m_packetProvider && m_packetIdx < replayCount() ) {
+                m_packetProvider->setCursor( packetNo( m_packetIdx ) );
+            }
+            if ( m_bulk ) {
+                openBulk();
+            }
+            m_state = E_States::SendHeader;
+            break;
 
-            case E_States::RecvPacket:
-                sleepTime = 10ms;
-                if ( recvPacket() ) {
-                    state = E_States::ParsePacket;
+        case E_States::SendHeader: {
+            auto headIters = m_packetProvider->headerRange();
+            if ( sendPacket( Comand::Data, headIters.first,
+                             static_cast<size_t>( headIters.second - headIters.first ) ) ) {
+                // Заголовок передается ядру вместе с приемом следующего запроса
+                m_headerIsSent = true;
+                m_state = E_States::RecvPacket;
+            }
+            else {
+                wait = { m_handle->wouldBlock() ? E_Readiness::Write : E_Readiness::Timer, 10ms };
+            }
+        } break;
+
+        case E_States::SendPacket: {
+            // Передача завершается и на первом поврежденном пакете файла
+            if ( m_packetIdx < replayCount() &&
+                 m_packetProvider->getPacket( packetNo( m_packetIdx ) ) ) {
+                if ( m_window != 0 && !recvCredit() ) {
+                    if ( m_codec.isBroken() ) {
+                        g_log << m_name << "tcp stream framing is broken" << std::endl;
+                        close();
+                        break;
+                    }
+                    // Окно клиента исчерпано, отправка продолжится после выдачи кредитов
+                    wait = { m_handle->wouldBlock() ? E_Readiness::Read : E_Readiness::Timer, 10ms };
+                    break;
                 }
-                break;
-
-            case E_States::ParsePacket:
-                if ( parseComand() == Comand::Data ) {
-                    if ( !headerIsSent ) {
-                        state = E_States::LoadFile;
+                std::chrono::milliseconds sleepTime = 10ms;
+                if ( !sendDuePackets( sleepTime ) ) {
+                    if ( m_handle->wouldBlock() ) {
+                        // Буфер сокета заполнен, пакет будет отправлен повторно
+                        wait = { E_Readiness::Write, 10ms };
                         break;
                     }
-                    state = E_States::SendPacket;
+                    g_log << m_name << "packet at index " << m_packetIdx << " is not sent" << std::endl;
+                    m_state = E_States::RecvPacket;
                     break;
                 }
-                else {
-                    state = E_States::RecvPacket;
+                // Передача ядру отложенных отправок (см. I_Socket::submit())
+                if ( !m_handle->submit() && !m_handle->wouldBlock() ) {
+                    g_log << m_name << "packets before index " << m_packetIdx << " are not sent" << std::endl;
+                    m_state = E_States::RecvPacket;
+                    break;
+                }
+                releaseZeroCopyFrames();
+                // Ожидание времени отправки следующего пакета
+                wait = { E_Readiness::Timer, sleepTime };
+            }
+            else {
+               m_state = E_States::Finish;
+            }
+        } break;
+
+        case E_States::SendBulkHeader: {
+            // Длина потока в порядке байтов big-endian, как и заголовок кадра
+            char length[ sizeof(std::uint64_t) ];
+            std::uint64_t value = m_bulkRemaining;
+            for ( size_t idx = sizeof(length); idx > 0; idx--, value >>= 8 ) {
+                length[ idx - 1 ] = static_cast<char>( value & 0xFF );
+            }
+            if ( sendPacket( Comand::Bulk, length, sizeof(length) ) ) {
+                // Поток начинается после подтверждения клиента, чтобы кадр
+                // Header::BulkResp не был принят вместе с данными потока
+                m_bulkHeaderIsSent = true;
+                m_state = E_States::RecvPacket;
+            }
+            else {
+                wait = { m_handle->wouldBlock() ? E_Readiness::Write : E_Readiness::Timer, 10ms };
+            }
+        } break;
+
+        case E_States::SendFile:
+            if ( m_bulkRemaining == 0 ) {
+                closeFileDescriptor( m_fileFd );
+                m_state = E_States::Finish;
+            }
+            else if ( !m_handle->sendFile( m_fileFd, m_bulkOffset, m_bulkRemaining ) ) {
+                if ( m_handle->wouldBlock() ) {
+                    // Буфер сокета заполнен
+                    wait = { E_Readiness::Write, 10ms };
                     break;
                 }
+                // Поток прерван, продолжение передачи невозможно
+                g_log << m_name << "file stream is broken at offset " << m_bulkOffset << std::endl;
+                close();
+            }
+            break;
+
+        case E_States::Finish:
+            if ( sendPacket( Comand::Finish ) ) {
+                // Кадр передается ядру в состоянии Closing
+                m_state = E_States::Closing;
+                wait = { E_Readiness::Timer, 50ms };
+            }
+            else {
+                wait = { m_handle->wouldBlock() ? E_Readiness::Write : E_Readiness::Timer, 10ms };
+            }
+            break;
 
-            case E_States::LoadFile:
-                loadFile(m_filePath);
-                state = E_States::SendHeader;
+        case E_States::Closing:
+            // Дозапись данных, которые не удалось отправить без блокировки, и ожидание
+            // завершения отправок без копирования. Уведомления о завершении приходят
+            // в очередь ошибок сокета и не делают его готовым на запись, поэтому в
+            // режиме без копирования submit() повторяется по таймеру
+            if ( !m_handle->submit() && m_handle->wouldBlock() ) {
+                wait = { m_zeroCopy ? E_Readiness::Timer : E_Readiness::Write, 10ms };
                 break;
+            }
+            g_log << m_name << m_filePath << " file is sent!\n";
+            g_log << m_name + m_handle->name() + " " << "stopped" << std::endl;
+            close();
+            break;
 
-            case E_States::SendHeader: {
-                sleepTime = 10ms;
-                auto headIters = m_packetProvider->headerRange();
-                if ( sendPacket( Comand::Data, { headIters.first, headIters.second } ) ) {
-                    headerIsSent = true;
-                    state = E_States::RecvPacket;
-                }
-            } break;
-
-            case E_States::SendPacket: {
-                sleepTime = 10ms;
-                if ( packetIdx < m_packetProvider->packetCount() ) {
-                    if ( !processPacket( packetIdx, previousTime, sleepTime ) ) {
-                        g_log << m_name << "packet at index " << packetIdx << " is not sent" << std::endl;
-                        state = E_States::RecvPacket;
-                        break;
-                    }
-                }
-                else {
-                   state = E_States::Finish;
-                }
-            } break;
-
-            case E_States::Finish:
-                if ( sendPacket( Comand::Finish ) ) {
-                    sleep( 50ms );
-                    g_log << m_name << m_filePath << " file is sent!\n";
-                    g_log << m_name + m_handle->name() + " " << "stopped" << std::endl;
-                    close();
-                    return;
-                }
+        case E_States::Closed:
+            break;
+    }
+    return wait;
+}
+
+#ifdef __linux__
+
+/*****************************************************************************
+ * Подключение сервера к реактору событий
+ *
+ * Первый шаг машины состояний будет выполнен в потоке реактора
+ *
+ * @param
+ *  [in] a_reactor - реактор, который будет обслуживать сервер
+ */
+void C_Server::attach( C_Reactor &a_reactor )
+{
+    reset();
+    m_reactor = &a_reactor;
+    a_reactor.post( [this](){ resume(); } );
+}
+
+/*****************************************************************************
+ * Продолжение работы машины состояний по событию реактора
+ *
+ * Шаги выполняются до тех пор, пока машине состояний не потребуется дождаться
+ * готовности сокета или таймера
+ */
+void C_Server::resume()
+{
+    C_Reactor *reactor = m_reactor;
+    if ( !reactor ) {
+        return;
+    }
+    if ( m_timerId ) {
+        reactor->cancelTimer( m_timerId );
+        m_timerId = 0;
+    }
+
+    while ( m_state != E_States::Closed ) {
+        if ( !isRunning ) {
+            close();
+            return;
         }
-        if ( state == prevState ) {
-            sleep( sleepTime );
+        T_Wait wait = step();
+        if ( wait.What != E_Readiness::None && m_state != E_States::Closed ) {
+            arm( wait );
+            return;
         }
     }
-    close();
-    return;
 }
 
+/*****************************************************************************
+ * Регистрация в реакторе ожидаемого машиной состояний события
+ *
+ * @param
+ *  [in] a_wait - ожидаемое событие
+ */
+void C_Server::arm( const T_Wait &a_wait )
+{
+    C_Reactor *reactor = m_reactor;
+    int fd = m_handle ? m_handle->handle() : -1;
+
+    // Рабочий дескриптор меняется после принятия TCP соединения
+    if ( m_watchedFd >= 0 && m_watchedFd != fd ) {
+        reactor->unwatch( m_watchedFd );
+        m_watchedFd = -1;
+    }
+
+    if ( a_wait.What == E_Readiness::Read || a_wait.What == E_Readiness::Write ) {
+        if ( reactor->watch( fd, a_wait.What, [this](){ resume(); } ) ) {
+            m_watchedFd = fd;
+            return;
+        }
+    }
+    m_timerId = reactor->addTimer( a_wait.Timeout, [this](){ m_timerId = 0; resume(); } );
+}
+
+/*****************************************************************************
+ * Отключение сервера от реактора событий
+ */
+void C_Server::detach()
+{
+    C_Reactor *reactor = nullptr;
+    {
+        std::lock_guard<std::mutex> lock( m_reactorMutex );
+        reactor = m_reactor.exchange( nullptr );
+    }
+    if ( !reactor ) {
+        return;
+    }
+    if ( m_watchedFd >= 0 ) {
+        reactor->unwatch( m_watchedFd );
+        m_watchedFd = -1;
+    }
+    if ( m_timerId ) {
+        reactor->cancelTimer( m_timerId );
+        m_timerId = 0;
+    }
+}
+
+#endif
+
 /*****************************************************************************
  * Завершение работы сервера
  */
 void C_Server::close()
 {
-    if ( m_file.is_open() ) {
-        m_file.close();
-    }
+#ifdef __linux__
+    // Снятие сокета с наблюдения до его закрытия
+    detach();
+#endif
+    m_state = E_States::Closed;
+
+    closeFileDescriptor( m_fileFd );
+    m_zcFrames.clear();
+    // Загрузка файлов, запущенная при старте, продолжается в кэше без ожидания
+    m_prewarmStarted = false;
 
     // Закрытие сокета и его удаление
-    m_handle->close();
-    m_handle.reset();
+    if ( m_handle ) {
+        m_handle->close();
+        m_handle.reset();
+    }
     // Очистка входного буфера
     m_buffer.clear();
-    // Удаление парсера файлов
+    m_codec.reset();
+    // Сохранение индекса, полностью рассчитанного за время сессии, и освобождение парсера файлов
+    if ( m_packetProvider && m_packetProvider->saveIndex( m_filePath ) ) {
+        g_log << m_name << "index saved to " << C_IndexFile::pathFor( m_filePath ) << std::endl;
+    }
     m_packetProvider.reset();
     g_log << m_name << "deinitialized" << std::endl;
     // Запустить остановку потока сервера
@@ -233,7 +535,7 @@ void C_Server::close()
 bool C_Server::setup()
 {
     if ( !m_handle ) {
-        m_handle = C_SocketFactory::createSocket( m_protoType );
+        m_handle = C_SocketFactory::createSocket( m_protoType, m_backend );
     }
     else {
         errno = enSockAlreadyCreated;
@@ -279,81 +581,76 @@ bool C_Server::connect()
     }
     if ( m_handle->connect() ) {
         g_log << m_name << "establishing connection with client..." << std::endl;
-
-        if ( m_protoType == E_Protocol::UDP ) {
-            udpConHandler();
-            g_log << m_name << "connected to udp client" << std::endl;
-        }
         return true;
     }
 
-    g_log << m_name << "error with opening connection" << std::endl;
+    if ( !m_handle->wouldBlock() ) {
+        g_log << m_name << "error with opening connection" << std::endl;
+    }
     return false;
 }
 
 /*****************************************************************************
- * Проведение процедуры "handshake" с клиентом по UDP протоколу
+ * Шаг процедуры "handshake" с клиентом по UDP протоколу
+ *
+ * @param
+ *  [out] a_wait - событие, которое необходимо дождаться, если шаг не продвинул процедуру
  *
- * Функция синхронная, не передаст управление, пока не будет завершена процедура
+ * @return
+ *  true  - соединение с клиентом установлено
+ *  false - процедура не завершена
  */
-void C_Server::udpConHandler()
+bool C_Server::udpConStep( T_Wait &a_wait )
 {
     using namespace std::chrono_literals;
-    bool isConnected = false;                                       // Статус флаг цикла
-    E_ConnectionStates state = E_ConnectionStates::WaitReqt;        // Текущее состояние стейт-машины
-    E_ConnectionStates prevState = E_ConnectionStates::WaitReqt;    // Предыдущее состояние стейт-машины
     std::chrono::milliseconds timeout = 100ms;                      // Время ожидания между запросами подтверждения, мсек
-    unsigned char sendCounter  = 0;                                 // Счетчик отправленных пакетов с эхо-запросом
-    unsigned char approveCount = 0;                                 // Счетчик полученных пакетов с эхо-ответом
-
-    while( !isConnected ) {
-        prevState = state;
-        switch (state) {
-            // Ожидание эхо-запроса
-            case E_ConnectionStates::WaitReqt: {
-                m_buffer.clear();
-                m_buffer.resize(s_bufSize);
-                if( m_handle->recv(m_buffer) ) {
-                    // Десериализация пакета из массива принятых байтов
-                    T_NetPacket packet = deserialize(m_buffer);
-                    if( packet.Head == Header::EchoReqt ){
-                        state = E_ConnectionStates::EchoResp;
-                        approveCount = packet.Data.front();
-                    }
-                }
-            } break;
-            // Отправка эхо-ответа
-            case E_ConnectionStates::EchoResp: {
-                // Формирование пакета эхо-ответа
-                T_NetPacket packet;
-                packet.Head = Header::EchoResp;
-                if ( m_handle->send( serialize(packet) ) ) {
-                    sendCounter++;
-                    state = E_ConnectionStates::VerifyStatus;
+
+    switch ( m_conState ) {
+        // Ожидание эхо-запроса
+        case E_ConnectionStates::WaitReqt: {
+            m_buffer.resize(s_bufSize);
+            if( m_handle->recvInto( m_buffer.data(), m_buffer.size(), m_recvSize ) ) {
+                // Разбор пакета в массиве принятых байтов
+                T_NetPacketView packet = deserializeView( m_buffer.data(), m_recvSize );
+                if( packet.Head == Header::EchoReqt && packet.Size != 0 ){
+                    m_conState = E_ConnectionStates::EchoResp;
+                    m_approveCount = packet.Data[0];
+                    break;
                 }
-            } break;
-            // Проверка условия установления соединения
-            case E_ConnectionStates::VerifyStatus:
-                    state = sendCounter < approveCount ? E_ConnectionStates::WaitReqt
-                                                       : E_ConnectionStates::Connected;
-            break;
-            // Соединение установлено
-            case E_ConnectionStates::Connected:
-                    isConnected = true;
+            }
+            a_wait = { E_Readiness::Read, timeout };
+        } break;
+        // Отправка эхо-ответа
+        case E_ConnectionStates::EchoResp: {
+            // Формирование пакета эхо-ответа
+            T_NetPacket packet;
+            packet.Head = Header::EchoResp;
+            if ( m_handle->send( serialize(packet) ) ) {
+                m_sendCounter++;
+                m_conState = E_ConnectionStates::VerifyStatus;
+            }
+            else {
+                a_wait = { E_Readiness::Write, timeout };
+            }
+        } break;
+        // Проверка условия установления соединения
+        case E_ConnectionStates::VerifyStatus:
+            m_conState = m_sendCounter < m_approveCount ? E_ConnectionStates::WaitReqt
+                                                        : E_ConnectionStates::Connected;
             break;
-        }
-
-        if ( state == prevState ) {
-            std::this_thread::sleep_for(timeout);
-        }
+        // Соединение установлено
+        case E_ConnectionStates::Connected:
+            return true;
     }
-    return;
+    return false;
 }
 
-
 /*****************************************************************************
  * Прием данных от клиента
  *
+ * По TCP кадры выделяются из потока по длине (см. C_StreamCodec.h): новый
+ * прием выполняется, только когда все ранее принятые кадры разобраны
+ *
  * @return
  *  Статус успешности приема сообщения
  *  true  - сервер успешно принял сообщение
@@ -361,9 +658,29 @@ void C_Server::udpConHandler()
  */
 bool C_Server::recvPacket()
 {
-    m_buffer.clear();
+    if ( m_protoType == E_Protocol::TCP ) {
+        while ( !m_codec.next( m_packet ) ) {
+            if ( m_codec.isBroken() ) {
+                return false;
+            }
+            size_t capacity = 0;
+            char  *space    = m_codec.space( capacity );
+            if ( !m_handle->recvInto( space, capacity, m_recvSize ) ) {
+                return false;
+            }
+            m_codec.commit( m_recvSize );
+        }
+        return true;
+    }
+
+    // Буфер заполняется нулями только при первом приеме после close()
     m_buffer.resize(s_bufSize);
-    return m_handle->recv(m_buffer);
+    if ( !m_handle->recvInto( m_buffer.data(), m_buffer.size(), m_recvSize ) ) {
+        return false;
+    }
+    // Пакет разбирается один раз, данные остаются в m_buffer
+    m_packet = deserializeView( m_buffer.data(), m_recvSize );
+    return true;
 }
 
 /*****************************************************************************
@@ -386,27 +703,65 @@ std::vector<char> C_Server::convertStrToVec( std::string &&a_str )
 /*****************************************************************************
  * Отправка данных из файла клиенту
  *
+ * Данные не копируются: кадр ссылается на a_payload (см. I_Socket::sendFrames())
+ *
  * @param
- *  [in] a_comand -  команда, которую необходимо отправить клиенту
- *  [in] a_payload - ссылка на буфер, который необходимо передать
+ *  [in] a_comand  - команда, которую необходимо отправить клиенту
+ *  [in] a_payload - указатель на данные, которые необходимо передать
+ *  [in] a_size    - размер данных
  *
  * @return
  *  Статус успешности отправки
  *  true  - сервер успешно отправил данные
  *  false - ошибка при отправке
  */
-bool C_Server::sendPacket( Comand a_comand, std::vector<char> a_payload )
+bool C_Server::sendPacket( Comand a_comand, const char *a_payload, size_t a_size )
 {
-    T_NetPacket packet;
+    Header head = Header::FileSent;
     if( a_comand == Comand::Data ) {
-        packet.Head = Header::DataResp;
-        packet.Data = a_payload;
+        head = Header::DataResp;
+    }
+    else if ( a_comand == Comand::Bulk ) {
+        head = Header::BulkResp;
     }
     else {
-        packet.Head = Header::FileSent;
+        a_size = 0;
     }
 
-    return m_handle->send( serialize(packet) );
+    T_Frame frame = buildFrame( head, a_payload, a_size );
+    return m_handle->sendFrames( &frame, 1 ) == 1;
+}
+
+/*****************************************************************************
+ * Формирование кадра для протокола обмена
+ *
+ * @param
+ *  [in] a_head - заголовок пакета
+ *  [in] a_data - данные пакета (должны существовать до отправки кадра)
+ *  [in] a_size - размер данных
+ *
+ * @return
+ *  - кадр с длиной (TCP, см. C_StreamCodec.h) или без длины (UDP)
+ */
+T_Frame C_Server::buildFrame( Header a_head, const char *a_data, size_t a_size ) const
+{
+    return ( m_protoType == E_Protocol::TCP ) ? C_StreamCodec::frame( a_head, a_data, a_size )
+                                              : makeFrame( a_head, a_data, a_size );
+}
+
+/*****************************************************************************
+ * Освобождение кадров, отправки которых без копирования завершены
+ *
+ * Отправки завершаются в порядке их выполнения, поэтому кадры освобождаются
+ * с начала очереди, пока счетчик завершенных отправок не меньше номера
+ * отправки кадра (с учетом переполнения счетчиков)
+ */
+void C_Server::releaseZeroCopyFrames()
+{
+    std::uint32_t zcDone = m_handle->zeroCopyDone();
+    while ( !m_zcFrames.empty() && static_cast<std::int32_t>( zcDone - m_zcFrames.front().Seq ) >= 0 ) {
+        m_zcFrames.pop_front();
+    }
 }
 
 /*****************************************************************************
@@ -420,6 +775,12 @@ void C_Server::sleep( std::chrono::milliseconds a_sleepTime )
 /*****************************************************************************
  * Загрузка файла в память
  *
+ * Файл берется из общего кэша процесса (см. C_FileCache.h): сессии, которые
+ * воспроизводят один и тот же файл, разделяют одну копию данных и индекса.
+ * Если задан размер окна (setWindowSize()), сессия в ОС Linux отображает файл
+ * отдельно и удерживает в памяти только окно вокруг своего текущего пакета
+ * (см. C_WindowedStreamAnalyzer.h)
+ *
  * @param
  *  [in] a_filePath - путь, по которому находится файл с данными
  */
@@ -428,11 +789,26 @@ void C_Server::loadFile( std::string a_filePath )
     if ( a_filePath.empty() ) {
         return;
     }
-    m_file.open( a_filePath, std::ios::binary | std::ios::in );
-    g_log << m_name << "file open status: " << m_file.is_open() << std::endl;
+    m_packetProvider.reset();
+#ifdef __linux__
+    if ( m_windowSize > 0 ) {
+        m_packetProvider = std::make_shared<C_WindowedStreamAnalyzer>( a_filePath, m_windowSize );
+        if ( m_packetProvider->size() == 0 ) {
+            m_packetProvider.reset();
+        }
+    }
+#endif
+    if ( !m_packetProvider ) {
+        m_packetProvider = C_FileCache::instance().acquire( a_filePath );
+        return;
+    }
 
-    m_packetProvider = std::make_unique<C_StreamAnalyzer>( m_file, m_data );
-    if ( m_packetProvider->calcIndex() ) {
+    // Индекс загружается из файла индекса, если тот соответствует файлу данных.
+    // Иначе остальные пакеты размечаются по мере отправки (см. C_StreamAnalyzer::packetRange())
+    if ( m_packetProvider->loadIndex( C_IndexFile( a_filePath ) ) ) {
+        g_log << m_name << "index loaded from " << C_IndexFile::pathFor( a_filePath ) << std::endl;
+    }
+    else if ( m_packetProvider->calcIndex( s_batchSize ) ) {
         g_log << m_name << "file indexed" << std::endl;
     }
     else {
@@ -441,54 +817,370 @@ void C_Server::loadFile( std::string a_filePath )
 }
 
 /*****************************************************************************
- * Отправка пакета клиенту
+ * Выбор пакетов воспроизводимых потоков
+ *
+ * Потоки выбираются из списка m_streams (или из всех потоков файла) по типу
+ * протокола из описаний потоков. Номера пакетов выбранных потоков объединяются
+ * в порядке возрастания, т.е. в порядке следования пакетов в файле. Для выбора
+ * размечается весь файл
+ */
+void C_Server::selectStreams()
+{
+    std::vector<unsigned char> streams = m_streams;
+    if ( m_streamProto != E_StreamProto::Unknown ) {
+        const auto &streamInfo = m_packetProvider->streamInfo();
+        if ( streams.empty() ) {
+            for ( const auto &stream : streamInfo ) {
+                streams.push_back( stream.StreamNum );
+            }
+        }
+        streams.erase( std::remove_if( streams.begin(), streams.end(), [&]( unsigned char a_streamNum ) {
+                           return a_streamNum >= streamInfo.size() || streamInfo[a_streamNum].Proto != m_streamProto;
+                       } ), streams.end() );
+    }
+
+    m_replayOrder.clear();
+    for ( unsigned char streamNum : streams ) {
+        const auto &packets = m_packetProvider->streamPackets( streamNum );
+        C_StreamAnalyzer::postings_t merged;
+        merged.reserve( m_replayOrder.size() + packets.size() );
+        std::merge( m_replayOrder.begin(), m_replayOrder.end(), packets.begin(), packets.end(),
+                    std::back_inserter( merged ) );
+        m_replayOrder.swap( merged );
+    }
+    g_log << m_name << m_replayOrder.size() << " packets of " << streams.size() << " selected streams" << std::endl;
+}
+
+/*****************************************************************************
+ * Переход к пакету, с которого начинается воспроизведение
+ *
+ * Первым отправляется пакет, время которого не меньше времени первого пакета
+ * файла, увеличенного на m_startTime. Для поиска размечается весь файл
+ */
+void C_Server::seekStartTime()
+{
+    T_PacketView firstPacket = m_packetProvider->getPacket( 0 );
+    if ( !firstPacket ) {
+        return;
+    }
+
+    std::size_t startNo =
+        m_packetProvider->findByTime( firstPacket.time() + static_cast<uint64_t>( m_startTime.count() ) );
+    m_packetIdx = m_streamFilter
+                ? static_cast<unsigned long>( std::lower_bound( m_replayOrder.begin(), m_replayOrder.end(), startNo )
+                                              - m_replayOrder.begin() )
+                : static_cast<unsigned long>( startNo );
+    if ( m_packetIdx < replayCount() && packetNo( m_packetIdx ) < m_packetProvider->index().size() ) {
+        // Первый пакет отправляется без задержки относительно предшествующих ему
+        m_previousTime = std::chrono::milliseconds( m_packetProvider->getPacket( packetNo( m_packetIdx ) ).time() );
+    }
+    g_log << m_name << "replay starts from packet #" << startNo << std::endl;
+}
+
+/*****************************************************************************
+ * Подготовка потоковой передачи пакетов файла
+ *
+ * Поток состоит из всех пакетов файла, начиная с первого воспроизводимого
+ * (см. setStartTime()), и передается
+ * из файла напрямую (см. I_Socket::sendFile()). Если файл не удается открыть,
+ * пакеты будут отправлены по расписанию
+ */
+void C_Server::openBulk()
+{
+    closeFileDescriptor( m_fileFd );
+    if ( !m_packetProvider ) {
+        return;
+    }
+
+    if ( m_streamFilter ) {
+        g_log << m_name << "bulk transfer sends all streams, packets will be sent on schedule" << std::endl;
+        return;
+    }
+
+    // Для расчета длины потока размечается весь файл (до первого поврежденного пакета)
+    m_packetProvider->calcIndex();
+    const auto &index = m_packetProvider->index();
+    if ( m_packetIdx >= index.size() ) {
+        return;
+    }
+
+    m_fileFd = openFileDescriptor( m_filePath, E_FileMode::Reading );
+    if ( m_fileFd < 0 ) {
+        g_log << m_name << "file is not opened for bulk transfer, packets will be sent on schedule" << std::endl;
+        return;
+    }
+
+    m_bulkOffset    = index.offset( m_packetIdx );
+    m_bulkRemaining = static_cast<size_t>( index.endOffset() - m_bulkOffset );
+    g_log << m_name << "bulk transfer of " << m_bulkRemaining << " bytes" << std::endl;
+}
+
+/*****************************************************************************
+ * Включение потоковой передачи файла
+ *
+ * Пакеты передаются без учета их времени одним потоком байтов, поэтому режим
+ * доступен только для протокола TCP
+ *
+ * @param
+ *  [in] a_bulk - признак потоковой передачи
+ */
+void C_Server::setBulkMode( bool a_bulk )
+{
+    if ( a_bulk && m_protoType != E_Protocol::TCP ) {
+        g_log << m_name << "bulk mode is supported for tcp only" << std::endl;
+        return;
+    }
+    m_bulk = a_bulk;
+}
+
+/*****************************************************************************
+ * Установка скорости воспроизведения
+ *
+ * Задержки между пакетами, вычисленные по временным меткам пакетов, делятся
+ * на a_speed
+ *
+ * @param
+ *  [in] a_speed - скорость воспроизведения (1.0 - реальное время)
+ */
+void C_Server::setSpeed( double a_speed )
+{
+    if ( a_speed <= 0.0 ) {
+        g_log << m_name << "invalid replay speed: " << a_speed << std::endl;
+        return;
+    }
+    m_speed = a_speed;
+}
+
+/*****************************************************************************
+ * Загрузка файлов при запуске сервера
+ *
+ * Файлы загружаются при каждом переходе в состояние Setup
+ *
+ * @param
+ *  [in] a_prewarm   - загружать файл, воспроизводимый сервером
+ *  [in] a_filePaths - другие загружаемые файлы (например, воспроизводимые
+ *                     другими серверами процесса)
+ */
+void C_Server::setPrewarm( bool a_prewarm, std::vector<std::string> a_filePaths )
+{
+    m_prewarm      = a_prewarm;
+    m_prewarmFiles = std::move( a_filePaths );
+}
+
+/*****************************************************************************
+ * Запуск загрузки файлов до первого запроса клиента
+ *
+ * Файлы загружаются в общий кэш (см. C_FileCache.h) фоновым потоком кэша,
+ * параллельно с настройкой сокета и ожиданием клиента. Сервер не ожидает
+ * окончания загрузки ни здесь, ни при закрытии сессии. Запрос клиента,
+ * пришедший во время загрузки, ожидает ее окончания в C_FileCache::acquire()
+ */
+void C_Server::startPrewarm()
+{
+    m_prewarmStarted = true;
+    std::vector<std::string> filePaths = m_prewarmFiles;
+    // Файл с ограниченным окном в памяти загружается не через кэш
+    if ( m_prewarm && m_windowSize == 0 && !m_filePath.empty() ) {
+        filePaths.insert( filePaths.begin(), m_filePath );
+    }
+    for ( const std::string &filePath : filePaths ) {
+        C_FileCache::instance().prewarm( filePath, s_prewarmSize );
+    }
+    if ( !filePaths.empty() ) {
+        g_log << m_name << "prewarming " << static_cast<unsigned long>( filePaths.size() ) << " file(s)" << std::endl;
+    }
+}
+
+/*****************************************************************************
+ * Установка смещения начала воспроизведения
+ *
+ * Смещение применяется при загрузке файла в начале следующей сессии
+ *
+ * @param
+ *  [in] a_startTime - смещение от времени первого пакета файла
+ */
+void C_Server::setStartTime( std::chrono::milliseconds a_startTime )
+{
+    if ( a_startTime.count() < 0 ) {
+        g_log << m_name << "invalid replay start time: " << a_startTime.count() << std::endl;
+        return;
+    }
+    m_startTime = a_startTime;
+}
+
+/*****************************************************************************
+ * Установка воспроизводимых потоков
+ *
+ * Список потоков применяется при загрузке файла в начале следующей сессии
  *
  * @param
- *  [in] a_idx       - текущий номер пакета, подлежащего отправке
- *  [in] a_prevTime  - временная метка предыдущего пакета
- *  [in] a_sleepTime - время задержки между пакетами
+ *  [in] a_streams - номера потоков (пустой список - воспроизводятся все потоки)
+ */
+void C_Server::setStreams( std::vector<unsigned char> a_streams )
+{
+    std::sort( a_streams.begin(), a_streams.end() );
+    a_streams.erase( std::unique( a_streams.begin(), a_streams.end() ), a_streams.end() );
+    m_streams = std::move( a_streams );
+}
+
+/*****************************************************************************
+ * Номер пакета файла, воспроизводимого под заданным номером
+ *
+ * @param
+ *  [in] a_idx - номер пакета в порядке воспроизведения (меньше replayCount())
  *
  * @return
- *  Статус успешности отправки пакета
- *  true  - сервер успешно отправил данные
+ *  - номер пакета в файле
+ */
+unsigned long C_Server::packetNo( unsigned long a_idx ) const
+{
+    return m_streamFilter ? m_replayOrder[a_idx] : a_idx;
+}
+
+/*****************************************************************************
+ * Количество воспроизводимых пакетов
+ *
+ * @return
+ *  - количество пакетов файла или пакетов выбранных потоков
+ */
+unsigned long C_Server::replayCount()
+{
+    return m_streamFilter ? static_cast<unsigned long>( m_replayOrder.size() )
+                          : m_packetProvider->packetCount();
+}
+
+/*****************************************************************************
+ * Отправка клиенту пакетов, время отправки которых наступило
+ *
+ * Время отправки каждого пакета отсчитывается от времени отправки предыдущего
+ * по расписанию, а не по факту, поэтому при отставании от расписания (или при
+ * ускоренном воспроизведении) все наступившие пакеты отправляются одним
+ * вызовом I_Socket::sendFrames(): кадры ссылаются на данные файла. По TCP
+ * каждый кадр предваряется длиной (см. C_StreamCodec.h)
+ *
+ * В режиме отправки без копирования кадр каждого пакета отправляется отдельно
+ * и хранится в m_zcFrames, пока ядро ссылается на его заголовок. Кадр, данные
+ * которого ядро скопировало, не сохраняется
+ *
+ * Если клиент задал окно кредитов, за один вызов отправляется не больше пакетов,
+ * чем осталось кредитов
+ *
+ * @param
+ *  [out] a_sleepTime - время до отправки следующего пакета
+ *
+ * @return
+ *  Статус успешности отправки пакетов
+ *  true  - сервер успешно отправил данные (или время отправки еще не наступило)
  *  false - ошибка при отправке
  */
-bool C_Server::processPacket( unsigned long& a_idx,
-                              std::chrono::milliseconds& a_prevTime,
-                              std::chrono::milliseconds& a_sleepTime )
+bool C_Server::sendDuePackets( std::chrono::milliseconds &a_sleepTime )
 {
+    using namespace std::chrono;
     using namespace std::chrono_literals;
-    // Получение указателя на пакет под номером a_idx
-    const T_Packet* packetPtr = m_packetProvider->getPacketPtr(a_idx);
-    auto packetTime = std::chrono::milliseconds(packetPtr->Time);
-
-    // Расчет времени задержки между пакетами
-    auto nonNullDelay = 10ms;
-    auto diffPacketTime = packetTime - a_prevTime;
 
-    if ( diffPacketTime < 10ms ) {
-        a_sleepTime = diffPacketTime + nonNullDelay;
+    auto now = steady_clock::now();
+    if ( m_nextSendTime == steady_clock::time_point() ) {
+        m_nextSendTime = now;
     }
-    else {
-        a_sleepTime = diffPacketTime;
-        //a_sleepTime = nonNullDelay; //time boost
+
+    size_t batchSize = ( m_window != 0 ) ? std::min<size_t>( s_batchSize, m_credit ) : s_batchSize;
+
+    m_frames.clear();
+    m_schedule.clear();
+    auto sendTime = m_nextSendTime;
+    auto prevTime = m_previousTime;
+    for ( unsigned long idx = m_packetIdx;
+          idx < replayCount() && m_schedule.size() < batchSize && sendTime <= now;
+          idx++ ) {
+        T_PacketView packetView = m_packetProvider->getPacket( packetNo( idx ) );
+        if ( !packetView ) {
+            break;
+        }
+        auto packetTime = milliseconds( packetView.time() );
+
+        // Расчет времени задержки между пакетами
+        auto nonNullDelay = 10ms;
+        auto diffPacketTime = packetTime - prevTime;
+        auto delay = ( diffPacketTime < 10ms ) ? diffPacketTime + nonNullDelay : diffPacketTime;
+        sendTime += duration_cast<steady_clock::duration>( delay / m_speed );
+        prevTime  = packetTime;
+
+        // Получение границ пакета под номером idx и формирование кадра Header::DataResp
+        if ( !m_zeroCopy ) {
+            auto iters = m_packetProvider->packetRange( packetNo( idx ) );
+            m_frames.push_back( buildFrame( Header::DataResp, iters.first,
+                                            static_cast<size_t>( iters.second - iters.first ) ) );
+        }
+        m_schedule.emplace_back( sendTime, packetTime );
     }
 
-    a_prevTime = packetTime;
-    // Получение границ пакета под номером a_idx
-    auto iters = m_packetProvider->packetRange(a_idx);
-    // Отправка пакета клиенту с заголовком Header::DataResp
-    if ( sendPacket( Comand::Data, { iters.first, iters.second } ) ) {
-        g_log << m_name << "send packet #" << a_idx << std::endl;
-        a_idx++;
+    size_t sent = 0;
+    if ( m_zeroCopy ) {
+        for ( ; sent < m_schedule.size(); sent++ ) {
+            auto iters = m_packetProvider->packetRange( packetNo( m_packetIdx + sent ) );
+            std::uint32_t zcSent = m_handle->zeroCopySent();
+            m_zcFrames.push_back( { buildFrame( Header::DataResp, iters.first,
+                                                static_cast<size_t>( iters.second - iters.first ) ) } );
+            if ( !m_handle->sendZeroCopy( m_zcFrames.back().Frame ) ) {
+                m_zcFrames.pop_back();
+                break;
+            }
+            if ( m_handle->zeroCopySent() == zcSent ) {
+                m_zcFrames.pop_back();
+            }
+            else {
+                m_zcFrames.back().Seq = m_handle->zeroCopySent();
+            }
+        }
+    }
+    else if ( !m_frames.empty() ) {
+        sent = m_handle->sendFrames( m_frames.data(), m_frames.size() );
+    }
+    for ( size_t idx = 0; idx < sent; idx++ ) {
+        g_log << m_name << "send packet #" << packetNo( m_packetIdx ) << std::endl;
         // Вывод мета-информации пакета на экран
-        print( packetPtr );
-        return true;
+        print( m_packetProvider->getPacket( packetNo( m_packetIdx ) ) );
+        m_nextSendTime = m_schedule[idx].first;
+        m_previousTime = m_schedule[idx].second;
+        m_packetIdx++;
     }
-    else {
-        g_log << m_name << "problem with sending packet: " << a_idx << std::endl;
+    if ( sent > 0 && m_packetIdx < replayCount() ) {
+        m_packetProvider->setCursor( packetNo( m_packetIdx ) );
+    }
+    if ( m_window != 0 ) {
+        m_credit -= static_cast<std::uint32_t>( sent );
+    }
+
+    if ( sent == 0 && !m_schedule.empty() ) {
+        g_log << m_name << "problem with sending packet: " << m_packetIdx << std::endl;
         return false;
     }
+
+    auto remaining = m_nextSendTime - steady_clock::now();
+    a_sleepTime = ( remaining > steady_clock::duration::zero() )
+                ? duration_cast<milliseconds>( remaining + 999us )
+                : 0ms;
+    return true;
+}
+
+/*****************************************************************************
+ * Прием кредитов клиента при исчерпанном окне
+ *
+ * Запросы принимаются, пока не получен хотя бы один кредит: остальные запросы
+ * остаются в сокете до следующего исчерпания окна
+ *
+ * @return
+ *  true  - кредиты есть
+ *  false - кредитов нет (wouldBlock() - запросов клиента пока нет)
+ */
+bool C_Server::recvCredit()
+{
+    while ( m_credit == 0 && recvPacket() ) {
+        if ( parseComand() == Comand::Data ) {
+            takeCredit();
+        }
+    }
+    return m_credit != 0;
 }
 
 /*****************************************************************************
@@ -503,9 +1195,7 @@ bool C_Server::processPacket( unsigned long& a_idx,
  */
 Comand C_Server::parseComand() const
 {
-    T_NetPacket recvPacket = deserialize(m_buffer);
-
-    if ( recvPacket.Head == Header::DataReqt ) {
+    if ( m_packet.Head == Header::DataReqt ) {
         return Comand::Data;
     }
     else {
@@ -513,4 +1203,31 @@ Comand C_Server::parseComand() const
     }
 }
 
+/*****************************************************************************
+ * Учет кредитов, выданных клиентом в запросе данных
+ *
+ * Кредиты передаются 4 байтами данных запроса Header::DataReqt в порядке
+ * байтов big-endian. Первый запрос с ненулевыми кредитами задает окно, после
+ * чего неизрасходованные кредиты не превышают окна: клиент, переставший
+ * получать пакеты, выдает окно заново (см. C_Client.cpp)
+ */
+void C_Server::takeCredit()
+{
+    if ( m_packet.Size < sizeof(std::uint32_t) ) {
+        return;
+    }
+    std::uint32_t credit = 0;
+    for ( size_t idx = 0; idx < sizeof(credit); idx++ ) {
+        credit = ( credit << 8 ) | static_cast<unsigned char>( m_packet.Data[idx] );
+    }
+    if ( m_window == 0 ) {
+        if ( credit == 0 ) {
+            return;
+        }
+        m_window = credit;
+        g_log << m_name << "client credit window: " << m_window << " packets" << std::endl;
+    }
+    m_credit = static_cast<std::uint32_t>( std::min<std::uint64_t>( std::uint64_t( m_credit ) + credit, m_window ) );
+}
+
 } // namespace network
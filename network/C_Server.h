@@ -36,6 +36,85 @@
 
      ser.work();
 
+  3. Скорость воспроизведения задается функцией setSpeed(): при ускоренном
+     воспроизведении или отставании от расписания сервер отправляет все пакеты,
+     время отправки которых наступило, одним вызовом I_Socket::sendFrames().
+     Кадры ссылаются на данные загруженного файла, заголовок кадра передается
+     отдельным iovec, поэтому пакеты не копируются в промежуточные буферы. По
+     протоколу TCP каждый кадр предваряется длиной (см. C_StreamCodec.h), поэтому
+     несколько кадров в одном приеме клиента не сливаются:
+
+     ser.setSpeed( 4.0 );
+
+     Функция setZeroCopy() включает отправку пакетов без копирования и в
+     пространство ядра (см. I_Socket::sendZeroCopy()):
+
+     ser.setZeroCopy( true );
+
+     Клиент может ограничить отправку окном кредитов (см. C_Client::setWindow()):
+     запрос Header::DataReqt с 4 байтами данных (big-endian) выдает серверу
+     столько кредитов (пакетов файла), первый такой запрос задает размер окна.
+     Сервер отправляет пакеты, пока кредиты не израсходованы, после чего
+     принимает новые кредиты. Запросы без данных окно не задают, и пакеты
+     отправляются только по расписанию. Прежние клиенты работают так только по
+     UDP: по TCP они не используют разметку кадров (см. C_StreamCodec.h). Окно
+     задается на стороне клиента:
+
+     cli.setWindow( 64 );
+
+     Функция setBulkMode() включает потоковую передачу (только TCP): после
+     заголовка файла сервер отправляет кадр Header::BulkResp с длиной потока и
+     после очередного запроса клиента передает все пакеты файла без учета их
+     времени вызовами I_Socket::sendFile() (sendfile()), затем - кадр
+     Header::FileSent:
+
+     ser.setBulkMode( true );
+
+     Функция setStartTime() задает смещение начала воспроизведения от времени
+     первого пакета файла: пакет, с которого начинается передача, находится
+     поиском по времени (см. C_StreamAnalyzer::findByTime()) без отправки
+     предшествующих пакетов:
+
+     ser.setStartTime( std::chrono::minutes( 10 ) );
+
+     Функция setStreams() ограничивает воспроизведение пакетами указанных потоков
+     (T_Packet::StreamNum). Номера пакетов этих потоков берутся из индекса потоков
+     (см. C_StreamAnalyzer::streamPackets()), поэтому пакеты остальных потоков
+     не читаются. Потоковая передача при этом недоступна:
+
+     ser.setStreams( { 0, 2 } );
+
+     Функция setStreamProto() ограничивает воспроизведение потоками с заданным
+     типом протокола (см. C_StreamAnalyzer::streamInfo()). Потоки отбираются
+     один раз при загрузке файла. Тип протокола потоков задается только
+     старыми форматами файла, в файле формата Mes3 потоки не будут выбраны:
+
+     ser.setStreamProto( E_StreamProto::Ethernet );
+
+     Функция setWindowSize() ограничивает память, занимаемую файлом, окном
+     вокруг текущего пакета (см. C_WindowedStreamAnalyzer.h): файлы, превышающие
+     объем оперативной памяти, воспроизводятся с постоянным расходом памяти:
+
+     ser.setWindowSize( 64 * 1024 * 1024 );
+
+     Функция setPrewarm() включает загрузку файла (и списка других
+     файлов) в общий кэш (см. C_FileCache.h) при запуске сервера, параллельно с
+     ожиданием клиента. Начало файла загружается в память, поэтому первый пакет
+     отправляется без обращения к диску:
+
+     ser.setPrewarm( true, { "other.mes" } );
+
+  4. В ОС Linux несколько серверов (и клиентов) могут обслуживаться одним
+     потоком реактора событий (см. C_Reactor.h):
+
+     C_Reactor reactor;
+     ser1.attach( reactor );
+     ser2.attach( reactor );
+     reactor.run();
+
+     Реактор должен существовать, пока к нему подключены серверы: run()
+     возвращает управление, когда все они завершили работу.
+
 ******************************************************************************/
 
 #pragma once
@@ -44,8 +123,11 @@
 
 #include <fstream>
 #include <atomic>
+#include <deque>
+#include <mutex>
 
 #include "C_StreamAnalyzer.h"
+#include "C_StreamCodec.h"
 #include "C_Logger.h"
 #include "utils.h"
 
@@ -61,6 +143,8 @@ using namespace services;
   Forward Declarations
 *****************************************************************************/
 
+class C_Reactor;
+
 /*****************************************************************************
   Types and Classes Definitions
 *****************************************************************************/
@@ -85,6 +169,29 @@ public:
     // Остановить работу сервера
     void stop();
 
+    // Выбор реализации сокета (до вызова work())
+    void setSocketBackend( E_SocketBackend a_backend ) { m_backend = a_backend; }
+    // Установка скорости воспроизведения (1.0 - реальное время)
+    void setSpeed( double a_speed );
+    // Отправка пакетов из буфера файла без копирования (MSG_ZEROCOPY)
+    void setZeroCopy( bool a_zeroCopy ) { m_zeroCopy = a_zeroCopy; }
+    // Передача всех пакетов файла одним потоком без учета времени (только TCP)
+    void setBulkMode( bool a_bulk );
+    // Смещение начала воспроизведения от времени первого пакета файла
+    void setStartTime( std::chrono::milliseconds a_startTime );
+    // Воспроизведение только пакетов потоков a_streams (пустой список - всех потоков)
+    void setStreams( std::vector<unsigned char> a_streams );
+    // Воспроизведение только потоков с протоколом a_proto (E_StreamProto::Unknown - всех)
+    void setStreamProto( E_StreamProto a_proto ) { m_streamProto = a_proto; }
+    // Размер окна файла в памяти в байтах (0 - без ограничения, только ОС Linux)
+    void setWindowSize( std::size_t a_windowSize ) { m_windowSize = a_windowSize; }
+    // Загрузка файла (и файлов a_filePaths) при запуске сервера, до первого запроса клиента
+    void setPrewarm( bool a_prewarm, std::vector<std::string> a_filePaths = {} );
+
+#ifdef __linux__
+    // Подключение сервера к реактору событий
+    void attach( C_Reactor &a_reactor );
+#endif
 
 public slots:
 
@@ -98,20 +205,41 @@ signals:
 
 protected:
 
+    // Шаг машины состояний сервера
+    T_Wait step();
+    // Начальное состояние машины состояний сервера
+    void reset();
+#ifdef __linux__
+    // Продолжение работы машины состояний по событию реактора
+    void resume();
+    // Регистрация в реакторе ожидаемого машиной состояний события
+    void arm( const T_Wait &a_wait );
+    // Отключение сервера от реактора событий
+    void detach();
+#endif
+
     /**
      * Обработчики состояний
      */
 
     // Создание и настройка сокета
     bool setup();
+    // Запуск загрузки файлов до первого запроса клиента
+    void startPrewarm();
     // Создание сессии с клиентом
     bool connect();
     // Загрузка файла в память
     void loadFile( std::string a_filePath );
-    // Отправка пакета клиенту
-    bool processPacket( unsigned long &a_idx,
-                        std::chrono::milliseconds &a_prevTime,
-                        std::chrono::milliseconds &a_sleepTime );
+    // Выбор пакетов воспроизводимых потоков
+    void selectStreams();
+    // Переход к пакету, с которого начинается воспроизведение
+    void seekStartTime();
+    // Подготовка потоковой передачи пакетов файла
+    void openBulk();
+    // Отправка клиенту пакетов, время отправки которых наступило
+    bool sendDuePackets( std::chrono::milliseconds &a_sleepTime );
+    // Прием кредитов клиента при исчерпанном окне
+    bool recvCredit();
     // Прием данных от клиента
     bool recvPacket();
     // Ожидание между неуспешными итерациями цикла-обработчика, мсек
@@ -122,12 +250,22 @@ protected:
      */
     // Извлечение команды из пакета данных
     Comand parseComand() const;
+    // Учет кредитов, выданных клиентом в запросе данных
+    void takeCredit();
     // Преобразование строки в вектор символов
     std::vector<char> convertStrToVec( std::string &&a_str );
     // Отправка данных из файла клиенту
-    bool sendPacket( Comand a_comand, std::vector<char> a_payload = {} );
-    // Проведение процедуры "handshake" с сервером по UDP протоколу
-    void udpConHandler();
+    bool sendPacket( Comand a_comand, const char *a_payload = nullptr, size_t a_size = 0 );
+    // Формирование кадра для протокола обмена (по TCP - с длиной)
+    T_Frame buildFrame( Header a_head, const char *a_data, size_t a_size ) const;
+    // Освобождение кадров, отправки которых без копирования завершены
+    void releaseZeroCopyFrames();
+    // Номер пакета файла, воспроизводимого под номером a_idx
+    unsigned long packetNo( unsigned long a_idx ) const;
+    // Количество воспроизводимых пакетов
+    unsigned long replayCount();
+    // Шаг процедуры "handshake" с клиентом по UDP протоколу
+    bool udpConStep( T_Wait &a_wait );
 
 protected: // types
 
@@ -135,12 +273,17 @@ protected: // types
     enum class E_States {
         Setup,                                  // Настройка всех служб перед работой
         Connect,                                // Подключение
-        RecvPacket,                                // Прием сообщения
+        Handshake,                              // Установление сеанса по UDP протоколу
+        RecvPacket,                             // Прием сообщения
         ParsePacket,                            // Разбор принятого сообщения
         LoadFile,                               // Загрузить файл с данными с диска
         SendHeader,                             // Отправка заголовка клиенту
         SendPacket,                             // Отправка пакета клиенту
-        Finish                                  // Завершение работы
+        SendBulkHeader,                         // Отправка длины потока клиенту
+        SendFile,                               // Потоковая отправка пакетов файла
+        Finish,                                 // Завершение работы
+        Closing,                                // Ожидание доставки последнего пакета перед закрытием
+        Closed                                  // Работа завершена
     };
 
     // Промежуточные состояния установления соединения с клиентом
@@ -151,6 +294,12 @@ protected: // types
         Connected                              // Соединение с клиентом установлено
     };
 
+    // Кадр, отправленный без копирования
+    struct T_ZeroCopyFrame {
+        T_Frame         Frame;                          // Кадр (ядро ссылается на его заголовок)
+        std::uint32_t   Seq = 0;                        // Значение I_Socket::zeroCopySent() после отправки кадра
+    };
+
     // Коды возврата функции setup()
     enum E_SetupRetVal {
         enSockAlreadyCreated = -1,                      // Ошибка, сокет был создан ранее
@@ -168,18 +317,61 @@ protected:
 
     std::atomic<bool>                   isRunning;          // Атомарный флаг работы главного цикла-обработчика событий сервера
     std::vector<char>                   m_buffer;           // Буфер обмена для приема/отправки сетевых пакетов
+    size_t                              m_recvSize = 0;     // Количество байтов, принятых в m_buffer
+    T_NetPacketView                     m_packet;           // Последний принятый пакет (данные в m_buffer или m_codec)
+    C_StreamCodec                       m_codec;            // Разметка кадров, принимаемых по TCP
     std::string                         m_name;             // Лог-метка сервера
     std::string                         m_authority;        // Адреса и порты клиента и сервера
     E_Protocol                          m_protoType;        // Тип протокола обмена
+    E_SocketBackend                     m_backend = E_SocketBackend::Native;    // Реализация сокета
     std::shared_ptr<I_Socket>           m_handle;           // Сокет сервера
-    std::unique_ptr<C_StreamAnalyzer>   m_packetProvider;   // Парсер данных
-    std::fstream                        m_file;             // Хендлер файла с данными
-    std::vector<char>                   m_data;             // Буфер с данными из файла
+    std::shared_ptr<C_StreamAnalyzer>   m_packetProvider;   // Парсер данных (общий для сессий, см. C_FileCache.h)
     std::string                         m_filePath;         // Путь к файлу с данными
 
+    /**
+     * Состояние машины состояний, сохраняемое между шагами
+     */
+    E_States                            m_state     = E_States::Setup;                  // Текущее состояние
+    E_ConnectionStates                  m_conState  = E_ConnectionStates::WaitReqt;     // Состояние "handshake" по UDP
+    unsigned long                       m_packetIdx = 0;                                // Номер следующего пакета в порядке воспроизведения
+    std::chrono::milliseconds           m_previousTime;                                 // Время предыдущего пакета
+    std::chrono::steady_clock::time_point m_nextSendTime;                               // Время отправки следующего пакета
+    double                              m_speed = 1.0;                                  // Скорость воспроизведения
+    std::chrono::milliseconds           m_startTime{ 0 };                               // Смещение начала воспроизведения
+    std::vector<unsigned char>          m_streams;                                      // Воспроизводимые потоки (пусто - все)
+    E_StreamProto                       m_streamProto = E_StreamProto::Unknown;         // Протокол воспроизводимых потоков
+    bool                                m_streamFilter = false;                         // Воспроизводятся не все потоки
+    C_StreamAnalyzer::postings_t        m_replayOrder;                                  // Номера пакетов воспроизводимых потоков
+    std::size_t                         m_windowSize = 0;                               // Размер окна файла в памяти (0 - весь файл)
+    bool                                m_prewarm = false;                              // Загрузка файла при запуске сервера
+    std::vector<std::string>            m_prewarmFiles;                                 // Дополнительно загружаемые при запуске файлы
+    bool                                m_prewarmStarted = false;                       // Загрузка файлов запущена в текущей сессии
+    bool                                m_zeroCopy = false;                             // Отправка пакетов без копирования
+    bool                                m_bulk     = false;                             // Потоковая передача файла
+    int                                 m_fileFd   = -1;                                // Дескриптор файла для потоковой передачи
+    std::uint64_t                       m_bulkOffset = 0;                               // Смещение неотправленной части потока
+    size_t                              m_bulkRemaining = 0;                            // Неотправленный остаток потока
+    bool                                m_bulkHeaderIsSent = false;                     // Длина потока отправлена
+    std::uint32_t                       m_window = 0;                                   // Окно кредитов клиента в пакетах (0 - без окна)
+    std::uint32_t                       m_credit = 0;                                   // Неизрасходованные кредиты клиента
+    std::deque<T_ZeroCopyFrame>         m_zcFrames;                                     // Кадры, отправленные без копирования (до завершения их отправок)
+    std::vector<T_Frame>                m_frames;                                       // Кадры, отправляемые одним вызовом
+    std::vector<std::pair<std::chrono::steady_clock::time_point,
+                          std::chrono::milliseconds>> m_schedule;                       // Расписание пакетов из m_frames
+    bool                                m_headerIsSent = false;                         // Заголовок файла отправлен
+    unsigned char                       m_sendCounter  = 0;                             // Счетчик отправленных эхо-ответов
+    unsigned char                       m_approveCount = 0;                             // Требуемое клиентом число эхо-ответов
+
+    std::atomic<C_Reactor*>             m_reactor { nullptr };                          // Реактор, обслуживающий сервер
+    std::mutex                          m_reactorMutex;                                 // Защита m_reactor при обращении из stop()
+    int                                 m_watchedFd = -1;                               // Дескриптор, ожидаемый в реакторе
+    std::uint64_t                       m_timerId   = 0;                                // Активный таймер в реакторе
+
 protected: // static
 
     static const size_t                 s_bufSize;          // Максимальный размер буфера приема-передачи
+    static const size_t                 s_batchSize;        // Максимальное количество пакетов в одной отправке
+    static const size_t                 s_prewarmSize;      // Объем начала файла, загружаемый в память при запуске
 
 };
 
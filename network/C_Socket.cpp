@@ -23,6 +23,9 @@
 
 #include "C_Socket.h"
 
+#include <io.h>
+#include <algorithm>
+
 namespace network {
 
 /*****************************************************************************
@@ -45,6 +48,8 @@ namespace network {
   Variables Definitions
 *****************************************************************************/
 
+const size_t C_Socket::s_fileChunkSize = 64 * 1024;    // Размер блока файла 64 kilobytes
+
 /*****************************************************************************
   Functions Definitions
 *****************************************************************************/
@@ -304,6 +309,227 @@ std::string C_Socket::name() const
             + std::string(addr) + ":" + std::to_string(port) + "] ";
 }
 
+/*****************************************************************************
+ * Пакетная отправка данных
+ *
+ * Реализация по умолчанию отправляет буферы последовательными вызовами send()
+ * до первой неудачной отправки
+ *
+ * @param
+ *  [in] a_buffs - буферы, данные из которых отправляются по сокету
+ *
+ * @return
+ *  - количество отправленных буферов
+ */
+size_t C_Socket::sendBatch( const std::vector<std::vector<char>> &a_buffs )
+{
+    m_wouldBlock = false;
+    size_t sent = 0;
+    for ( const auto &buff : a_buffs ) {
+        if ( !send( buff ) ) {
+            break;
+        }
+        sent++;
+    }
+    return sent;
+}
+
+/*****************************************************************************
+ * Отправка кадров
+ *
+ * Реализация по умолчанию склеивает каждый кадр в буфере m_frameBuf и
+ * отправляет его вызовом send() до первой неудачной отправки. Кадр,
+ * отправленный частично, считается отправленным, если send() сохраняет
+ * его остаток (см. C_TcpSocket)
+ *
+ * @param
+ *  [in] a_frames - кадры
+ *  [in] a_count  - количество кадров
+ *
+ * @return
+ *  - количество отправленных кадров
+ */
+size_t C_Socket::sendFrames( const T_Frame *a_frames, size_t a_count )
+{
+    m_wouldBlock = false;
+    size_t sent = 0;
+    for ( ; sent < a_count; sent++ ) {
+        const T_Frame &frame = a_frames[sent];
+        m_frameBuf.assign( frame.Head, frame.Head + frame.HeadSize );
+        m_frameBuf.insert( m_frameBuf.end(), frame.Data, frame.Data + frame.Size );
+        if ( !send( m_frameBuf ) ) {
+            break;
+        }
+    }
+    return sent;
+}
+
+/*****************************************************************************
+ * Прием данных через сокет
+ *
+ * Данные принимаются в текущий размер буфера, после приема размер буфера
+ * уменьшается до количества принятых байтов
+ *
+ * @param
+ *  [out] a_buff - ссылка на буфер, в который помещаются принятые данные
+ *
+ * @return
+ *  true  - прием данных произошел успешно
+ *  false - во время приема данных произошла ошибка
+ */
+bool C_Socket::recv( std::vector<char> &a_buff )
+{
+    size_t received = 0;
+    if ( !recvInto( a_buff.data(), a_buff.size(), received ) ) {
+        return false;
+    }
+    a_buff.resize( received );
+    return true;
+}
+
+/*****************************************************************************
+ * Пакетный прием данных
+ *
+ * Реализация по умолчанию принимает данные одним вызовом recvInto() в первый
+ * буфер, чтобы не блокироваться в ожидании следующих данных
+ *
+ * @param
+ *  [out] a_buffs - буферы, в которые помещаются принятые данные
+ *  [out] a_sizes - количество байтов, принятых в каждый буфер
+ *
+ * @return
+ *  - количество заполненных буферов (0 или 1)
+ */
+size_t C_Socket::recvBatch( std::vector<std::vector<char>> &a_buffs, std::vector<size_t> &a_sizes )
+{
+    a_sizes.resize( a_buffs.size() );
+    if ( a_buffs.empty() || !recvInto( a_buffs.front().data(), a_buffs.front().size(), a_sizes.front() ) ) {
+        return 0;
+    }
+    return 1;
+}
+
+/*****************************************************************************
+ * Отправка кадра из заголовка и полезной нагрузки
+ *
+ * Реализация по умолчанию не поддерживает отправку без копирования и
+ * отправляет склеенный кадр одним вызовом send() (см. sendFrames())
+ *
+ * @param
+ *  [in] a_frame - кадр
+ *
+ * @return
+ *  Статус успешности отправки кадра
+ */
+bool C_Socket::sendZeroCopy( const T_Frame &a_frame )
+{
+    return sendFrames( &a_frame, 1 ) == 1;
+}
+
+/*****************************************************************************
+ * Отправка части файла
+ *
+ * Блок файла читается вызовом _read() и отправляется вызовом send()
+ * через рабочий сокет
+ *
+ * @param
+ *  [in]     a_fd     - дескриптор файла, открытого на чтение
+ *  [in,out] a_offset - смещение первого неотправленного байта в файле
+ *  [in,out] a_count  - количество байтов, которое осталось отправить
+ *
+ * @return
+ *  Статус успешности отправки
+ *  true  - отправлена часть данных, a_offset и a_count сдвинуты
+ *  false - ошибка чтения или отправки (wouldBlock() - отправка невозможна без блокировки)
+ */
+bool C_Socket::sendFile( int a_fd, uint64_t &a_offset, size_t &a_count )
+{
+    m_wouldBlock = false;
+    std::vector<char> chunk( std::min( a_count, s_fileChunkSize ) );
+    if ( _lseeki64( a_fd, static_cast<__int64>( a_offset ), SEEK_SET ) < 0 ) {
+        g_log << name() << "sendFile: seek failed" << std::endl;
+        return false;
+    }
+    int numRead = _read( a_fd, chunk.data(), static_cast<unsigned>( chunk.size() ) );
+    if ( numRead <= 0 ) {
+        g_log << name() << "sendFile: read failed" << std::endl;
+        return false;
+    }
+
+    int numBytes = ::send( static_cast<SOCKET>( handle() ), chunk.data(), numRead, 0 );
+    if ( numBytes == SOCKET_ERROR ) {
+        updateWouldBlock();
+        return false;
+    }
+
+    a_offset += static_cast<uint64_t>( numBytes );
+    a_count  -= static_cast<size_t>( numBytes );
+    return true;
+}
+
+/*****************************************************************************
+ * Прием потока с записью в файл
+ *
+ * Блок принимается вызовом recv() и дописывается в файл вызовом _write()
+ *
+ * @param
+ *  [in]     a_fd    - дескриптор файла, открытого на запись
+ *  [in,out] a_count - количество байтов, которое осталось принять
+ *
+ * @return
+ *  Статус успешности приема
+ *  true  - часть данных принята и записана, a_count уменьшен
+ *  false - ошибка приема или записи (wouldBlock() - данных пока нет)
+ */
+bool C_Socket::recvFile( int a_fd, size_t &a_count )
+{
+    m_wouldBlock = false;
+    std::vector<char> chunk( std::min( a_count, s_fileChunkSize ) );
+    int numBytes = ::recv( static_cast<SOCKET>( handle() ), chunk.data(),
+                           static_cast<int>( chunk.size() ), 0 );
+    if ( numBytes == SOCKET_ERROR ) {
+        updateWouldBlock();
+        return false;
+    }
+    if ( numBytes == 0 ) {
+        g_log << name() << "recvFile: connection closed" << std::endl;
+        return false;
+    }
+
+    if ( _write( a_fd, chunk.data(), static_cast<unsigned>( numBytes ) ) != numBytes ) {
+        g_log << name() << "recvFile: write failed" << std::endl;
+        return false;
+    }
+
+    a_count -= static_cast<size_t>( numBytes );
+    return true;
+}
+
+/*****************************************************************************
+ * Системный дескриптор рабочего сокета
+ *
+ * @return
+ *  - дескриптор сокета
+ */
+int C_Socket::handle() const
+{
+    return static_cast<int>( m_masterSock );
+}
+
+/*****************************************************************************
+ * Запоминание признака "операция не может быть выполнена без блокировки"
+ *
+ * Вызывается сразу после неуспешного вызова WinSock: код ошибки потока может
+ * быть перезаписан следующими вызовами (в том числе выводом в лог). Каждая
+ * операция сокета сбрасывает признак в начале, поэтому wouldBlock() относится
+ * только к последней операции
+ */
+void C_Socket::updateWouldBlock()
+{
+    int err = WSAGetLastError();
+    m_wouldBlock = ( err == WSAEWOULDBLOCK || err == WSAEINPROGRESS || err == WSAEALREADY );
+}
+
 /*****************************************************************************
  * Инициализация библиотеки, конфигурация параметров сокета
  *
@@ -80,6 +80,32 @@ public:
     // Лог-метка сокета
     virtual std::string name() const override;
 
+    // Пакетная отправка данных (последовательными вызовами send())
+    virtual size_t sendBatch( const std::vector<std::vector<char>> &a_buffs ) override;
+    // Отправка кадров (со склейкой кадра, последовательными вызовами send())
+    virtual size_t sendFrames( const T_Frame *a_frames, size_t a_count ) override;
+    // Прием данных (через recvInto())
+    virtual bool recv(       std::vector<char> &a_buff ) override;
+    // Пакетный прием данных (одним вызовом recvInto())
+    virtual size_t recvBatch(       std::vector<std::vector<char>> &a_buffs,
+                                    std::vector<size_t> &a_sizes ) override;
+    // Отправка кадра (с копированием, одним вызовом send())
+    virtual bool sendZeroCopy( const T_Frame &a_frame ) override;
+    // Отправка части файла (чтение _read() и отправка send() блоками)
+    virtual bool sendFile( int a_fd, uint64_t &a_offset, size_t &a_count ) override;
+    // Прием потока с записью в файл (прием recv() и запись _write() блоками)
+    virtual bool recvFile( int a_fd, size_t &a_count ) override;
+
+    // Системный дескриптор рабочего сокета
+    virtual int handle() const override;
+    // Последняя неуспешная операция не могла быть выполнена без блокировки
+    virtual bool wouldBlock() const override { return m_wouldBlock; }
+    // Отправка выполняется сразу, отложенных операций нет
+    virtual bool submit() override { return true; }
+    // Данные кадров всегда копируются, отправок без копирования нет
+    virtual uint32_t zeroCopySent() const override { return 0; }
+    virtual uint32_t zeroCopyDone() const override { return 0; }
+
 protected:
 
     /**
@@ -100,6 +126,9 @@ protected:
     // Инициализация библиотеки WinSock
     bool initLib();
 
+    // Запоминание признака "операция не может быть выполнена без блокировки" по WSAGetLastError()
+    void updateWouldBlock();
+
 protected: //types
 
     struct ProtoCredentials {                       // Параметры используемого протокола
@@ -116,6 +145,12 @@ protected:
     sockaddr_in     m_myService;                            // Структура сокета
     sockaddr_in     m_peerService;                          // Структура для хранения адреса получателя
     std::string     m_name;                                 // Метка сокета
+    bool            m_wouldBlock = false;                   // Последняя операция не выполнена без блокировки
+    std::vector<char> m_frameBuf;                           // Буфер склейки кадра (см. sendFrames())
+
+protected: // static
+
+    static const size_t s_fileChunkSize;                    // Размер блока файла при копировании
 
 };
 
@@ -8,8 +8,16 @@
 
 #include "C_SocketFactory.h"
 
+#ifdef _WIN32
 #include "C_TcpSocket.h"
 #include "C_UdpSocket.h"
+#else
+#include "C_PosixTcpSocket.h"
+#include "C_PosixUdpSocket.h"
+#endif
+#ifdef __linux__
+#include "C_UringTcpSocket.h"
+#endif
 
 namespace network {
 
@@ -44,21 +52,43 @@ namespace network {
  *
  * @param
  *  [in] a_protocol  - тип протокола, сокет которого необходимо создать
- *  [in] a_sockType  - тип сокета (клиенсткий или серверный, см. common_types.h)
+ *  [in] a_backend   - реализация сокета (см. common_types.h)
  *
  * @return
  *  - указатель на сокет I_Socket, помещенный в std::shared_ptr<I_Socket>
+ *  - nullptr, если запрошенная реализация недоступна на текущей платформе
  */
 std::shared_ptr<I_Socket>
-C_SocketFactory::createSocket( E_Protocol a_protocol )
+C_SocketFactory::createSocket( E_Protocol a_protocol, E_SocketBackend a_backend )
 {
-    switch ( a_protocol ) {
-        case E_Protocol::TCP:
-            return std::make_shared<C_TcpSocket>();
-        case E_Protocol::UDP:
+    switch ( a_backend ) {
+#ifdef _WIN32
+        case E_SocketBackend::Native:
+        case E_SocketBackend::WinSock:
+            if ( a_protocol == E_Protocol::TCP ) {
+                return std::make_shared<C_TcpSocket>();
+            }
             return std::make_shared<C_UdpSocket>();
+#else
+        case E_SocketBackend::Native:
+        case E_SocketBackend::Posix:
+            if ( a_protocol == E_Protocol::TCP ) {
+                return std::make_shared<C_PosixTcpSocket>();
+            }
+            return std::make_shared<C_PosixUdpSocket>();
+#endif
+#ifdef __linux__
+        case E_SocketBackend::Uring:
+            if ( a_protocol == E_Protocol::TCP ) {
+                return std::make_shared<C_UringTcpSocket>();
+            }
+            // Для датаграмм пакетная отправка через io_uring не используется
+            g_log << "io_uring backend is TCP only, using posix udp socket" << std::endl;
+            return std::make_shared<C_PosixUdpSocket>();
+#endif
         default:
-            return std::make_shared<C_UdpSocket>();
+            g_log << "socket backend is not available on this platform" << std::endl;
+            return nullptr;
     }
 }
 
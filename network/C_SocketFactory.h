@@ -10,12 +10,12 @@
   * Класс имеет единственный статический метод
 
     std::shared_ptr<I_Socket>
-    createSocket( E_Protocol a_protocol, E_SocketType a_sockType )
+    createSocket( E_Protocol a_protocol, E_SocketBackend a_backend )
 
   * Метод конструирует сокет согласно переданным параметрам:
 
     1. Тип протокола: UDP/TCP (см. common_types.h)
-    2. Тип сокета: клиентский, серверный (см. common_types.h)
+    2. Реализация сокета: WinSock, Posix, Uring или родная для платформы (см. common_types.h)
 
 
   ИСПОЛЬЗОВАНИЕ
@@ -23,9 +23,9 @@
   * Для того, чтобы создать сокет, необходимо вызвать метод, например так:
 
     std::shared_ptr<I_Socket> socket =
-           C_SocketFactory::createSocket( E_Protocol::UDP, E_SocketType::Client );
+           C_SocketFactory::createSocket( E_Protocol::UDP, E_SocketBackend::Posix );
 
-    Тип сокета в рантайме будет C_UdpClientSocket
+    Тип сокета в рантайме будет C_PosixUdpSocket
 
 *******************************************************************************/
 
@@ -59,7 +59,8 @@ class C_SocketFactory
 public: //static
 
     // Фабричная функция для создания cокетов
-    static std::shared_ptr<I_Socket> createSocket( E_Protocol a_protocol );
+    static std::shared_ptr<I_Socket> createSocket( E_Protocol      a_protocol,
+                                                   E_SocketBackend a_backend = E_SocketBackend::Native );
 };
 
 /*****************************************************************************
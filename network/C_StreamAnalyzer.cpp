@@ -9,13 +9,67 @@
 
   * Нахождение указателей в буфере на каждый пакет осуществляется в закрытой
     функции doCalcIndex(), которая рекуррентно обходит буфер с данными и сохраняет
-    рассчитанные диапазоны пакетов в буфер.
+    смещения пакетов в компактный индекс (см. C_PacketIndex.h). Итераторы на
+    границы пакета рассчитываются из смещений при каждом обращении.
+
+  * Индекс строится по требованию: packetRange() размечает пакеты до запрошенного
+    включительно, продолжая с последнего размеченного пакета. Поэтому передачу
+    можно начинать, когда размечены только первые пакеты, а полный проход по файлу
+    выполняется лишь при вызове calcIndex() без параметров. Ошибка разметки
+    запоминается, и поврежденная часть файла повторно не обходится.
+
+  * Полный индекс файла размером от s_parallelMinSize рассчитывается в несколько
+    потоков (см. C_ParallelIndexer.h), если разметка еще не начата. Результат
+    совпадает с результатом последовательного обхода, включая остановку на
+    поврежденном пакете.
+
+  * Время пакетов возрастает только внутри потока (T_Packet::StreamNum): пакеты
+    разных потоков в файле перемежаются. Поэтому для поиска по времени для каждого
+    потока хранятся номера его пакетов и их времена (32 бита), а искомый пакет -
+    первый по порядку в файле среди найденных двоичным поиском в каждом потоке.
+    Массивы заполняются при первом поиске (и дополняются при последующих, если
+    индекс вырос). Для поиска размечается весь файл, поэтому до первого поиска
+    массивы память не занимают.
+
+  * Списки номеров пакетов каждого потока (streamPackets()) - те же списки,
+    что используются для поиска по времени: при первом обращении к ним
+    размечается весь файл, и списки дополняются пакетами, размеченными после
+    предыдущего обращения.
+
+  * Полный индекс может быть сохранен в файл индекса рядом с файлом данных и
+    загружен из него при следующем открытии файла (см. C_IndexFile.h).
+
+  * Заголовок файла и пакеты читаются через представления записей (см.
+    record_views.h), поэтому файл разбирается одинаково в ОС Windows и Linux.
+
+  * Разметчик может использоваться несколькими сессиями одновременно (см.
+    C_FileCache.h). Разметка, достраиваемые по требованию массивы (времена,
+    номера пакетов потоков, описания потоков) и сохранение индекса защищены
+    мьютексом m_mutex. Количество размеченных пакетов публикуется в m_indexed,
+    и пакеты с меньшими номерами packetRange() читает без захвата мьютекса:
+    память индекса резервируется сразу под все пакеты файла, поэтому смещения
+    размеченных пакетов не перемещаются при разметке следующих. Конец пакета
+    рассчитывается по его заголовку, а не по началу следующего пакета, который
+    может размечаться в этот момент.
+
+  * Описания потоков строятся по цифре типа протокола в идентификаторе формата
+    старых форматов. Заголовок файла не указывает, записана ли за ним таблица
+    StreamInfo формата Mes3 (в имеющихся файлах ее нет), поэтому она не
+    разбирается: тип протокола потоков Mes3 не определен, а первый пакет всегда
+    следует сразу за T_PacketFileHeader.
+
+  * Размер потока определяется перемещением позиции чтения в конец потока, поэтому
+    данные читаются с диска только один раз.
 
 *****************************************************************************/
 
 #include "C_StreamAnalyzer.h"
+#include "C_ParallelIndexer.h"
 
+#include <algorithm>
 #include <limits>
+#include <thread>
+
 
 namespace network {
 
@@ -39,26 +93,49 @@ namespace network {
   Variables Definitions
 *****************************************************************************/
 
+const std::size_t C_StreamAnalyzer::s_parallelMinSize = 64 * 1024 * 1024;   // Многопоточная разметка файлов от 64 megabytes
+const unsigned long C_StreamAnalyzer::s_maxStreams   = 256;                 // Номер потока T_Packet::StreamNum - один байт
+const std::size_t C_StreamAnalyzer::s_warmUpStep      = 4096;                // Не больше размера страницы памяти
+
 /*****************************************************************************
   Functions Definitions
 *****************************************************************************/
 
 /*****************************************************************************
  * Конструктор
+ *
+ * Данные потока a_stream загружаются в буфер a_buffer, который должен
+ * существовать, пока используется парсер
  */
 C_StreamAnalyzer::C_StreamAnalyzer( std::istream &a_stream,
                                     std::vector<char> &a_buffer )
-    : m_stream(a_stream), m_buffer(a_buffer)
 {
-    m_stream.ignore( std::numeric_limits<std::streamsize>::max() );
-    std::streamsize length = m_stream.gcount();
-    m_stream.clear();   //  Since ignore will have set eof
-    m_stream.seekg( 0, std::ios_base::beg );
+    a_stream.seekg( 0, std::ios_base::end );
+    std::streamoff length = a_stream.tellg();
+    a_stream.seekg( 0, std::ios_base::beg );
+    if ( length < 0 ) {
+        length = 0;
+    }
     g_log << "file size: " << length << std::endl;
 
-    m_buffer.clear();
-    m_buffer.resize(length);
-    m_stream.read( m_buffer.data(), length );
+    a_buffer.clear();
+    a_buffer.resize( static_cast<std::size_t>( length ) );
+    a_stream.read( a_buffer.data(), length );
+
+    m_data = a_buffer.data();
+    m_size = static_cast<std::size_t>( a_stream.gcount() );
+}
+
+/*****************************************************************************
+ * Конструктор
+ *
+ * @param
+ *  [in] a_data - данные файла
+ *  [in] a_size - размер данных файла
+ */
+C_StreamAnalyzer::C_StreamAnalyzer( const char *a_data, std::size_t a_size )
+    : m_data( a_data ), m_size( a_size )
+{
 }
 
 /*****************************************************************************
@@ -69,34 +146,76 @@ C_StreamAnalyzer::C_StreamAnalyzer( std::istream &a_stream,
  */
 C_StreamAnalyzer::range_t C_StreamAnalyzer::headerRange()
 {
-    return std::make_pair< iter_t, iter_t >
-           ( m_buffer.begin(), std::next( m_buffer.begin(),
-                                          sizeof(T_PacketFileHeader) ) );
+    if ( !fileHeader() ) {
+        g_log << "file is shorter than header" << std::endl;
+        return range_t{};
+    }
+    return { m_data, m_data + T_FileHeaderView::size() };
+}
+
+/*****************************************************************************
+ * Заголовок файла
+ *
+ * @return
+ *  - представление заголовка файла
+ *  - пустое представление, если файл короче заголовка
+ */
+T_FileHeaderView C_StreamAnalyzer::fileHeader() const
+{
+    return T_FileHeaderView( ( m_size < T_FileHeaderView::size() ) ? nullptr : m_data );
+}
+
+/*****************************************************************************
+ * Описания потоков файла
+ *
+ * Описания строятся при первом обращении. В старых форматах тип протокола всех
+ * потоков задается цифрой в идентификаторе формата, для формата Mes3 он не
+ * определен (E_StreamProto::Unknown)
+ *
+ * @return
+ *  - описания потоков в порядке номеров потоков
+ */
+const C_StreamAnalyzer::streams_t & C_StreamAnalyzer::streamInfo()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( !m_streamInfo.empty() || !fileHeader() ) {
+        return m_streamInfo;
+    }
+
+    T_FileHeaderView header = fileHeader();
+    unsigned long streamQuan = std::min<unsigned long>( header.streamQuan(), s_maxStreams );
+    m_streamInfo.resize( streamQuan );
+    for ( unsigned long i = 0; i < streamQuan; i++ ) {
+        T_StreamDesc &desc = m_streamInfo[i];
+        desc.StreamNum = static_cast<unsigned char>( i );
+        desc.Proto     = protoFromCode( static_cast<unsigned long>( header.type()[3] - '0' ) );
+    }
+    return m_streamInfo;
 }
 
 /*****************************************************************************
  * Границы пакета внутри файла
  *
+ * Если пакет еще не размечен, индекс расширяется до пакета a_packNo включительно
+ *
  * @param
  *  [in] a_packNo - номер пакета, границы которого необходимо получить
  *
  * @return
  *  - итераторы начала и конца пакета
+ *  - пара нулевых итераторов, если пакета нет или данные файла повреждены
  */
 C_StreamAnalyzer::range_t C_StreamAnalyzer::packetRange( std::size_t a_packNo )
 {
-    if ( m_index.size() == 0 ) {
-        g_log << "index is empty" << std::endl;
-        return range_t{};
-    }
-
-    if ( a_packNo < m_index.size() ) {
-        return m_index.at(a_packNo);
-    }
-    else {
-        g_log << "required packet index is out of range" << std::endl;
-        return range_t{};
+    if ( a_packNo >= m_indexed.load( std::memory_order_acquire ) ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( !doCalcIndex( a_packNo + 1 ) ) {
+            g_log << "required packet index is out of range" << std::endl;
+            return range_t{};
+        }
     }
+    iter_t begin = m_data + m_index.offset( a_packNo );
+    return { begin, begin + T_PacketView::headerSize() + T_PacketView( begin ).dataSize() };
 }
 
 /*****************************************************************************
@@ -107,14 +226,18 @@ C_StreamAnalyzer::range_t C_StreamAnalyzer::packetRange( std::size_t a_packNo )
  */
 unsigned long C_StreamAnalyzer::packetCount()
 {
-    return reinterpret_cast<T_PacketFileHeader*>( m_buffer.data() )->RecordsInFile;
+    T_FileHeaderView header = fileHeader();
+    return header ? header.recordsInFile() : 0;
 }
 
 /*****************************************************************************
  * Получение индекса с пакетами в буфере
  *
+ * Индекс разделяемого разметчика может дополняться другими сессиями, поэтому
+ * обращаться к нему следует после разметки всего файла (calcIndex())
+ *
  * @return
- *  - вектор с диапазонами пакетов
+ *  - смещения размеченных на данный момент пакетов
  */
 const C_StreamAnalyzer::index_t & C_StreamAnalyzer::index()
 {
@@ -125,24 +248,25 @@ const C_StreamAnalyzer::index_t & C_StreamAnalyzer::index()
  * Получение индекса с пакетами в буфере (перегруженная по константности версия функции)
  *
  * @return
- *  - вектор с диапазонами пакетов
+ *  - смещения размеченных на данный момент пакетов
  */
 const C_StreamAnalyzer::index_t & C_StreamAnalyzer::index() const
 {
     return m_index;
 }
 /*****************************************************************************
- * Получение указателя на пакет
+ * Получение пакета
  *
  * @param
- *  [in] a_packNum - номер необходимого пакета
+ *  [in] a_packNo - номер необходимого пакета
  *
  * @return
- *  - указатель на пакет
+ *  - представление пакета
+ *  - пустое представление, если пакета нет или данные файла повреждены
  */
-const T_Packet * C_StreamAnalyzer::getPacketPtr( unsigned long a_packNo )
+T_PacketView C_StreamAnalyzer::getPacket( unsigned long a_packNo )
 {
-    return iterToPtr( packetRange( a_packNo ).first );
+    return T_PacketView( packetRange( a_packNo ).first );
 }
 
 /*****************************************************************************
@@ -155,74 +279,372 @@ const T_Packet * C_StreamAnalyzer::getPacketPtr( unsigned long a_packNo )
  */
 bool C_StreamAnalyzer::calcIndex()
 {
-    return doCalcIndex();
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return doCalcIndexAll();
+}
+
+/*****************************************************************************
+ * Расчет границ первых пакетов внутри буфера с данными
+ *
+ * Остальные пакеты размечаются по мере обращения к ним (см. packetRange())
+ *
+ * @param
+ *  [in] a_packCount - количество пакетов, которые необходимо разметить
+ *
+ * @return
+ * Результат успешности расчета индекса
+ *  true  - расчет индекса произведен успешно
+ *  false - при расчете индекса произошла ошибка
+ */
+bool C_StreamAnalyzer::calcIndex( std::size_t a_packCount )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return doCalcIndex( std::min<std::size_t>( a_packCount, packetCount() ) );
+}
+
+/*****************************************************************************
+ * Расчет границ всех пакетов внутри буфера с данными в несколько потоков
+ *
+ * Если часть пакетов уже размечена, разметка продолжается последовательно
+ *
+ * @param
+ *  [in] a_threadCount - количество потоков (0 - определить автоматически)
+ *
+ * @return
+ * Результат успешности расчета индекса
+ *  true  - расчет индекса произведен успешно
+ *  false - при расчете индекса произошла ошибка
+ */
+bool C_StreamAnalyzer::calcIndexParallel( unsigned a_threadCount )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return doCalcIndexParallel( a_threadCount );
+}
+
+/*****************************************************************************
+ * Объем памяти, занимаемой файлом
+ *
+ * @return
+ *  - суммарный размер данных файла и выделенной под индекс памяти в байтах
+ */
+std::size_t C_StreamAnalyzer::memoryUsage()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_size + m_index.memoryUsage();
+}
+
+/*****************************************************************************
+ * Реализация расчета границ всех пакетов внутри буфера с данными
+ *
+ * Вызывается при захваченном мьютексе m_mutex
+ *
+ * @return
+ * Результат успешности расчета индекса
+ *  true  - расчет индекса произведен успешно
+ *  false - при расчете индекса произошла ошибка
+ */
+bool C_StreamAnalyzer::doCalcIndexAll()
+{
+    if ( m_index.empty() && m_size >= s_parallelMinSize ) {
+        return doCalcIndexParallel( std::thread::hardware_concurrency() );
+    }
+    return doCalcIndex( packetCount() );
+}
+
+/*****************************************************************************
+ * Реализация расчета границ всех пакетов в несколько потоков
+ *
+ * Вызывается при захваченном мьютексе m_mutex. Если часть пакетов уже
+ * размечена, разметка продолжается последовательно
+ *
+ * @param
+ *  [in] a_threadCount - количество потоков (0 - определить автоматически)
+ *
+ * @return
+ * Результат успешности расчета индекса
+ *  true  - расчет индекса произведен успешно
+ *  false - при расчете индекса произошла ошибка
+ */
+bool C_StreamAnalyzer::doCalcIndexParallel( unsigned a_threadCount )
+{
+    if ( !m_index.empty() || m_indexError || !fileHeader() ) {
+        return doCalcIndex( packetCount() );
+    }
+
+    // Номер потока проверяется, только если количество потоков в заголовке правдоподобно
+    unsigned long streamQuan = fileHeader().streamQuan();
+    C_ParallelIndexer indexer( m_data, m_size, T_FileHeaderView::size(), packetCount(),
+                               ( streamQuan > 0 && streamQuan <= s_maxStreams ) ? static_cast<unsigned>( streamQuan ) : 0 );
+
+    bool result = indexer.run( std::max( a_threadCount, 1u ), m_index );
+    if ( !result ) {
+        g_log << "Error occured while calculating m_index[" << m_index.size() << "]" << std::endl;
+        m_indexError = true;
+    }
+    m_indexed.store( m_index.size(), std::memory_order_release );
+    return result;
+}
+
+/*****************************************************************************
+ * Загрузка в память начала файла
+ *
+ * Страницы отображенного в память файла читаются с диска при первом обращении.
+ * Из каждой страницы первых a_size байт читается по одному байту, чтобы первые
+ * пакеты отправлялись без ожидания диска
+ *
+ * @param
+ *  [in] a_size - количество байт от начала файла
+ */
+void C_StreamAnalyzer::warmUp( std::size_t a_size ) const
+{
+    const volatile char *data = m_data;
+    std::size_t end = std::min( a_size, m_size );
+    for ( std::size_t offset = 0; offset < end; offset += s_warmUpStep ) {
+        static_cast<void>( data[offset] );
+    }
+}
+
+/*****************************************************************************
+ * Поиск пакета по времени
+ *
+ * Время пакетов не убывает внутри каждого потока, поэтому в каждом потоке первый
+ * пакет со временем не меньше a_time находится двоичным поиском, а результатом
+ * является наименьший из найденных номеров. Перед поиском размечаются все
+ * пакеты файла
+ *
+ * @param
+ *  [in] a_time - время в миллисекундах (в единицах T_Packet::Time)
+ *
+ * @return
+ *  - номер первого по порядку в файле пакета, время которого не меньше a_time
+ *  - index().size(), если все пакеты получены раньше a_time
+ */
+std::size_t C_StreamAnalyzer::findByTime( uint64_t a_time )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    doCalcIndexAll();
+    indexStreams();
+
+    std::size_t found = m_index.size();
+    for ( std::size_t stream = 0; stream < m_times.size(); stream++ ) {
+        const auto &times = m_times[stream];
+        auto it = std::lower_bound( times.begin(), times.end(), a_time,
+                                    []( uint32_t a_packetTime, uint64_t a_value ) { return a_packetTime < a_value; } );
+        if ( it != times.end() ) {
+            found = std::min<std::size_t>( found, m_streams[stream][ it - times.begin() ] );
+        }
+    }
+    return found;
+}
+
+/*****************************************************************************
+ * Дополнение номеров и времен пакетов каждого потока
+ *
+ * В списки вносятся пакеты, размеченные после предыдущего вызова
+ */
+void C_StreamAnalyzer::indexStreams()
+{
+    if ( m_streams.empty() ) {
+        m_streams.resize( std::numeric_limits<unsigned char>::max() + 1 );
+        m_times.resize( m_streams.size() );
+    }
+    for ( std::size_t i = m_streamsIndexed; i < m_index.size(); i++ ) {
+        T_PacketView packet( m_data + m_index.offset( i ) );
+        m_streams[packet.streamNum()].push_back( static_cast<uint32_t>( i ) );
+        m_times[packet.streamNum()].push_back( packet.time() );
+    }
+    m_streamsIndexed = m_index.size();
+}
+
+/*****************************************************************************
+ * Получение номеров пакетов потока
+ *
+ * Перед обращением размечаются все пакеты файла
+ *
+ * @param
+ *  [in] a_streamNum - номер потока (T_Packet::StreamNum)
+ *
+ * @return
+ *  - номера пакетов потока в порядке возрастания
+ */
+const C_StreamAnalyzer::postings_t & C_StreamAnalyzer::streamPackets( unsigned char a_streamNum )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    doCalcIndexAll();
+    indexStreams();
+    return m_streams[a_streamNum];
 }
 
 /*****************************************************************************
  * Реализация расчета границ пакетов внутри буфера с данными
  *
+ * Разметка продолжается с конца последнего размеченного пакета, поэтому
+ * каждый пакет обходится один раз
+ *
+ * @param
+ *  [in] a_packCount - количество пакетов, которые должны быть размечены
+ *
  * @return
  * Результат успешности расчета индекса
  *  true - расчет индекса произведен успешно
- *  false - при расчете индекса произошла ошибка
+ *  false - пакетов в файле меньше a_packCount или при расчете индекса произошла ошибка
  */
-bool C_StreamAnalyzer::doCalcIndex()
+bool C_StreamAnalyzer::doCalcIndex( std::size_t a_packCount )
 {
-    // Подсчет текущего количества проанализированных байт буфера
-    unsigned long currentByteSum = 0;
+    if ( m_index.size() >= a_packCount ) {
+        return true;
+    }
     // Нахождение количества пакетов в буфере
     unsigned long allPacketCount = packetCount();
-    m_index.resize(allPacketCount);
-
-    // Получение итераторов начала и конца заголовка буфера
-    range_t headIters = headerRange();
-    auto headSize = std::distance( headIters.first, headIters.second );
-    currentByteSum += headSize;
-    /* Для нахождения размера первого пакета необходимо найти указатель на начало этого пакета.
-     * Итератор на конец заголовка является итератором на начало первого пакета в буфере. Его
-     * можно привести к указателю на первый пакет.
+    if ( m_indexError || a_packCount > allPacketCount ) {
+        return false;
+    }
+
+    /* Конец заголовка является началом первого пакета в буфере,
+     * конец каждого следующего пакета - началом следующего.
+     * Память под индекс резервируется с учетом того, что количество пакетов в заголовке
+     * может не соответствовать размеру файла.
      */
-    const T_Packet* firstPacketPtr = iterToPtr( headIters.second );
-    auto firstPacketSize = sizeof(T_Packet) + firstPacketPtr->DataSize;
-    currentByteSum += firstPacketSize;
+    if ( m_index.empty() ) {
+        m_index.reserve( std::min<std::size_t>( allPacketCount,
+                                                ( m_size - T_FileHeaderView::size() ) / T_PacketView::headerSize() ) );
+    }
+    // Подсчет текущего количества проанализированных байт буфера
+    std::size_t currentByteSum = m_index.empty() ? T_FileHeaderView::size()
+                                                 : static_cast<std::size_t>( m_index.endOffset() );
+
+    // Поиск диапазонов пакетов в буфере
+    while ( m_index.size() < a_packCount ) {
+        // Проверка на валидность данных очередного пакета
+        std::size_t packetBegin   = currentByteSum;
+        std::size_t curPacketSize = T_PacketView::headerSize();
+        if ( currentByteSum + curPacketSize <= m_size ) {
+            curPacketSize += T_PacketView( m_data + packetBegin ).dataSize();
+        }
+        currentByteSum += curPacketSize;
+        if ( currentByteSum > m_size ) {
+            g_log << "Error occured while calculating m_index[" << m_index.size() << "]" << std::endl;
+            m_indexError = true;
+            break;
+        }
+
+        m_index.push_back( packetBegin, static_cast<uint32_t>( curPacketSize ) );
+    }
+    m_indexed.store( m_index.size(), std::memory_order_release );
+    return !m_indexError;
+}
 
-    // Проверка на валидность данных первого пакета
-    if ( currentByteSum > m_buffer.size() ) {
-        g_log << "Error occured while calculating m_index[" << 0 << "]" << std::endl;
+/*****************************************************************************
+ * Проверка того, что все пакеты файла размечены
+ *
+ * @return
+ *  true  - размечены все пакеты либо разметка остановлена на поврежденном пакете
+ *  false - часть пакетов будет размечена по требованию
+ */
+bool C_StreamAnalyzer::isIndexComplete()
+{
+    return m_indexError || m_index.size() == packetCount();
+}
+
+/*****************************************************************************
+ * Загрузка индекса из файла индекса
+ *
+ * Записи файла индекса проверяются на непрерывность цепочки пакетов и на выход
+ * за границы данных, поэтому несоответствующий данным индекс не будет загружен
+ * Индекс заменяется целиком, поэтому загружать его следует до передачи
+ * разметчика другим сессиям
+ *
+ * @param
+ *  [in] a_indexFile - загруженный файл индекса
+ *
+ * @return
+ *  true  - индекс загружен
+ *  false - файл индекса отсутствует или не соответствует данным
+ */
+bool C_StreamAnalyzer::loadIndex( const C_IndexFile &a_indexFile )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( !a_indexFile.isValid() || a_indexFile.count() > packetCount() ) {
         return false;
     }
 
-    // Получение диапазона первого пакета и запись его в индекс
-    m_index[0] = { headIters.second, std::next( headIters.second, firstPacketSize ) };
+    index_t index;
+    index.reserve( a_indexFile.count() );
+    uint64_t expected = T_FileHeaderView::size();
+    const C_IndexFile::T_Entry *entries = a_indexFile.entries();
+    for ( std::size_t i = 0; i < a_indexFile.count(); i++ ) {
+        const C_IndexFile::T_Entry &entry = entries[i];
+        if ( entry.Offset != expected || entry.Size < T_PacketView::headerSize() ||
+             entry.Offset + entry.Size > m_size ) {
+            g_log << "index entry " << i << " does not match file data" << std::endl;
+            return false;
+        }
+        index.push_back( entry.Offset, entry.Size );
+        expected += entry.Size;
+    }
 
-    // Поиск диапазонов всех пакетов в буфере
-    for( std::size_t i = 1; i < allPacketCount; i++ ) {
-         // Получение указателя на первый пакет
-         const T_Packet* curPacketPtr = iterToPtr( m_index[i - 1].second );
-         auto curPacketSize = sizeof(T_Packet) + curPacketPtr->DataSize;
-         currentByteSum += curPacketSize;
+    m_index.swap( index );
+    m_streams.clear();
+    m_times.clear();
+    m_streamsIndexed = 0;
+    // Файл индекса с меньшим числом записей сохранен для поврежденного файла
+    m_indexError  = m_index.size() < packetCount();
+    m_indexStored = true;
+    m_indexed.store( m_index.size(), std::memory_order_release );
+    return true;
+}
 
-         // Проверка на валидность данных i-ого пакета
-         if ( currentByteSum > m_buffer.size() ) {
-             g_log << "Error occured while calculating m_index[" << i << "]" << std::endl;
-             return false;
-         }
+/*****************************************************************************
+ * Сохранение индекса в файл индекса
+ *
+ * Индекс сохраняется, только если все пакеты размечены и индекс еще не был
+ * загружен из файла индекса или сохранен в него
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу данных
+ *
+ * @return
+ *  true  - файл индекса записан
+ *  false - индекс неполон, уже сохранен или произошла ошибка записи
+ */
+bool C_StreamAnalyzer::saveIndex( const std::string &a_filePath )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( m_indexStored || !isIndexComplete() ) {
+        return false;
+    }
 
-         m_index[i] = { m_index[i - 1].second,
-                        std::next( m_index[i - 1].second, curPacketSize ) };
+    std::vector<C_IndexFile::T_Entry> entries( m_index.size() );
+    for ( std::size_t i = 0; i < m_index.size(); i++ ) {
+        C_IndexFile::T_Entry &entry = entries[i];
+        entry.Offset    = m_index.offset( i );
+        T_PacketView packet( m_data + entry.Offset );
+        entry.Time      = packet.time();
+        entry.Size      = m_index.packetSize( i );
+        entry.StreamNum = packet.streamNum();
+        entry.Reserved[0] = entry.Reserved[1] = entry.Reserved[2] = 0;
     }
-    return true;
+
+    m_indexStored = C_IndexFile::write( a_filePath, entries );
+    return m_indexStored;
 }
 
 /*****************************************************************************
- * Преобразование итератора на некоторый пакет в указатель на этот пакет
+ * Преобразование кода типа протокола в тип протокола потока
+ *
+ * @param
+ *  [in] a_code - код типа протокола (1 - RS, 2 - Ethernet)
  *
  * @return
- *  - указатель на пакет
+ *  - тип протокола потока
  */
-const T_Packet * C_StreamAnalyzer::iterToPtr( C_StreamAnalyzer::iter_t a_iter )
+E_StreamProto C_StreamAnalyzer::protoFromCode( unsigned long a_code )
 {
-    return reinterpret_cast<const T_Packet*>( &( *a_iter ) );
+    switch ( a_code ) {
+        case 1:  return E_StreamProto::RS;
+        case 2:  return E_StreamProto::Ethernet;
+        default: return E_StreamProto::Unknown;
+    }
 }
 
 
@@ -10,6 +10,13 @@
   * Парсер позволяет анализировать буфер с данными и находить указатели и итераторы
     на каждый пакет в буфере
 
+  * Индекс хранит смещения пакетов от начала данных файла (см. C_PacketIndex.h),
+    итераторы на границы пакета рассчитываются при обращении к пакету
+
+  * Итераторы являются указателями на данные файла, поэтому один и тот же интерфейс
+    используется как для буфера, в который загружен файл, так и для файла,
+    отображенного в память (см. C_MappedStreamAnalyzer.h)
+
 
   ИСПОЛЬЗОВАНИЕ
 
@@ -26,7 +33,10 @@
 
     std::unique_ptr<C_StreamAnalyzer> m_packetProvider = std::make_unique<C_StreamAnalyzer>( m_file, m_data );
 
-  * Попытка расчитать индекс файла через вызов функции calcIndex():
+  * Попытка расчитать индекс файла через вызов функции calcIndex() (либо разметка
+    только первых пакетов вызовом calcIndex( 32 ), остальные пакеты будут размечены
+    при обращении к ним через packetRange()). Большие файлы размечаются функцией
+    calcIndex() в несколько потоков (см. C_ParallelIndexer.h):
 
     if ( m_packetProvider->calcIndex() ) {
         cout <<  "file indexed" << std::endl;
@@ -35,6 +45,29 @@
         cout << "problem with indexing file" << std::endl;
     }
 
+  * Загрузка индекса из файла индекса (см. C_IndexFile.h) и сохранение полного
+    индекса, если файл индекса отсутствует или устарел:
+
+    if ( !m_packetProvider->loadIndex( C_IndexFile( a_filePath ) ) ) {
+        m_packetProvider->calcIndex();
+        m_packetProvider->saveIndex( a_filePath );
+    }
+
+  * Получение номера первого пакета, полученного не раньше чем через 5 секунд
+    после первого пакета файла (размечается весь файл):
+
+    std::size_t packNo = m_packetProvider->findByTime( m_packetProvider->getPacket( 0 ).time() + 5000 );
+
+  * Получение номеров пакетов потока 2 (размечается весь файл):
+
+    const auto &packets = m_packetProvider->streamPackets( 2 );
+
+  * Получение описаний потоков файла (тип протокола задается форматом файла):
+
+    for ( const auto &stream : m_packetProvider->streamInfo() ) {
+        if ( stream.Proto == E_StreamProto::Ethernet ) { ... }
+    }
+
   * Получение пары итераторов на заголовок файла:
 
     auto headIters = m_packetProvider->headerRange();
@@ -50,6 +83,11 @@
   * Получение пакета под номером 100 (надо учесть чтобы индекс запрашиваемого пакета был меньше величины packetCount)
     int packetIndex = 100;
 
+  * Получение времени 100ого пакета (поля пакета читаются через представление,
+    см. record_views.h):
+
+    uint32_t time = m_packetProvider->getPacket(packetIndex).time();
+
   * Получение пары итераторов на 100ый пакет:
 
     auto iters = m_packetProvider->packetRange(packetIndex);
@@ -62,12 +100,17 @@
 
 #pragma once
 
+#include <atomic>
 #include <istream>
+#include <mutex>
 #include <vector>
 #include <utility>
 
 #include "C_Logger.h"
+#include "C_IndexFile.h"
+#include "C_PacketIndex.h"
 #include "common_types.h"
+#include "record_views.h"
 
 namespace network {
 
@@ -90,9 +133,17 @@ class C_StreamAnalyzer
 
 public: //types
 
-    using iter_t  = typename std::vector<char>::const_iterator;     // Итератор на начало/конец пакета
+    using iter_t  = const char *;                                   // Итератор на начало/конец пакета
     using range_t = std::pair< iter_t, iter_t >;                    // Тип диапазона пакета в буфере
-    using index_t = std::vector<range_t>;                           // Тип диапазонов всех пакетов в буфере
+    using index_t = C_PacketIndex;                                  // Тип индекса смещений всех пакетов в буфере
+    using postings_t = std::vector<uint32_t>;                       // Тип номеров пакетов одного потока
+
+    // Описание потока файла
+    struct T_StreamDesc {
+        unsigned char   StreamNum  = 0;                         // Номер потока (T_Packet::StreamNum)
+        E_StreamProto   Proto      = E_StreamProto::Unknown;    // Тип протокола
+    };
+    using streams_t = std::vector<T_StreamDesc>;                    // Тип описаний всех потоков файла
 
 public:
 
@@ -107,29 +158,91 @@ public:
 
     // Границы заголовка внутри буфера
     range_t headerRange();
+    // Заголовок файла
+    T_FileHeaderView fileHeader() const;
+    // Описания потоков файла
+    const streams_t & streamInfo();
     // Границы пакета внутри буфера
     range_t packetRange( std::size_t a_packNo );
     // Получение индекса с пакетами в буфере
     const index_t & index();
     // Получение индекса с пакетами в буфере (константная версия)
     const index_t & index() const;
-    // Получение указателя на пакет
-    const T_Packet * getPacketPtr( unsigned long a_packNo );
+    // Получение пакета
+    T_PacketView getPacket( unsigned long a_packNo );
     // Получение количества пакетов внутри буфера
     unsigned long packetCount();
     // Расчет границ пакетов внутри буфера с данными
     bool calcIndex();
+    // Расчет границ первых a_packCount пакетов (остальные - по требованию)
+    bool calcIndex( std::size_t a_packCount );
+    // Расчет границ всех пакетов в a_threadCount потоков
+    bool calcIndexParallel( unsigned a_threadCount );
+
+    // Номер первого пакета со временем не меньше a_time
+    std::size_t findByTime( uint64_t a_time );
+    // Номера пакетов потока a_streamNum
+    const postings_t & streamPackets( unsigned char a_streamNum );
+
+    // Все пакеты файла размечены (или разметка остановлена на поврежденном пакете)
+    bool isIndexComplete();
+    // Загрузка индекса из файла индекса
+    bool loadIndex( const C_IndexFile &a_indexFile );
+    // Сохранение индекса в файл индекса для файла данных a_filePath
+    bool saveIndex( const std::string &a_filePath );
+
+    // Переход воспроизведения к пакету a_packNo (для управления чтением файла)
+    virtual void setCursor( std::size_t ) {}
+    // Загрузка в память первых a_size байт файла
+    void warmUp( std::size_t a_size ) const;
+    // Объем памяти, занимаемой данными файла и индексом
+    std::size_t memoryUsage();
+
+    // Начало данных файла
+    const char * data() const { return m_data; }
+    // Размер данных файла в байтах
+    std::size_t size() const { return m_size; }
+
+protected:
+
+    // Разметка данных, расположенных в памяти a_data (для потомков)
+    C_StreamAnalyzer( const char *a_data, std::size_t a_size );
 
 private:
 
-    // Реализация расчета границ пакетов внутри буфера с данными
-    virtual bool doCalcIndex();
-    // Преобразование итератора на некоторый пакет в указатель на этот пакет
-    const T_Packet * iterToPtr( iter_t a_iter );
+    // Реализация расчета границ первых a_packCount пакетов внутри буфера с данными
+    virtual bool doCalcIndex( std::size_t a_packCount );
+    // Реализация расчета границ всех пакетов
+    bool doCalcIndexAll();
+    // Реализация расчета границ всех пакетов в a_threadCount потоков
+    bool doCalcIndexParallel( unsigned a_threadCount );
+    // Преобразование кода типа протокола в тип протокола потока
+    static E_StreamProto protoFromCode( unsigned long a_code );
+    // Дополнение номеров и времен пакетов каждого потока
+    void indexStreams();
+
+protected:
+
+    const char         *m_data = nullptr;   // Данные файла, которые необходимо разметить
+    std::size_t         m_size = 0;         // Размер данных файла
+
+private:
 
-    std::istream       &m_stream;       // Поток из которого считываются данные для индексации
-    std::vector<char>  &m_buffer;       // Ссылка на буфер с данными, который необходимо разметить
-    index_t             m_index;        // Диапазоны всех пакетов в буфере
+    index_t             m_index;            // Смещения размеченных пакетов в буфере
+    std::atomic<std::size_t> m_indexed{ 0 }; // Количество пакетов, читаемых без захвата m_mutex
+    std::vector<postings_t> m_streams;      // Номера первых размеченных пакетов каждого потока
+    std::vector<std::vector<uint32_t>> m_times; // Времена пакетов из m_streams (для поиска по времени)
+    std::size_t         m_streamsIndexed = 0;   // Количество пакетов, внесенных в m_streams
+    streams_t           m_streamInfo;       // Описания потоков файла
+    bool                m_indexError = false;   // Разметка остановлена на поврежденном пакете
+    bool                m_indexStored = false;  // Индекс загружен из файла индекса или сохранен в него
+    std::mutex          m_mutex;            // Защита разметки и достраиваемых по требованию массивов
+
+private: // static
+
+    static const std::size_t    s_parallelMinSize;  // Минимальный размер файла для многопоточной разметки
+    static const unsigned long  s_maxStreams;       // Максимальное количество потоков в файле
+    static const std::size_t    s_warmUpStep;       // Шаг чтения при загрузке начала файла
 
 };
 
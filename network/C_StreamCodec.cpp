@@ -0,0 +1,184 @@
+/*****************************************************************************
+
+  C_StreamCodec
+
+  Разметка кадров протокола передачи данных в потоке байтов TCP
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Выданные кадры не удаляются из буфера сразу: представления кадров
+    (T_NetPacketView) указывают в буфер, поэтому невыданный остаток переносится
+    в начало буфера только в space(), перед следующим приемом. Переносится
+    только неполный кадр, его размер меньше размера кадра.
+
+  * Если длина неполного кадра уже принята и кадр не помещается в буфер, буфер
+    увеличивается в space() до размера кадра, иначе прием в полностью
+    заполненный буфер был бы невозможен.
+
+*****************************************************************************/
+
+#include "C_StreamCodec.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const size_t C_StreamCodec::s_lengthSize      = sizeof(uint32_t);   // 4 байта big-endian
+const size_t C_StreamCodec::s_maxFrameSize    = 1024 * 1024;        // 1 megabyte
+const size_t C_StreamCodec::s_defaultCapacity = 64 * 1024;          // 64 kilobytes
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ *
+ * @param
+ *  [in] a_capacity - начальный размер буфера приема в байтах
+ */
+C_StreamCodec::C_StreamCodec( size_t a_capacity )
+    : m_buffer( std::max( a_capacity, s_lengthSize + sizeof(uint16_t) ) )
+{
+}
+
+/*****************************************************************************
+ * Формирование кадра с длиной
+ *
+ * @param
+ *  [in] a_head - заголовок пакета
+ *  [in] a_data - данные пакета (должны существовать до отправки кадра)
+ *  [in] a_size - размер данных
+ *
+ * @return
+ *  - кадр для отправки I_Socket::sendFrames()
+ */
+T_Frame C_StreamCodec::frame( Header a_head, const char *a_data, size_t a_size )
+{
+    uint32_t length = static_cast<uint32_t>( sizeof(uint16_t) + a_size );
+    uint16_t value  = static_cast<uint16_t>( a_head );
+
+    T_Frame frame;
+    frame.Head[0]  = static_cast<char>( length >> 24 );
+    frame.Head[1]  = static_cast<char>( length >> 16 );
+    frame.Head[2]  = static_cast<char>( length >> 8 );
+    frame.Head[3]  = static_cast<char>( length & 0xFF );
+    frame.Head[4]  = static_cast<char>( value >> 8 );
+    frame.Head[5]  = static_cast<char>( value & 0xFF );
+    frame.HeadSize = s_lengthSize + sizeof(uint16_t);
+    frame.Data     = a_data;
+    frame.Size     = a_size;
+    return frame;
+}
+
+/*****************************************************************************
+ * Свободная часть буфера для приема
+ *
+ * Представления ранее выданных кадров становятся недействительными
+ *
+ * @param
+ *  [out] a_capacity - размер свободной части буфера
+ *
+ * @return
+ *  - начало свободной части буфера
+ */
+char * C_StreamCodec::space( size_t &a_capacity )
+{
+    if ( m_begin != 0 ) {
+        std::memmove( m_buffer.data(), m_buffer.data() + m_begin, pending() );
+        m_end  -= m_begin;
+        m_begin = 0;
+    }
+
+    if ( pending() >= s_lengthSize ) {
+        const unsigned char *data = reinterpret_cast<const unsigned char*>( m_buffer.data() );
+        size_t length = ( size_t( data[0] ) << 24 ) | ( size_t( data[1] ) << 16 ) |
+                        ( size_t( data[2] ) << 8  ) |   size_t( data[3] );
+        size_t frameSize = s_lengthSize + std::min( length, s_maxFrameSize );
+        if ( frameSize > m_buffer.size() ) {
+            m_buffer.resize( frameSize );
+        }
+    }
+
+    a_capacity = m_buffer.size() - m_end;
+    return m_buffer.data() + m_end;
+}
+
+/*****************************************************************************
+ * Учет байтов, принятых в свободную часть буфера
+ *
+ * @param
+ *  [in] a_size - количество принятых байтов
+ */
+void C_StreamCodec::commit( size_t a_size )
+{
+    m_end = std::min( m_end + a_size, m_buffer.size() );
+}
+
+/*****************************************************************************
+ * Извлечение следующего полностью принятого кадра
+ *
+ * @param
+ *  [out] a_packet - представление кадра (указывает в буфер приема)
+ *
+ * @return
+ *  true  - кадр извлечен
+ *  false - полного кадра в буфере нет или разметка потока нарушена
+ */
+bool C_StreamCodec::next( T_NetPacketView &a_packet )
+{
+    if ( m_broken || pending() < s_lengthSize ) {
+        return false;
+    }
+
+    const char *data = m_buffer.data() + m_begin;
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>( data );
+    size_t length = ( size_t( bytes[0] ) << 24 ) | ( size_t( bytes[1] ) << 16 ) |
+                    ( size_t( bytes[2] ) << 8  ) |   size_t( bytes[3] );
+    if ( length < sizeof(uint16_t) || length > s_maxFrameSize ) {
+        m_broken = true;
+        return false;
+    }
+    if ( pending() < s_lengthSize + length ) {
+        return false;
+    }
+
+    a_packet = deserializeView( data + s_lengthSize, length );
+    m_begin += s_lengthSize + length;
+    return true;
+}
+
+/*****************************************************************************
+ * Сброс принятых данных и состояния ошибки
+ */
+void C_StreamCodec::reset()
+{
+    m_begin  = 0;
+    m_end    = 0;
+    m_broken = false;
+}
+
+} // namespace network
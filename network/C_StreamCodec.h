@@ -0,0 +1,127 @@
+/*****************************************************************************
+
+  C_StreamCodec
+
+  Разметка кадров протокола передачи данных в потоке байтов TCP
+
+
+  ОПИСАНИЕ
+
+  * Поток TCP не сохраняет границ отправленных кадров: один прием может
+    содержать несколько кадров или часть кадра. Поэтому по TCP каждый кадр
+    предваряется длиной:
+
+        [ длина, 4 байта big-endian ][ Header, 2 байта ][ данные ]
+
+    длина - количество байтов заголовка Header и данных. По UDP кадры
+    передаются без длины (граница кадра - граница датаграммы).
+
+  * Функция frame() формирует кадр с длиной для отправки I_Socket::sendFrames(),
+    данные кадра не копируются.
+
+  * Декодер накапливает принятые байты в собственном буфере: прием выполняется
+    сразу в свободную часть буфера (space()/commit()), после чего функция next()
+    выдает все полностью принятые кадры по одному. Неполный кадр остается в
+    буфере до следующего приема. Буфер увеличивается, если кадр больше буфера.
+
+  * Кадр с длиной меньше заголовка Header или больше s_maxFrameSize означает
+    нарушение разметки потока: декодер переходит в состояние ошибки (isBroken())
+    и больше не выдает кадров.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Отправка кадра:
+
+    T_Frame frame = C_StreamCodec::frame( Header::DataResp, data, size );
+    socket->sendFrames( &frame, 1 );
+
+  * Прием кадров:
+
+    size_t capacity = 0;
+    char  *space    = codec.space( capacity );
+    size_t received = 0;
+    if ( socket->recvInto( space, capacity, received ) ) {
+        codec.commit( received );
+    }
+    T_NetPacketView packet;
+    while ( codec.next( packet ) ) { ... данные packet действительны до space() ... }
+
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "common_types.h"
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Разметка кадров в потоке байтов TCP
+ */
+class C_StreamCodec
+{
+
+public:
+
+    explicit C_StreamCodec( size_t a_capacity = s_defaultCapacity );
+
+    // Формирование кадра с длиной (данные не копируются)
+    static T_Frame frame( Header a_head, const char *a_data, size_t a_size );
+
+    // Свободная часть буфера для приема
+    char * space( size_t &a_capacity );
+    // Учет a_size байтов, принятых в свободную часть буфера
+    void commit( size_t a_size );
+    // Извлечение следующего полностью принятого кадра
+    bool next( T_NetPacketView &a_packet );
+
+    // Количество принятых, но не выданных байтов
+    size_t pending() const { return m_end - m_begin; }
+    // Нарушена разметка потока
+    bool isBroken() const { return m_broken; }
+    // Сброс принятых данных и состояния ошибки
+    void reset();
+
+private:
+
+    std::vector<char>   m_buffer;           // Буфер приема
+    size_t              m_begin  = 0;       // Начало невыданных данных
+    size_t              m_end    = 0;       // Конец принятых данных
+    bool                m_broken = false;   // Нарушена разметка потока
+
+private: // static
+
+    static const size_t s_lengthSize;       // Размер поля длины кадра
+    static const size_t s_maxFrameSize;     // Максимальная длина кадра
+    static const size_t s_defaultCapacity;  // Размер буфера приема по умолчанию
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
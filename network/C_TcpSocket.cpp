@@ -65,6 +65,7 @@ void C_TcpSocket::close()
         closesocket( m_acceptedSocket );
         m_acceptedSocket = INVALID_SOCKET;
     }
+    m_unsent.clear();
 }
 
 /*****************************************************************************
@@ -75,51 +76,59 @@ void C_TcpSocket::close()
  *
  * @return
  *  Статус успешности отправки данных через сокет
- *  true  - отправка данных произошла успешно
+ *  true  - данные отправлены (неотправленный остаток будет дописан позже)
  *  false - во время отправки данных произошла ошибка
  */
 bool C_TcpSocket::send( const std::vector<char> &a_buff )
 {
+    m_wouldBlock = false;
+    if ( !flushUnsent() ) {
+        return false;
+    }
     auto numBytes = ::send( m_acceptedSocket,
                             a_buff.data(),
                             static_cast<int>( a_buff.size() ),
                             0 );
     if ( numBytes == SOCKET_ERROR ) {
+        updateWouldBlock();
 //        g_log << name() << "send: failed with error: "
 //                << WSAGetLastError() << std::endl;
         return false;
     }
-    else {
-        if ( static_cast<size_t>(numBytes) == a_buff.size() ) {
-//            g_log << name() << "send: the buffer with size=" << a_buff.size() <<  " is sent successfully\n";
-            return true;
-        }
-        else {
-//            g_log << name() << "send: not all buffer is sent but only " << numBytes << std::endl;
-            return false;
-        }
+    if ( static_cast<size_t>(numBytes) != a_buff.size() ) {
+//        g_log << name() << "send: not all buffer is sent but only " << numBytes << std::endl;
+        m_unsent.assign( a_buff.begin() + numBytes, a_buff.end() );
     }
+    return true;
 }
 
 /*****************************************************************************
  * Прием данных через сокет
  *
  * @param
- *  [out] a_buff- ссылка на буфер, в который пишутся данные из сокета
+ *  [out] a_data     - буфер, в который пишутся данные из сокета
+ *  [in]  a_capacity - размер буфера
+ *  [out] a_received - количество принятых байтов
  *
  * @return
  *  Статус успешности приема данных через сокет
  *  true  - прием данных произошел успешно
  *  false - во время приема данных произошла ошибка
  */
-bool C_TcpSocket::recv( std::vector<char> &a_buff )
+bool C_TcpSocket::recvInto( char *a_data, size_t a_capacity, size_t &a_received )
 {
+    if ( !m_unsent.empty() ) {
+        flushUnsent();
+    }
+
+    m_wouldBlock = false;
     auto numBytes =  ::recv( m_acceptedSocket,
-                             a_buff.data(),
-                             static_cast<int>( a_buff.size() ),
+                             a_data,
+                             static_cast<int>( a_capacity ),
                              0 );
 
     if ( numBytes == SOCKET_ERROR ) {
+        updateWouldBlock();
 //        g_log << name() << "recv: failed with error: "
 //                << WSAGetLastError() << std::endl;
         return false;
@@ -130,10 +139,75 @@ bool C_TcpSocket::recv( std::vector<char> &a_buff )
     }
     else {
 //        g_log <<  name() << "recv: received bytes in packet: " << numBytes << std::endl;
+        a_received = static_cast<size_t>( numBytes );
         return true;
     }
 }
 
+/*****************************************************************************
+ * Отправка части файла
+ *
+ * Блок файла отправляется только после неотправленного остатка, чтобы не
+ * нарушить порядок данных в потоке (см. C_Socket::sendFile())
+ *
+ * @param
+ *  [in]     a_fd     - дескриптор файла, открытого на чтение
+ *  [in,out] a_offset - смещение первого неотправленного байта в файле
+ *  [in,out] a_count  - количество байтов, которое осталось отправить
+ *
+ * @return
+ *  Статус успешности отправки (см. C_Socket::sendFile())
+ */
+bool C_TcpSocket::sendFile( int a_fd, uint64_t &a_offset, size_t &a_count )
+{
+    m_wouldBlock = false;
+    if ( !flushUnsent() ) {
+        return false;
+    }
+    return C_Socket::sendFile( a_fd, a_offset, a_count );
+}
+
+/*****************************************************************************
+ * Дозапись неотправленного остатка
+ *
+ * @return
+ *  true  - все данные переданы ядру
+ *  false - остаток дописан не полностью (wouldBlock() == true), либо произошла ошибка
+ */
+bool C_TcpSocket::submit()
+{
+    m_wouldBlock = false;
+    return flushUnsent();
+}
+
+/*****************************************************************************
+ * Дозапись неотправленного остатка в сокет
+ *
+ * @return
+ *  true  - остатка нет
+ *  false - остаток дописан не полностью (wouldBlock() == true), либо произошла ошибка
+ */
+bool C_TcpSocket::flushUnsent()
+{
+    if ( m_unsent.empty() ) {
+        return true;
+    }
+    auto numBytes = ::send( m_acceptedSocket,
+                            m_unsent.data(),
+                            static_cast<int>( m_unsent.size() ),
+                            0 );
+    if ( numBytes == SOCKET_ERROR ) {
+        updateWouldBlock();
+        return false;
+    }
+    m_unsent.erase( m_unsent.begin(), m_unsent.begin() + numBytes );
+    if ( !m_unsent.empty() ) {
+        m_wouldBlock = true;
+        return false;
+    }
+    return true;
+}
+
 /*****************************************************************************
  * Вызов системного API для создания сокета нужного типа
  *
@@ -211,6 +285,19 @@ bool C_TcpSocket::connect()
     }
 }
 
+/*****************************************************************************
+ * Системный дескриптор рабочего сокета
+ *
+ * @return
+ *  - дескриптор принятого соединения, если оно установлено, иначе - дескриптор
+ *    слушающего (для сервера) или подключаемого (для клиента) сокета
+ */
+int C_TcpSocket::handle() const
+{
+    return static_cast<int>( m_acceptedSocket != INVALID_SOCKET ? m_acceptedSocket
+                                                                : m_masterSock );
+}
+
 /*****************************************************************************
  * Установка соединения с сервером (если класс представляет клиентский сокет)
  *
@@ -224,6 +311,7 @@ bool C_TcpSocket::connectToServer()
     g_log << name() << "start connecting..." << std::endl;
 
     // Устанавливаем соединение с сервером
+    m_wouldBlock = false;
     int retVal = ::connect( m_masterSock,
                             reinterpret_cast<sockaddr*>(&m_peerService),
                             sizeof (m_peerService) );
@@ -241,6 +329,7 @@ bool C_TcpSocket::connectToServer()
         return true;
     }
     else {
+        updateWouldBlock();
 //        g_log << name() << "connect() failed with error: "
 //                << WSAGetLastError() << std::endl;
         return false;
@@ -304,10 +393,12 @@ bool C_TcpSocket::accept()
 {
     g_log << name() << "start accepting" << std::endl;
 
+    m_wouldBlock = false;
     m_acceptedSocket = ::accept( m_masterSock, nullptr, nullptr );
 
     if ( m_acceptedSocket == INVALID_SOCKET ) {
-        if ( WSAGetLastError() == WSAEWOULDBLOCK ) {
+        updateWouldBlock();
+        if ( m_wouldBlock ) {
             g_log << name() << "No pending connections" << std::endl;
         }
         else {
@@ -10,6 +10,12 @@
   * TCP-сокет представляет собой сетевой интерфейс для взаимодействия по
     TCP-протоколу
 
+  * Частичная отправка не нарушает разметку потока (см. C_StreamCodec.h):
+    неотправленный остаток копируется в m_unsent, данные считаются
+    отправленными, а остаток дописывается в сокет раньше любых новых данных
+    и при приеме. Пока остаток не дописан, функции отправки и submit()
+    возвращают false, а wouldBlock() - true
+
 
   ИСПОЛЬЗОВАНИЕ
 
@@ -65,11 +71,18 @@ public:
      */
 
     virtual bool send( const std::vector<char> &a_buff ) override;
-    virtual bool recv(       std::vector<char> &a_buff ) override;
+    virtual bool recvInto( char *a_data, size_t a_capacity, size_t &a_received ) override;
+    // Отправка части файла (после дозаписи неотправленного остатка)
+    virtual bool sendFile( int a_fd, uint64_t &a_offset, size_t &a_count ) override;
+    // Дозапись неотправленного остатка
+    virtual bool submit() override;
 
     // Инициализация соединения
     virtual bool connect() override;
 
+    // Системный дескриптор рабочего сокета
+    virtual int handle() const override;
+
 protected:
 
     // Установка соединения с сервером (для клиентского сокета)
@@ -89,11 +102,16 @@ private:
     // Принятие соединения
     bool accept();
 
+    // Дозапись неотправленного остатка в сокет
+    bool flushUnsent();
+
 private:
 
-    SOCKET  m_acceptedSocket;       // Файловый дескриптор сокета приема-отправки
+    SOCKET  m_acceptedSocket = INVALID_SOCKET; // Файловый дескриптор сокета приема-отправки
     int     m_backlog = 5;          // Количество возможных соединений
 
+    std::vector<char> m_unsent;     // Неотправленный остаток потока
+
 };
 
 /*****************************************************************************
@@ -57,6 +57,7 @@ bool C_UdpSocket::send( const std::vector<char> &a_buff )
 {
     int socketAddrSize = sizeof( m_peerService );
 
+    m_wouldBlock = false;
     auto numBytes = sendto( m_masterSock,
                             a_buff.data(),
                             a_buff.size(),
@@ -65,6 +66,7 @@ bool C_UdpSocket::send( const std::vector<char> &a_buff )
                             socketAddrSize );
 
     if ( numBytes == SOCKET_ERROR ) {
+        updateWouldBlock();
 //        g_log << name() << "send: failed with error: "
 //                << WSAGetLastError() << std::endl;
         return false;
@@ -85,26 +87,28 @@ bool C_UdpSocket::send( const std::vector<char> &a_buff )
  * Прием данных через сокет
  *
  * @param
- *  [out] a_buff - ссылка на буфер, в который помещаются принятые данные из сокета
+ *  [out] a_data     - буфер, в который помещаются принятые данные из сокета
+ *  [in]  a_capacity - размер буфера
+ *  [out] a_received - количество принятых байтов
  *
  * @return
  *  recvStat - статус успешности приема
  *  recvStat != SOCKET_ERROR - прием произошел успешно
  */
-bool C_UdpSocket::recv( std::vector<char> &a_buff )
+bool C_UdpSocket::recvInto( char *a_data, size_t a_capacity, size_t &a_received )
 {
     int socketAddrSize = sizeof( m_peerService );
 
-    memset( a_buff.data(), 0, a_buff.size() );
-
+    m_wouldBlock = false;
     auto numBytes = ::recvfrom( m_masterSock,
-                                a_buff.data(),
-                                static_cast<int>( a_buff.size() ),
+                                a_data,
+                                static_cast<int>( a_capacity ),
                                 0,
                                 reinterpret_cast<struct sockaddr*>(&m_peerService),
                                 &socketAddrSize );
 
     if ( numBytes == SOCKET_ERROR ) {
+        updateWouldBlock();
 //        g_log << name() << "recv: failed with error: "
 //                << WSAGetLastError() << std::endl;
         return false;
@@ -115,6 +119,7 @@ bool C_UdpSocket::recv( std::vector<char> &a_buff )
     }
     else {
 //        g_log <<  name() << "recv: received bytes in packet: " << numBytes << std::endl;
+        a_received = static_cast<size_t>( numBytes );
         return true;
     }
 }
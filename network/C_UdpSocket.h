@@ -58,7 +58,7 @@ public:
      */
 
     virtual bool send( const std::vector<char> &a_buff ) override;
-    virtual bool recv(       std::vector<char> &a_buff ) override;
+    virtual bool recvInto( char *a_data, size_t a_capacity, size_t &a_received ) override;
 
     // Инициализация подключения (заглушка для UDP-протокола)
     virtual bool connect() override { return true; }
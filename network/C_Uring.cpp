@@ -0,0 +1,239 @@
+/*****************************************************************************
+
+  C_Uring
+
+  Минимальная обертка над кольцами io_uring (ОС Linux)
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Индексы голов и хвостов колец разделяются с ядром, поэтому чтение индексов,
+    изменяемых ядром, выполняется с семантикой acquire, а публикация своих
+    индексов - с семантикой release.
+
+  * Записи SQE заполняются локально (m_sqeTail) и публикуются в кольцо SQ только
+    в момент вызова submit(), поэтому до этого момента ядро их не видит.
+
+*****************************************************************************/
+
+#include "C_Uring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ *
+ * @param
+ *  [in] a_entries - размер очереди отправки (степень двойки)
+ */
+C_Uring::C_Uring( unsigned a_entries )
+{
+    io_uring_params params;
+    memset( &params, 0, sizeof(params) );
+
+    int fd = static_cast<int>( syscall( __NR_io_uring_setup, a_entries, &params ) );
+    if ( fd < 0 ) {
+        return;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes  + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+    if ( singleMmap && m_cqRingSize > m_sqRingSize ) {
+        m_sqRingSize = m_cqRingSize;
+    }
+
+    m_sqRing = mmap( nullptr, m_sqRingSize, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    if ( m_sqRing == MAP_FAILED ) {
+        m_sqRing = nullptr;
+        ::close( fd );
+        return;
+    }
+
+    if ( singleMmap ) {
+        m_cqRing = m_sqRing;
+    }
+    else {
+        m_cqRing = mmap( nullptr, m_cqRingSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+        if ( m_cqRing == MAP_FAILED ) {
+            m_cqRing = nullptr;
+            munmap( m_sqRing, m_sqRingSize );
+            m_sqRing = nullptr;
+            ::close( fd );
+            return;
+        }
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap( nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if ( sqes == MAP_FAILED ) {
+        if ( m_cqRing != m_sqRing ) {
+            munmap( m_cqRing, m_cqRingSize );
+        }
+        munmap( m_sqRing, m_sqRingSize );
+        m_sqRing = m_cqRing = nullptr;
+        ::close( fd );
+        return;
+    }
+    m_sqes = static_cast<io_uring_sqe*>( sqes );
+
+    char *sq = static_cast<char*>( m_sqRing );
+    m_sqHead    = reinterpret_cast<unsigned*>( sq + params.sq_off.head );
+    m_sqTail    = reinterpret_cast<unsigned*>( sq + params.sq_off.tail );
+    m_sqMask    = reinterpret_cast<unsigned*>( sq + params.sq_off.ring_mask );
+    m_sqArray   = reinterpret_cast<unsigned*>( sq + params.sq_off.array );
+    m_sqEntries = params.sq_entries;
+
+    char *cq = static_cast<char*>( m_cqRing );
+    m_cqHead = reinterpret_cast<unsigned*>( cq + params.cq_off.head );
+    m_cqTail = reinterpret_cast<unsigned*>( cq + params.cq_off.tail );
+    m_cqMask = reinterpret_cast<unsigned*>( cq + params.cq_off.ring_mask );
+    m_cqes   = reinterpret_cast<io_uring_cqe*>( cq + params.cq_off.cqes );
+
+    m_sqeHead = m_sqeTail = __atomic_load_n( m_sqTail, __ATOMIC_ACQUIRE );
+    m_ringFd  = fd;
+}
+
+/*****************************************************************************
+ * Деструктор
+ */
+C_Uring::~C_Uring()
+{
+    if ( m_sqes ) {
+        munmap( m_sqes, m_sqesSize );
+    }
+    if ( m_cqRing && m_cqRing != m_sqRing ) {
+        munmap( m_cqRing, m_cqRingSize );
+    }
+    if ( m_sqRing ) {
+        munmap( m_sqRing, m_sqRingSize );
+    }
+    if ( m_ringFd >= 0 ) {
+        ::close( m_ringFd );
+    }
+}
+
+/*****************************************************************************
+ * Регистрация буферов для операций IORING_OP_READ_FIXED/IORING_OP_WRITE_FIXED
+ *
+ * @param
+ *  [in] a_buffers - описания регистрируемых буферов
+ *
+ * @return
+ *  true  - буферы зарегистрированы
+ *  false - ошибка регистрации
+ */
+bool C_Uring::registerBuffers( const std::vector<iovec> &a_buffers )
+{
+    if ( !isValid() ) {
+        return false;
+    }
+    long rc = syscall( __NR_io_uring_register, m_ringFd, IORING_REGISTER_BUFFERS,
+                       a_buffers.data(), static_cast<unsigned>( a_buffers.size() ) );
+    return rc == 0;
+}
+
+/*****************************************************************************
+ * Получение свободной записи очереди отправки
+ *
+ * @return
+ *  - указатель на обнуленную запись SQE
+ *  - nullptr, если очередь отправки заполнена
+ */
+io_uring_sqe * C_Uring::getSqe()
+{
+    unsigned head = __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE );
+    if ( m_sqeTail - head >= m_sqEntries ) {
+        return nullptr;
+    }
+    io_uring_sqe *sqe = &m_sqes[ m_sqeTail & *m_sqMask ];
+    m_sqeTail++;
+    memset( sqe, 0, sizeof(*sqe) );
+    return sqe;
+}
+
+/*****************************************************************************
+ * Отправка заполненных записей ядру и ожидание завершений
+ *
+ * @param
+ *  [in] a_waitNr - количество завершений, которые необходимо дождаться
+ *
+ * @return
+ *  >= 0 - количество принятых ядром записей
+ *  < 0  - код ошибки (-errno)
+ */
+int C_Uring::submit( unsigned a_waitNr )
+{
+    unsigned tail = *m_sqTail;
+    for ( ; m_sqeHead != m_sqeTail; m_sqeHead++, tail++ ) {
+        m_sqArray[ tail & *m_sqMask ] = m_sqeHead & *m_sqMask;
+    }
+    __atomic_store_n( m_sqTail, tail, __ATOMIC_RELEASE );
+
+    // Учитываются и записи, не принятые ядром при предыдущих вызовах
+    unsigned toSubmit = tail - __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE );
+
+    unsigned flags = a_waitNr ? IORING_ENTER_GETEVENTS : 0;
+    long rc;
+    do {
+        rc = syscall( __NR_io_uring_enter, m_ringFd, toSubmit, a_waitNr, flags, nullptr, 0 );
+    } while ( rc < 0 && errno == EINTR );
+
+    return rc < 0 ? -errno : static_cast<int>( rc );
+}
+
+/*****************************************************************************
+ * Извлечение очередного завершения
+ *
+ * @param
+ *  [out] a_cqe - копия записи завершения
+ *
+ * @return
+ *  true  - завершение извлечено
+ *  false - очередь завершений пуста
+ */
+bool C_Uring::popCqe( io_uring_cqe &a_cqe )
+{
+    unsigned head = *m_cqHead;
+    if ( head == __atomic_load_n( m_cqTail, __ATOMIC_ACQUIRE ) ) {
+        return false;
+    }
+    a_cqe = m_cqes[ head & *m_cqMask ];
+    __atomic_store_n( m_cqHead, head + 1, __ATOMIC_RELEASE );
+    return true;
+}
+
+} // namespace network
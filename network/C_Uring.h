@@ -0,0 +1,133 @@
+/*****************************************************************************
+
+  C_Uring
+
+  Минимальная обертка над кольцами io_uring (ОС Linux)
+
+
+  ОПИСАНИЕ
+
+  * Класс создает экземпляр io_uring системным вызовом io_uring_setup(),
+    отображает в память очереди отправки (SQ) и завершения (CQ) и предоставляет
+    функции для заполнения записей SQE, пакетной отправки их ядру одним вызовом
+    io_uring_enter() и чтения завершений CQE.
+
+  * Поддерживается регистрация буферов (IORING_REGISTER_BUFFERS) для операций
+    IORING_OP_READ_FIXED/IORING_OP_WRITE_FIXED.
+
+  * Библиотека liburing не требуется, используются только заголовки ядра.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Создание кольца на 64 записи:
+
+    C_Uring ring( 64 );
+    if ( !ring.isValid() ) { ... io_uring недоступен ... }
+
+  * Заполнение записи и отправка всех накопленных записей с ожиданием их завершения:
+
+    io_uring_sqe *sqe = ring.getSqe();
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    ...
+    ring.submit( ring.pending() );
+
+  * Чтение завершений:
+
+    io_uring_cqe cqe;
+    while ( ring.popCqe( cqe ) ) { ... }
+
+*****************************************************************************/
+
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#include <cstddef>
+#include <vector>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Минимальная обертка над кольцами io_uring
+ */
+class C_Uring
+{
+
+public:
+
+    explicit C_Uring( unsigned a_entries );
+    ~C_Uring();
+
+    C_Uring( const C_Uring&  ) = delete;
+    C_Uring(       C_Uring&& ) = delete;
+    C_Uring & operator = ( const C_Uring&  ) = delete;
+    C_Uring & operator = (       C_Uring&& ) = delete;
+
+    // Кольцо успешно создано
+    bool isValid() const { return m_ringFd >= 0; }
+
+    // Регистрация буферов для операций *_FIXED
+    bool registerBuffers( const std::vector<iovec> &a_buffers );
+
+    // Получение свободной записи очереди отправки (обнуленной)
+    io_uring_sqe * getSqe();
+    // Количество заполненных, но не отправленных ядру записей
+    unsigned pending() const { return m_sqeTail - m_sqeHead; }
+    // Отправка заполненных записей ядру и ожидание a_waitNr завершений
+    int submit( unsigned a_waitNr );
+    // Извлечение очередного завершения
+    bool popCqe( io_uring_cqe &a_cqe );
+
+private:
+
+    int                 m_ringFd   = -1;            // Дескриптор io_uring
+
+    // Очередь отправки
+    void               *m_sqRing   = nullptr;       // Отображение кольца SQ
+    std::size_t         m_sqRingSize = 0;           // Размер отображения кольца SQ
+    unsigned           *m_sqHead   = nullptr;
+    unsigned           *m_sqTail   = nullptr;
+    unsigned           *m_sqMask   = nullptr;
+    unsigned           *m_sqArray  = nullptr;
+    io_uring_sqe       *m_sqes     = nullptr;       // Массив записей SQE
+    std::size_t         m_sqesSize = 0;             // Размер отображения массива SQE
+    unsigned            m_sqEntries = 0;            // Количество записей в кольце SQ
+    unsigned            m_sqeHead  = 0;             // Первая не отправленная ядру запись
+    unsigned            m_sqeTail  = 0;             // Следующая свободная запись
+
+    // Очередь завершения
+    void               *m_cqRing   = nullptr;       // Отображение кольца CQ (совпадает с SQ при SINGLE_MMAP)
+    std::size_t         m_cqRingSize = 0;           // Размер отображения кольца CQ
+    unsigned           *m_cqHead   = nullptr;
+    unsigned           *m_cqTail   = nullptr;
+    unsigned           *m_cqMask   = nullptr;
+    io_uring_cqe       *m_cqes     = nullptr;
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
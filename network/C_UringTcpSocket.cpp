@@ -0,0 +1,555 @@
+/*****************************************************************************
+
+  C_UringTcpSocket
+
+  Класс TCP-сокета, выполняющий отправку и прием данных через io_uring
+  (ОС Linux)
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Пул буферов обмена m_bufPool состоит из s_sendBufCount буферов отправки и
+    одного буфера приема (последнего). Размер каждого буфера равен размеру буфера
+    обмена сервера и клиента (8 килобайт). Пул регистрируется в ядре один раз
+    в конструкторе; если регистрация невозможна (например, из-за ограничения
+    RLIMIT_MEMLOCK), используются обычные операции IORING_OP_WRITE/IORING_OP_READ.
+
+  * Отправки передаются ядру с ожиданием всех завершений: благодаря флагу
+    RWF_NOWAIT ядро не откладывает операции, а завершает их сразу, возвращая
+    -EAGAIN при заполненном буфере сокета.
+
+  * Неотправленный остаток потока m_tail дописывается обычным вызовом send()
+    раньше любых новых данных, поэтому порядок байтов в потоке не нарушается.
+
+  * Без RWF_NOWAIT ядро откладывало бы отправку в заполненный сокет, и
+    flushRing() ожидал бы ее завершения, блокируя поток. Поэтому при первом
+    завершении с -EOPNOTSUPP io_uring отключается: неотправленный остаток
+    переносится в остаток C_PosixTcpSocket (m_unsent), и дальнейший обмен
+    выполняется обычными вызовами.
+
+  * Данные, принятые тем же вызовом io_uring_enter(), в котором завершилась
+    ошибкой отправка, выдаются recv(): ошибка отправки будет получена при
+    следующей отправке.
+
+*****************************************************************************/
+
+#include "C_UringTcpSocket.h"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <cerrno>
+#include <cstring>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const unsigned C_UringTcpSocket::s_ringEntries  = 64;           // Размер очереди отправки io_uring
+const unsigned C_UringTcpSocket::s_sendBufCount = 32;           // Количество буферов отправки
+const size_t   C_UringTcpSocket::s_regBufSize   = 8 * 1024;     // Размер буфера обмена 8 kilobytes
+const uint64_t C_UringTcpSocket::s_recvTag      = ~0ull;        // Метка записи приема
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ *
+ * Создание колец io_uring и регистрация пула буферов обмена
+ */
+C_UringTcpSocket::C_UringTcpSocket()
+                 : m_ring( s_ringEntries )
+{
+    m_name = "uring tcp socket";
+
+    if ( !m_ring.isValid() ) {
+        g_log << "io_uring is not available, falling back to send/recv" << std::endl;
+        return;
+    }
+
+    m_bufPool.resize( ( s_sendBufCount + 1 ) * s_regBufSize );
+
+    std::vector<iovec> buffers( s_sendBufCount + 1 );
+    for ( unsigned idx = 0; idx < buffers.size(); idx++ ) {
+        buffers[idx].iov_base = &m_bufPool[ idx * s_regBufSize ];
+        buffers[idx].iov_len  = s_regBufSize;
+    }
+    m_fixedBuffers = m_ring.registerBuffers( buffers );
+    if ( !m_fixedBuffers ) {
+        g_log << "io_uring buffers are not registered, using unregistered buffers" << std::endl;
+    }
+
+    for ( unsigned idx = s_sendBufCount; idx > 0; idx-- ) {
+        m_freeBufs.push_back( idx - 1 );
+    }
+    m_writes.reserve( s_sendBufCount );
+}
+
+/*****************************************************************************
+ * Деструктор
+ */
+C_UringTcpSocket::~C_UringTcpSocket()
+{
+    close();
+}
+
+/*****************************************************************************
+ * Закрытие сокета
+ *
+ * Накопленные отправки передаются ядру до закрытия дескриптора
+ */
+void C_UringTcpSocket::close()
+{
+    if ( m_acceptedSocket >= 0 ) {
+        submit();
+    }
+    m_writes.clear();
+    m_tail.clear();
+    m_lastWrite = nullptr;
+    C_PosixTcpSocket::close();
+}
+
+/*****************************************************************************
+ * Отправка данных через сокет
+ *
+ * Данные копируются в буферы отправки, системный вызов откладывается до submit()
+ *
+ * @param
+ *  [in] a_buff - ссылка на буфер, данные из которого отправляются по сокету
+ *
+ * @return
+ *  true  - данные приняты к отправке
+ *  false - данные не приняты: остаток предыдущих отправок не может быть
+ *          отправлен без блокировки (wouldBlock() == true) или произошла ошибка
+ */
+bool C_UringTcpSocket::send( const std::vector<char> &a_buff )
+{
+    if ( !useRing() ) {
+        return C_PosixTcpSocket::send( a_buff );
+    }
+
+    m_wouldBlock = false;
+    if ( !m_tail.empty() && !flushTail() ) {
+        return false;
+    }
+    return queueData( a_buff.data(), a_buff.size() );
+}
+
+/*****************************************************************************
+ * Отправка кадра из заголовка и полезной нагрузки
+ *
+ * Отправка без копирования для io_uring не используется: заголовок и нагрузка
+ * копируются в буферы отправки так же, как в send(), но без склейки кадра
+ * в промежуточном векторе
+ *
+ * @param
+ *  [in] a_frame - кадр
+ *
+ * @return
+ *  true  - кадр принят к отправке
+ *  false - кадр не принят (см. send())
+ */
+bool C_UringTcpSocket::sendZeroCopy( const T_Frame &a_frame )
+{
+    if ( !useRing() ) {
+        return C_PosixTcpSocket::sendZeroCopy( a_frame );
+    }
+    return sendFrames( &a_frame, 1 ) == 1;
+}
+
+/*****************************************************************************
+ * Отправка кадров
+ *
+ * Заголовок и данные каждого кадра копируются в буферы отправки без склейки
+ * кадра в промежуточном векторе
+ *
+ * @param
+ *  [in] a_frames - кадры
+ *  [in] a_count  - количество кадров
+ *
+ * @return
+ *  - количество кадров, принятых к отправке
+ */
+size_t C_UringTcpSocket::sendFrames( const T_Frame *a_frames, size_t a_count )
+{
+    if ( !useRing() ) {
+        return C_PosixTcpSocket::sendFrames( a_frames, a_count );
+    }
+
+    m_wouldBlock = false;
+    if ( !m_tail.empty() && !flushTail() ) {
+        return 0;
+    }
+    size_t queued = 0;
+    for ( ; queued < a_count; queued++ ) {
+        const T_Frame &frame = a_frames[queued];
+        if ( !queueData( frame.Head, frame.HeadSize ) || !queueData( frame.Data, frame.Size ) ) {
+            break;
+        }
+    }
+    return queued;
+}
+
+/*****************************************************************************
+ * Прием данных через сокет
+ *
+ * Запись приема передается ядру вместе с накопленными отправками. Принятые
+ * данные выдаются, даже если отправка в том же вызове завершилась ошибкой
+ *
+ * @param
+ *  [out] a_data     - буфер, в который пишутся данные из сокета
+ *  [in]  a_capacity - размер буфера
+ *  [out] a_received - количество принятых байтов
+ *
+ * @return
+ *  true  - прием данных произошел успешно
+ *  false - во время приема данных произошла ошибка
+ */
+bool C_UringTcpSocket::recvInto( char *a_data, size_t a_capacity, size_t &a_received )
+{
+    if ( !useRing() ) {
+        return C_PosixTcpSocket::recvInto( a_data, a_capacity, a_received );
+    }
+
+    ssize_t numBytes = 0;
+    bool flushed = flushRing( a_capacity, numBytes );
+    if ( !useRing() && numBytes == -EOPNOTSUPP ) {
+        return C_PosixTcpSocket::recvInto( a_data, a_capacity, a_received );
+    }
+    if ( !flushed && numBytes <= 0 ) {
+        return false;
+    }
+    if ( !m_tail.empty() ) {
+        flushTail();
+    }
+
+    if ( numBytes < 0 ) {
+        errno = static_cast<int>( -numBytes );
+        updateWouldBlock();
+        return false;
+    }
+    else if ( numBytes == 0 ) {
+        m_wouldBlock = false;
+        g_log << name() << "recv: connection closed" << std::endl;
+        return false;
+    }
+    else {
+        a_received = static_cast<size_t>( numBytes );
+        memcpy( a_data, &m_bufPool[ s_sendBufCount * s_regBufSize ], a_received );
+        m_wouldBlock = false;
+        return true;
+    }
+}
+
+/*****************************************************************************
+ * Передача ядру накопленных операций отправки
+ *
+ * @return
+ *  true  - все данные отправлены
+ *  false - часть данных не может быть отправлена без блокировки
+ *          (wouldBlock() == true) или произошла ошибка
+ */
+bool C_UringTcpSocket::submit()
+{
+    if ( !useRing() ) {
+        return C_PosixTcpSocket::submit();
+    }
+
+    m_wouldBlock = false;
+    ssize_t recvBytes = 0;
+    if ( !flushRing( 0, recvBytes ) ) {
+        return false;
+    }
+    if ( !useRing() ) {
+        return C_PosixTcpSocket::submit();
+    }
+    return m_tail.empty() || flushTail();
+}
+
+/*****************************************************************************
+ * Отправка части файла
+ *
+ * Перед вызовом sendfile() ядру передаются накопленные отправки, чтобы
+ * сохранить порядок байтов в потоке
+ *
+ * @param
+ *  [in]     a_fd     - дескриптор файла, открытого на чтение
+ *  [in,out] a_offset - смещение первого неотправленного байта в файле
+ *  [in,out] a_count  - количество байтов, которое осталось отправить
+ *
+ * @return
+ *  true  - отправлена часть данных, a_offset и a_count сдвинуты
+ *  false - во время отправки произошла ошибка (wouldBlock() - буфер сокета заполнен)
+ */
+bool C_UringTcpSocket::sendFile( int a_fd, uint64_t &a_offset, size_t &a_count )
+{
+    if ( !submit() ) {
+        return false;
+    }
+    return C_PosixTcpSocket::sendFile( a_fd, a_offset, a_count );
+}
+
+/*****************************************************************************
+ * Прием потока с записью в файл
+ *
+ * Перед приемом ядру передаются накопленные отправки (подтверждение потока),
+ * иначе отправитель не начнет передачу потока
+ *
+ * @param
+ *  [in]     a_fd    - дескриптор файла, открытого на запись
+ *  [in,out] a_count - количество байтов, которое осталось принять
+ *
+ * @return
+ *  true  - часть данных принята и записана, a_count уменьшен
+ *  false - во время приема произошла ошибка (wouldBlock() - данных пока нет)
+ */
+bool C_UringTcpSocket::recvFile( int a_fd, size_t &a_count )
+{
+    if ( useRing() && !submit() && !m_wouldBlock ) {
+        return false;
+    }
+    return C_PosixTcpSocket::recvFile( a_fd, a_count );
+}
+
+/*****************************************************************************
+ * Копирование данных в буферы отправки
+ *
+ * Данные дописываются в последний еще не переданный ядру буфер, затем
+ * занимают новые буферы. Если после передачи ядру накопленных записей остался
+ * неотправленный хвост, оставшиеся данные дописываются к нему. Если при
+ * передаче ядру io_uring был отключен, данные дописываются к остатку
+ * C_PosixTcpSocket
+ *
+ * @param
+ *  [in] a_data - указатель на данные
+ *  [in] a_size - размер данных
+ *
+ * @return
+ *  true  - данные приняты к отправке
+ *  false - ошибка io_uring или сокета
+ */
+bool C_UringTcpSocket::queueData( const char *a_data, size_t a_size )
+{
+    while ( a_size > 0 ) {
+        if ( !m_tail.empty() ) {
+            m_tail.insert( m_tail.end(), a_data, a_data + a_size );
+            return true;
+        }
+
+        if ( m_lastWrite && m_writes.back().Size < s_regBufSize ) {
+            T_Write &write = m_writes.back();
+            size_t   size  = std::min( a_size, s_regBufSize - write.Size );
+            memcpy( &m_bufPool[ write.BufIdx * s_regBufSize + write.Size ], a_data, size );
+            write.Size      += static_cast<unsigned>( size );
+            m_lastWrite->len = write.Size;
+            a_data += size;
+            a_size -= size;
+            continue;
+        }
+
+        if ( m_freeBufs.empty() ) {
+            ssize_t recvBytes = 0;
+            if ( !flushRing( 0, recvBytes ) ) {
+                return false;
+            }
+            if ( !useRing() ) {
+                m_unsent.insert( m_unsent.end(), a_data, a_data + a_size );
+                return true;
+            }
+            continue;
+        }
+
+        if ( !queueWrite( m_freeBufs.back(), 0 ) ) {
+            return false;
+        }
+        m_freeBufs.pop_back();
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Заполнение записи отправки для буфера a_bufIdx
+ *
+ * Все записи связываются в цепочку, флаг IOSQE_IO_LINK последней записи
+ * снимается перед передачей ядру
+ *
+ * @param
+ *  [in] a_bufIdx - номер буфера отправки
+ *  [in] a_size   - количество байтов в буфере
+ *
+ * @return
+ *  true  - запись заполнена
+ *  false - очередь отправки заполнена
+ */
+bool C_UringTcpSocket::queueWrite( unsigned a_bufIdx, unsigned a_size )
+{
+    io_uring_sqe *sqe = m_ring.getSqe();
+    if ( !sqe ) {
+        g_log << name() << "io_uring submission queue is full" << std::endl;
+        return false;
+    }
+
+    sqe->opcode    = m_fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd        = m_acceptedSocket;
+    sqe->addr      = reinterpret_cast<uint64_t>( &m_bufPool[ a_bufIdx * s_regBufSize ] );
+    sqe->len       = a_size;
+    sqe->rw_flags  = RWF_NOWAIT;
+    sqe->flags     = IOSQE_IO_LINK;
+    sqe->buf_index = m_fixedBuffers ? static_cast<uint16_t>( a_bufIdx ) : 0;
+    sqe->user_data = m_writes.size();
+
+    m_writes.push_back( { a_bufIdx, a_size } );
+    m_lastWrite = sqe;
+    return true;
+}
+
+/*****************************************************************************
+ * Передача ядру накопленных записей и обработка их завершений
+ *
+ * Частично выполненные и отмененные отправки переносятся в m_tail в порядке
+ * их следования в потоке. Если операция завершилась с -EOPNOTSUPP (RWF_NOWAIT
+ * не поддерживается), io_uring отключается, а m_tail переносится в m_unsent
+ *
+ * @param
+ *  [in]  a_recvSize  - размер буфера приема (0, если прием не требуется)
+ *  [out] a_recvBytes - результат операции приема (количество байтов или -errno)
+ *
+ * @return
+ *  true  - записи обработаны
+ *  false - ошибка io_uring или сокета
+ */
+bool C_UringTcpSocket::flushRing( size_t a_recvSize, ssize_t &a_recvBytes )
+{
+    if ( m_lastWrite ) {
+        m_lastWrite->flags &= ~IOSQE_IO_LINK;
+        m_lastWrite = nullptr;
+    }
+
+    if ( a_recvSize != 0 ) {
+        io_uring_sqe *sqe = m_ring.getSqe();
+        if ( !sqe ) {
+            g_log << name() << "io_uring submission queue is full" << std::endl;
+            return false;
+        }
+        sqe->opcode    = m_fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd        = m_acceptedSocket;
+        sqe->addr      = reinterpret_cast<uint64_t>( &m_bufPool[ s_sendBufCount * s_regBufSize ] );
+        sqe->len       = static_cast<unsigned>( std::min( a_recvSize, s_regBufSize ) );
+        sqe->rw_flags  = RWF_NOWAIT;
+        sqe->buf_index = m_fixedBuffers ? static_cast<uint16_t>( s_sendBufCount ) : 0;
+        sqe->user_data = s_recvTag;
+    }
+
+    unsigned expected = static_cast<unsigned>( m_writes.size() ) + ( a_recvSize != 0 ? 1 : 0 );
+    if ( expected == 0 ) {
+        return true;
+    }
+
+    std::vector<int> results( m_writes.size(), -ECANCELED );
+    unsigned completed = 0;
+    int retVal = m_ring.submit( expected );
+    while ( completed < expected && retVal >= 0 ) {
+        io_uring_cqe cqe;
+        if ( !m_ring.popCqe( cqe ) ) {
+            retVal = m_ring.submit( expected - completed );
+            continue;
+        }
+        if ( cqe.user_data == s_recvTag ) {
+            a_recvBytes = cqe.res;
+        }
+        else {
+            results[ cqe.user_data ] = cqe.res;
+        }
+        completed++;
+    }
+
+    int error = retVal < 0 ? -retVal : 0;
+    bool broken = false;
+    bool noWaitOff = ( a_recvSize != 0 && a_recvBytes == -EOPNOTSUPP );
+    for ( size_t idx = 0; idx < m_writes.size(); idx++ ) {
+        const T_Write &write = m_writes[idx];
+        if ( !broken && results[idx] == static_cast<int>( write.Size ) ) {
+            m_freeBufs.push_back( write.BufIdx );
+            continue;
+        }
+        if ( results[idx] == -EOPNOTSUPP ) {
+            noWaitOff = true;
+        }
+        else if ( !broken && results[idx] < 0 && results[idx] != -EAGAIN && results[idx] != -ECANCELED ) {
+            error = -results[idx];
+        }
+        size_t sent = ( !broken && results[idx] > 0 ) ? static_cast<size_t>( results[idx] ) : 0;
+        const char *data = &m_bufPool[ write.BufIdx * s_regBufSize ];
+        m_tail.insert( m_tail.end(), data + sent, data + write.Size );
+        m_freeBufs.push_back( write.BufIdx );
+        broken = true;
+    }
+    m_writes.clear();
+
+    if ( noWaitOff ) {
+        g_log << name() << "RWF_NOWAIT is not supported for sockets, falling back to send/recv" << std::endl;
+        m_noWaitOff = true;
+        m_unsent.insert( m_unsent.end(), m_tail.begin(), m_tail.end() );
+        m_tail.clear();
+    }
+    if ( error ) {
+        errno = error;
+        m_wouldBlock = false;
+        m_tail.clear();
+        g_log << name() << "io_uring send failed with error: " << lastError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * Дозапись неотправленного остатка в сокет
+ *
+ * @return
+ *  true  - остаток отправлен целиком
+ *  false - остаток не может быть отправлен без блокировки (wouldBlock() == true)
+ *          или произошла ошибка
+ */
+bool C_UringTcpSocket::flushTail()
+{
+    auto numBytes = ::send( m_acceptedSocket,
+                            m_tail.data(),
+                            m_tail.size(),
+                            MSG_NOSIGNAL | MSG_DONTWAIT );
+    if ( numBytes < 0 ) {
+        updateWouldBlock();
+        if ( !m_wouldBlock ) {
+            g_log << name() << "send failed with error: " << lastError() << std::endl;
+            m_tail.clear();
+        }
+        return false;
+    }
+
+    m_tail.erase( m_tail.begin(), m_tail.begin() + numBytes );
+    if ( !m_tail.empty() ) {
+        m_wouldBlock = true;
+        return false;
+    }
+    return true;
+}
+
+} // namespace network
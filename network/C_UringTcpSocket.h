@@ -0,0 +1,154 @@
+/*****************************************************************************
+
+  C_UringTcpSocket
+
+  Класс TCP-сокета, выполняющий отправку и прием данных через io_uring
+  (ОС Linux)
+
+  ОПИСАНИЕ
+
+  * Функция send() не выполняет системный вызов: данные копируются в один из
+    зарегистрированных в ядре буферов (IORING_REGISTER_BUFFERS) и для них
+    заполняется запись IORING_OP_WRITE_FIXED. Небольшие кадры дописываются в
+    еще не переданный ядру буфер, пока он не заполнится. Накопленные записи
+    передаются ядру одним вызовом io_uring_enter() в функциях submit() и recv(),
+    либо при исчерпании свободных буферов.
+
+  * Записи отправки связываются флагом IOSQE_IO_LINK, поэтому порядок байтов
+    в потоке сохраняется: если отправка оказалась частичной, последующие записи
+    цепочки отменяются ядром, а неотправленный остаток запоминается и
+    дописывается в сокет перед следующими данными.
+
+  * Все операции выполняются с флагом RWF_NOWAIT и завершаются в момент
+    передачи ядру, поэтому сокет сохраняет семантику неблокирующего сокета:
+    если данные не могут быть отправлены без блокировки, submit() и send()
+    возвращают false, а wouldBlock() - true.
+
+  * Если io_uring недоступен (старое ядро, запрет io_uring_disabled) или ядро
+    не поддерживает RWF_NOWAIT для сокетов (операция завершается с
+    -EOPNOTSUPP), сокет работает как обычный C_PosixTcpSocket.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Использование объектов класса C_UringTcpSocket равносильно работе с объектами,
+    реализующими интерфейс I_Socket (см. I_Socket). После серии вызовов send()
+    необходимо вызвать submit():
+
+    sockObj->send( packet1 );
+    sockObj->send( packet2 );
+    sockObj->submit();
+
+*****************************************************************************/
+
+#pragma once
+
+#include "C_PosixTcpSocket.h"
+#include "C_Uring.h"
+
+#include <cstdint>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Класс TCP-сокета с пакетной отправкой и приемом через io_uring
+ */
+class C_UringTcpSocket : public C_PosixTcpSocket
+{
+
+public:
+
+    C_UringTcpSocket();
+    virtual ~C_UringTcpSocket() override;
+
+    /**
+     * Реализация интерфейса I_Socket
+     */
+
+    // Закрытие сокета
+    virtual void close() override;
+
+    /**
+     * Отправка и прием данных
+     */
+
+    virtual bool send( const std::vector<char> &a_buff ) override;
+    virtual bool recvInto( char *a_data, size_t a_capacity, size_t &a_received ) override;
+
+    // Передача ядру накопленных операций отправки
+    virtual bool submit() override;
+    // Отправка кадров (заголовок и данные копируются в буферы отправки)
+    virtual size_t sendFrames( const T_Frame *a_frames, size_t a_count ) override;
+    // Отправка кадра (заголовок и нагрузка копируются в буферы отправки)
+    virtual bool sendZeroCopy( const T_Frame &a_frame ) override;
+    // Отправка части файла (после передачи ядру накопленных отправок)
+    virtual bool sendFile( int a_fd, uint64_t &a_offset, size_t &a_count ) override;
+    // Прием потока с записью в файл (после передачи ядру накопленных отправок)
+    virtual bool recvFile( int a_fd, size_t &a_count ) override;
+
+private: // types
+
+    // Операция отправки, переданная ядру
+    struct T_Write {
+        unsigned    BufIdx;                 // Номер зарегистрированного буфера
+        unsigned    Size;                   // Количество байтов в буфере
+    };
+
+private:
+
+    // Копирование данных в буферы отправки
+    bool queueData( const char *a_data, size_t a_size );
+    // Заполнение записи отправки для буфера a_bufIdx
+    bool queueWrite( unsigned a_bufIdx, unsigned a_size );
+    // Передача ядру накопленных записей и обработка их завершений
+    bool flushRing( size_t a_recvSize, ssize_t &a_recvBytes );
+    // Дозапись неотправленного остатка в сокет
+    bool flushTail();
+    // Отправка и прием выполняются через io_uring
+    bool useRing() const { return m_ring.isValid() && !m_noWaitOff; }
+
+private:
+
+    C_Uring                 m_ring;                     // Кольца io_uring
+    bool                    m_fixedBuffers = false;     // Буферы зарегистрированы в ядре
+    std::vector<char>       m_bufPool;                  // Память буферов обмена
+    std::vector<unsigned>   m_freeBufs;                 // Номера свободных буферов отправки
+    std::vector<T_Write>    m_writes;                   // Отправки, ожидающие передачи ядру
+    io_uring_sqe           *m_lastWrite = nullptr;      // Последняя запись цепочки отправок
+    std::vector<char>       m_tail;                     // Неотправленный остаток потока
+    bool                    m_noWaitOff = false;        // RWF_NOWAIT для сокетов не поддерживается ядром
+
+private: // static
+
+    static const unsigned   s_ringEntries;              // Размер очереди отправки io_uring
+    static const unsigned   s_sendBufCount;             // Количество буферов отправки
+    static const size_t     s_regBufSize;               // Размер одного буфера обмена
+    static const uint64_t   s_recvTag;                  // Метка записи приема
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
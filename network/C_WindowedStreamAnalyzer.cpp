@@ -0,0 +1,230 @@
+/*****************************************************************************
+
+  C_WindowedStreamAnalyzer
+
+  Класс для индексации пакетов внутри файла *.mes, отображенного в память,
+  с ограничением объема памяти, занимаемой файлом (ОС Linux)
+
+
+  ДЕТАЛИ РЕАЛИЗАЦИИ
+
+  * Окно начинается со страницы текущего пакета и перемещается, только когда
+    текущий пакет сместился на 1/s_releaseStep окна, поэтому поток упреждающего
+    чтения не пробуждается на каждом пакете, а позади окна остается не больше
+    1/s_releaseStep окна.
+
+  * Освобождаются:
+    - страницы между прежним и новым началом окна;
+    - страницы за концом окна, если окно переместилось назад (переход к
+      начальному пакету воспроизведения) или файл был размечен дальше конца окна.
+    Разметка (calcIndex(), findByTime(), streamPackets()) читает заголовки
+    пакетов по всему файлу, конец размеченной части передается потоку вместе с
+    положением текущего пакета.
+
+  * posix_fadvise( POSIX_FADV_DONTNEED ) удаляет страницы из страничного кэша,
+    общего для всех процессов. Сессия, воспроизводящая тот же файл в другом
+    месте, прочитает их с диска повторно.
+
+  * Страницы окна загружаются чтением по одному байту из каждой страницы: после
+    posix_fadvise( POSIX_FADV_WILLNEED ) чтение не ожидает диска, если страница
+    уже загружена, и ожидает в потоке упреждающего чтения, а не в потоке сервера.
+
+*****************************************************************************/
+
+#include "C_WindowedStreamAnalyzer.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+const std::size_t C_WindowedStreamAnalyzer::s_releaseStep   = 4;                  // Четверть окна
+const std::size_t C_WindowedStreamAnalyzer::s_stopCheckSize = 1024 * 1024;        // 1 megabyte
+
+/*****************************************************************************
+  Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Конструктор
+ *
+ * @param
+ *  [in] a_filePath   - путь к файлу с данными
+ *  [in] a_windowSize - размер окна в байтах (округляется вверх до размера страницы)
+ */
+C_WindowedStreamAnalyzer::C_WindowedStreamAnalyzer( const std::string &a_filePath, std::size_t a_windowSize )
+    : C_MappedStreamAnalyzer( a_filePath )
+{
+    if ( size() == 0 ) {
+        return;
+    }
+    m_fd = ::open( a_filePath.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( m_fd < 0 ) {
+        g_log << "file " << a_filePath << " is not opened: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    m_pageSize   = static_cast<std::size_t>( sysconf( _SC_PAGESIZE ) );
+    m_windowSize = std::max( a_windowSize, m_pageSize * s_releaseStep );
+    m_windowSize = ( m_windowSize + m_pageSize - 1 ) / m_pageSize * m_pageSize;
+    g_log << "file window: " << static_cast<unsigned long>( m_windowSize ) << " bytes" << std::endl;
+
+    m_thread = std::thread( &C_WindowedStreamAnalyzer::readahead, this );
+}
+
+/*****************************************************************************
+ * Деструктор
+ */
+C_WindowedStreamAnalyzer::~C_WindowedStreamAnalyzer()
+{
+    if ( m_thread.joinable() ) {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_stop = true;
+        }
+        m_wakeup.notify_one();
+        m_thread.join();
+    }
+    if ( m_fd >= 0 ) {
+        ::close( m_fd );
+    }
+}
+
+/*****************************************************************************
+ * Переход воспроизведения к пакету
+ *
+ * Вызывается потоком, работающим с разметчиком
+ *
+ * @param
+ *  [in] a_packNo - номер текущего воспроизводимого пакета (packetCount() -
+ *                  воспроизведение завершено)
+ */
+void C_WindowedStreamAnalyzer::setCursor( std::size_t a_packNo )
+{
+    if ( !m_thread.joinable() ) {
+        return;
+    }
+    const index_t &packets = index();
+    uint64_t cursor  = ( a_packNo < packets.size() ) ? packets.offset( a_packNo ) : packets.endOffset();
+    uint64_t touched = packets.endOffset();
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+    if ( m_notified && cursor >= m_cursor && cursor - m_cursor < m_windowSize / s_releaseStep ) {
+        return;
+    }
+    m_cursor     = cursor;
+    m_touchedEnd = touched;
+    m_notified   = true;
+    m_changed    = true;
+    m_wakeup.notify_one();
+}
+
+/*****************************************************************************
+ * Цикл потока упреждающего чтения
+ */
+void C_WindowedStreamAnalyzer::readahead()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    while ( true ) {
+        m_wakeup.wait( lock, [this](){ return m_changed || m_stop; } );
+        if ( m_stop ) {
+            return;
+        }
+        uint64_t cursor     = m_cursor;
+        uint64_t touchedEnd = m_touchedEnd;
+        m_changed = false;
+        lock.unlock();
+
+        uint64_t windowBegin = cursor / m_pageSize * m_pageSize;
+        uint64_t windowEnd   = std::min<uint64_t>( windowBegin + m_windowSize, size() );
+
+        // Освобождение страниц позади окна
+        if ( windowBegin > m_windowBegin ) {
+            release( m_windowBegin, windowBegin );
+        }
+        // Освобождение прежнего окна и размеченной части файла за концом окна
+        uint64_t aheadEnd = m_prefetchedEnd;
+        if ( touchedEnd > m_releasedEnd ) {
+            aheadEnd      = std::max( aheadEnd, touchedEnd );
+            m_releasedEnd = touchedEnd;
+        }
+        if ( aheadEnd > windowEnd ) {
+            release( windowEnd, aheadEnd );
+        }
+
+        // Загрузка части окна, которая не была загружена ранее
+        uint64_t prefetchBegin = ( windowBegin >= m_windowBegin && windowBegin < m_prefetchedEnd )
+                               ? m_prefetchedEnd : windowBegin;
+        m_windowBegin   = windowBegin;
+        m_prefetchedEnd = windowEnd;
+        if ( prefetchBegin < windowEnd ) {
+            prefetch( prefetchBegin, windowEnd );
+        }
+
+        lock.lock();
+    }
+}
+
+/*****************************************************************************
+ * Загрузка диапазона файла в память
+ *
+ * @param
+ *  [in] a_begin - начало диапазона
+ *  [in] a_end   - конец диапазона
+ */
+void C_WindowedStreamAnalyzer::prefetch( uint64_t a_begin, uint64_t a_end )
+{
+    // Подсказки носят рекомендательный характер, ошибки не влияют на работу
+    posix_fadvise( m_fd, static_cast<off_t>( a_begin ), static_cast<off_t>( a_end - a_begin ), POSIX_FADV_WILLNEED );
+
+    const volatile char *data = m_data;
+    for ( uint64_t offset = a_begin / m_pageSize * m_pageSize; offset < a_end; offset += m_pageSize ) {
+        if ( offset % s_stopCheckSize == 0 && m_stop ) {
+            return;
+        }
+        static_cast<void>( data[offset] );
+    }
+}
+
+/*****************************************************************************
+ * Освобождение диапазона файла
+ *
+ * @param
+ *  [in] a_begin - начало диапазона (выравнивается вверх до границы страницы)
+ *  [in] a_end   - конец диапазона
+ */
+void C_WindowedStreamAnalyzer::release( uint64_t a_begin, uint64_t a_end )
+{
+    uint64_t begin = ( a_begin + m_pageSize - 1 ) / m_pageSize * m_pageSize;
+    if ( begin >= a_end ) {
+        return;
+    }
+    madvise( const_cast<char*>( m_data ) + begin, static_cast<std::size_t>( a_end - begin ), MADV_DONTNEED );
+    posix_fadvise( m_fd, static_cast<off_t>( begin ), static_cast<off_t>( a_end - begin ), POSIX_FADV_DONTNEED );
+}
+
+} // namespace network
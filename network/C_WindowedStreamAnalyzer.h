@@ -0,0 +1,134 @@
+/*****************************************************************************
+
+  C_WindowedStreamAnalyzer
+
+  Класс для индексации пакетов внутри файла *.mes, отображенного в память,
+  с ограничением объема памяти, занимаемой файлом (ОС Linux)
+
+
+  ОПИСАНИЕ
+
+  * Файл отображается в память целиком (см. C_MappedStreamAnalyzer.h), но в
+    памяти удерживается только окно размером a_windowSize байт, начинающееся
+    с текущего воспроизводимого пакета (см. setCursor()).
+
+  * Отдельный поток упреждающего чтения загружает окно впереди текущего пакета
+    (posix_fadvise( POSIX_FADV_WILLNEED ) и чтение страниц), поэтому поток
+    сервера не ожидает чтения с диска. Страницы позади окна и страницы, прочитанные
+    при разметке за пределами окна, освобождаются (madvise( MADV_DONTNEED ) и
+    posix_fadvise( POSIX_FADV_DONTNEED )).
+
+  * Память, занимаемая файлом, не зависит от размера файла и не превышает
+    примерно 1.25 размера окна. Индекс пакетов (около 4 байт на пакет, см.
+    C_PacketIndex.h) хранится в памяти целиком.
+
+  * Интерфейс совпадает с C_StreamAnalyzer. Итераторы остаются действительными
+    во всем файле: обращение к освобожденной странице снова читает ее с диска.
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Отображение файла с окном 64 мегабайта:
+
+    auto provider = std::make_unique<C_WindowedStreamAnalyzer>( a_filePath, 64 * 1024 * 1024 );
+    if ( provider->size() == 0 ) { ... файл не удалось отобразить ... }
+
+  * Сообщение о переходе воспроизведения к пакету a_packNo:
+
+    provider->setCursor( a_packNo );
+
+*****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "C_MappedStreamAnalyzer.h"
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Класс для индексации пакетов файла с ограниченным окном в памяти
+ */
+class C_WindowedStreamAnalyzer : public C_MappedStreamAnalyzer
+{
+
+public:
+
+    C_WindowedStreamAnalyzer( const std::string &a_filePath, std::size_t a_windowSize );
+    virtual ~C_WindowedStreamAnalyzer() override;
+
+    // Переход воспроизведения к пакету a_packNo
+    virtual void setCursor( std::size_t a_packNo ) override;
+
+    // Размер окна в байтах
+    std::size_t windowSize() const { return m_windowSize; }
+
+private:
+
+    // Цикл потока упреждающего чтения
+    void readahead();
+    // Загрузка диапазона файла в память
+    void prefetch( uint64_t a_begin, uint64_t a_end );
+    // Освобождение диапазона файла
+    void release( uint64_t a_begin, uint64_t a_end );
+
+private:
+
+    int                     m_fd         = -1;  // Дескриптор файла (для posix_fadvise())
+    std::size_t             m_windowSize = 0;   // Размер окна в байтах
+    std::size_t             m_pageSize   = 0;   // Размер страницы памяти
+
+    std::thread             m_thread;           // Поток упреждающего чтения
+    std::mutex              m_mutex;            // Защита полей, передаваемых потоку
+    std::condition_variable m_wakeup;           // Сигнал о перемещении окна
+    uint64_t                m_cursor     = 0;   // Смещение текущего пакета
+    uint64_t                m_touchedEnd = 0;   // Конец размеченной части файла
+    bool                    m_notified   = false;   // Поток уже получал положение окна
+    bool                    m_changed    = false;   // Окно перемещено
+    std::atomic<bool>       m_stop{ false };        // Завершение потока
+
+    /**
+     * Состояние потока упреждающего чтения
+     */
+    uint64_t                m_windowBegin   = 0;    // Начало окна
+    uint64_t                m_prefetchedEnd = 0;    // Конец загруженной части окна
+    uint64_t                m_releasedEnd   = 0;    // Конец размеченной части файла, освобожденной за окном
+
+private: // static
+
+    static const std::size_t s_releaseStep;     // Доля окна, на которую должен сместиться текущий пакет
+    static const std::size_t s_stopCheckSize;   // Объем чтения между проверками завершения потока
+
+};
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+} // namespace network
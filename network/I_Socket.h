@@ -28,14 +28,89 @@
 
        virtual int send( std::vector<char> &a_buff ) = 0;
 
-     * Прием данных в буфер a_buff:
+     * Прием данных в буфер a_buff. Размер буфера устанавливается равным
+       количеству принятых байтов:
 
-       virtual int recv( std::vector<char> &a_buff ) = 0;
+       virtual bool recv( std::vector<char> &a_buff ) = 0;
+
+     * Прием не более a_capacity байтов в буфер a_data вызывающей стороны.
+       Количество принятых байтов записывается в a_received, буфер не
+       заполняется сверх принятых данных, поэтому один буфер переиспользуется
+       для всех приемов:
+
+       virtual bool recvInto( char *a_data, size_t a_capacity, size_t &a_received ) = 0;
+
+     * Пакетная отправка до a_buffs.size() пакетов одним системным вызовом
+       (для UDP - sendmmsg()), возвращает количество отправленных пакетов:
+
+       virtual size_t sendBatch( const std::vector<std::vector<char>> &a_buffs ) = 0;
+
+     * Отправка до a_count кадров T_Frame (см. common_types.h), каждый из которых
+       передается одним вызовом из заголовка кадра и данных, на которые он
+       ссылается (для POSIX - sendmsg()/sendmmsg() с двумя iovec на кадр), без
+       склейки в промежуточный буфер. Возвращает количество отправленных
+       целиком кадров. Данные могут быть изменены сразу после возврата:
+
+       virtual size_t sendFrames( const T_Frame *a_frames, size_t a_count ) = 0;
+
+     * Пакетный прием до a_buffs.size() датаграмм одним системным вызовом
+       (для UDP - recvmmsg()), возвращает количество принятых датаграмм. Размер
+       буферов не изменяется, длина каждой принятой датаграммы записывается в
+       a_sizes (размер a_sizes устанавливается равным a_buffs.size()):
+
+       virtual size_t recvBatch( std::vector<std::vector<char>> &a_buffs,
+                                 std::vector<size_t> &a_sizes ) = 0;
 
      * Получение описания сокета:
 
        virtual std::string name() const = 0;
 
+     * Получение системного дескриптора рабочего сокета (для ожидания готовности
+       сокета в реакторе событий, см. C_Reactor.h):
+
+       virtual int handle() const = 0;
+
+     * Проверка того, что последняя неуспешная операция не завершилась ошибкой,
+       а лишь не могла быть выполнена без блокировки (EAGAIN, EINPROGRESS):
+
+       virtual bool wouldBlock() const = 0;
+
+     * Передача ядру отложенных операций отправки (для реализаций, накапливающих
+       отправки в пакет, см. C_UringTcpSocket.h). Если часть данных не может быть
+       отправлена без блокировки или еще не завершены отправки без копирования,
+       функция возвращает false, а wouldBlock() - true. Перед приемом данных
+       (recv()) отложенные отправки передаются ядру и без вызова submit():
+
+       virtual bool submit() = 0;
+
+     * Отправка кадра a_frame без копирования данных в пространство ядра
+       (MSG_ZEROCOPY). Кадр (вместе с заголовком) и его данные должны оставаться
+       неизменными до завершения отправки (см. zeroCopyDone()). Реализации, не
+       поддерживающие такую отправку, копируют данные обычным способом:
+
+       virtual bool sendZeroCopy( const T_Frame &a_frame ) = 0;
+
+     * Счетчики отправок без копирования: zeroCopySent() - отправок, при которых
+       ядро сослалось на данные кадра, zeroCopyDone() - завершенных из них.
+       Отправки завершаются в порядке их выполнения, поэтому кадр, после
+       отправки которого zeroCopySent() стал равен N, можно освободить, когда
+       zeroCopyDone() достигнет N. Если zeroCopySent() при отправке не изменился,
+       данные кадра скопированы и он не нужен сразу после отправки:
+
+       virtual uint32_t zeroCopySent() const = 0;
+       virtual uint32_t zeroCopyDone() const = 0;
+
+     * Отправка до a_count байтов файла a_fd, начиная со смещения a_offset, без
+       копирования через пространство пользователя (для TCP - sendfile()).
+       Параметры a_offset и a_count сдвигаются на количество отправленных байтов:
+
+       virtual bool sendFile( int a_fd, uint64_t &a_offset, size_t &a_count ) = 0;
+
+     * Прием до a_count байтов потока с дозаписью в файл a_fd (для TCP - splice()
+       через канал). Параметр a_count уменьшается на количество принятых байтов:
+
+       virtual bool recvFile( int a_fd, size_t &a_count ) = 0;
+
   2. TCP интерфейс
 
      * Подключение клиентского сокета к серверу (для клиентского сокета):
@@ -149,10 +224,39 @@ public:
     virtual bool send( const std::vector<char> &a_buff ) = 0;
     // Прием данных
     virtual bool recv(       std::vector<char> &a_buff ) = 0;
+    // Прием данных в буфер вызывающей стороны
+    virtual bool recvInto( char *a_data, size_t a_capacity, size_t &a_received ) = 0;
+
+    // Пакетная отправка данных
+    virtual size_t sendBatch( const std::vector<std::vector<char>> &a_buffs ) = 0;
+    // Отправка кадров без склейки заголовка и данных
+    virtual size_t sendFrames( const T_Frame *a_frames, size_t a_count ) = 0;
+    // Пакетный прием данных
+    virtual size_t recvBatch(       std::vector<std::vector<char>> &a_buffs,
+                                    std::vector<size_t> &a_sizes ) = 0;
 
     // Метка сокета
     virtual std::string name() const = 0;
 
+    // Системный дескриптор рабочего сокета
+    virtual int handle() const = 0;
+    // Последняя неуспешная операция не могла быть выполнена без блокировки
+    virtual bool wouldBlock() const = 0;
+
+    // Передача ядру отложенных операций отправки
+    virtual bool submit() = 0;
+    // Отправка кадра без копирования полезной нагрузки
+    virtual bool sendZeroCopy( const T_Frame &a_frame ) = 0;
+    // Количество отправок, при которых ядро сослалось на данные кадра
+    virtual uint32_t zeroCopySent() const = 0;
+    // Количество завершенных отправок без копирования
+    virtual uint32_t zeroCopyDone() const = 0;
+
+    // Отправка части файла
+    virtual bool sendFile( int a_fd, uint64_t &a_offset, size_t &a_count ) = 0;
+    // Прием потока с записью в файл
+    virtual bool recvFile( int a_fd, size_t &a_count ) = 0;
+
 public:
 
     I_Socket()                   = default;
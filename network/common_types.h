@@ -11,6 +11,7 @@
     - Finish    - завершить работу сервера (символ 'S' ASCII)
     - GetNumber - запросить у сервера случайное число (символ 'R' ASCII)
     - Echo      - отправить эхо-запрос (символ 'E' ASCII)
+    - Bulk      - принять остаток файла одним потоком байтов (только TCP)
 
 
   E_Protocol
@@ -20,6 +21,23 @@
     - UDP
 
 
+  E_StreamProto
+
+  * Типы протоколов, по которым получены пакеты потока файла *.mes:
+    - Unknown  (не определен)
+    - RS
+    - Ethernet
+
+
+  E_SocketBackend
+
+  * Реализации сокетов:
+    - Native  (родная для платформы сборки)
+    - WinSock (ОС Windows)
+    - Posix   (ОС Linux)
+    - Uring   (ОС Linux, пакетная отправка/прием через io_uring)
+
+
   E_SocketType
 
   * Типы сокетов:
@@ -40,11 +58,22 @@
     - Reading (режим чтения)
     - Writing (режим записи)
 
+
+  E_Readiness, T_Wait
+
+  * Событие, которого ожидает машина состояний клиента или сервера перед
+    следующим шагом:
+    - None  (продолжить без ожидания)
+    - Read  (готовность сокета на чтение)
+    - Write (готовность сокета на запись)
+    - Timer (истечение таймаута)
+
 *****************************************************************************/
 
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <vector>
 #include <cstdint>
 
@@ -69,27 +98,31 @@ namespace network {
 ////      ...
 ////      T_Packet
 
+//// Записи файла имеют фиксированный размер полей и порядок байтов little-endian
+//// (файлы записываются в ОС Windows). Записи читаются из буфера через
+//// представления (см. record_views.h), структуры описывают формат файла
+
 //// Данные заголовка файла пакетов
 struct T_PacketFileHeader {
   union {
-     unsigned long TypeDw;
+     uint32_t      TypeDw;
      unsigned char TypeStr[ 4 ];
   } Type; // Идентификатор формата файла
           // Mes1, Mes2, Uvk1, Uvk2 - старые форматы, цифра - тип протокола (1 - RS, 2 - Ethernet)
           // Unf1, Unf2, Cpu1, Cpu2 - старые форматы, цифра - тип протокола (1 - RS, 2 - Ethernet)
           // Mes3 - новый формат, тип протокола и формат данных пакетов хранится в полях StreamInfo для каждого потока
-  unsigned long StreamQuan;
-  unsigned long RecordsInFile;
-  long          RecordTime;
+  uint32_t      StreamQuan;
+  uint32_t      RecordsInFile;
+  int32_t       RecordTime;
   char          RecordName[ 64 ];
-  long          LastChangeTime;
+  int32_t       LastChangeTime;
   char          Info[ 60 ];
 };
 
 // Структура пакета
 struct T_Packet {
-    unsigned long  Time;       // Время получения пакета в миллисекундах
-    unsigned short DataSize;   // Размер данных пакета
+    uint32_t       Time;       // Время получения пакета в миллисекундах
+    uint16_t       DataSize;   // Размер данных пакета
     unsigned char  StreamNum;  // Номер потока, которому принадлежит пакет
     unsigned char  Info;       // Зарезервировано для будущего использования
     unsigned char  Data[ ];    // Данные пакета
@@ -101,6 +134,7 @@ struct T_Packet {
 enum class Comand  {
     Data,       // Запрос данных
     Finish,     // Остановить работу
+    Bulk,       // Прием остатка файла одним потоком
     Invalid,    // Невалидная команда
     Quan        // Количество команд
 };
@@ -114,7 +148,8 @@ enum class Header : uint16_t {
     EchoResp = 0xB1AE,    // Эхо ответ
     DataReqt = 0xC29D,    // Запрос данных
     DataResp = 0xD38C,    // Ответ данных
-    FileSent = 0xE47B     // Файл передан
+    FileSent = 0xE47B,    // Файл передан
+    BulkResp = 0xF56A     // Начало потоковой передачи (длина потока, 8 байтов big-endian)
 };
 
 // Структура пакета протокола передачи данных по сети
@@ -123,6 +158,23 @@ struct T_NetPacket {
     std::vector<char> Data;         // Данные пакета
 };
 
+// Представление пакета протокола передачи данных в буфере приема (данные не
+// копируются и действительны, пока буфер не изменен следующим приемом)
+struct T_NetPacketView {
+    Header      Head = Header::Unknown; // Состояние сеанса
+    const char *Data = nullptr;         // Данные пакета
+    size_t      Size = 0;               // Размер данных пакета
+};
+
+// Кадр протокола передачи данных, отправляемый без склейки заголовка и данных:
+// заголовок хранится в самом кадре, данные - ссылкой на буфер (не копируются)
+struct T_Frame {
+    char        Head[ 16 ];             // Заголовок кадра (Header и поля разметки кадра)
+    size_t      HeadSize = 0;           // Размер заголовка
+    const char *Data     = nullptr;     // Данные кадра
+    size_t      Size     = 0;           // Размер данных кадра
+};
+
 /*****************************************************************************
  * Типы протоколов доступных для общения клиента с сервером
  */
@@ -132,6 +184,25 @@ enum class E_Protocol {
     Invalid
 };
 
+/*****************************************************************************
+ * Типы протоколов, по которым получены пакеты потока файла *.mes
+ */
+enum class E_StreamProto {
+    Unknown,    // Протокол не определен
+    RS,         // Последовательный интерфейс RS
+    Ethernet    // Ethernet
+};
+
+/*****************************************************************************
+ * Реализации сокетов, доступные фабрике C_SocketFactory
+ */
+enum class E_SocketBackend {
+    Native,     // Родная реализация для платформы сборки
+    WinSock,    // Реализация поверх WinSock (ОС Windows)
+    Posix,      // Реализация поверх POSIX API (ОС Linux)
+    Uring       // Реализация поверх io_uring (ОС Linux)
+};
+
 /*****************************************************************************
  * Типы сокетов
  */
@@ -167,6 +238,23 @@ enum class E_FileMode {
     Writing
 };
 
+/*****************************************************************************
+ * События, ожидаемые машиной состояний между шагами
+ */
+enum class E_Readiness {
+    None,       // Продолжить без ожидания
+    Read,       // Ожидание готовности сокета на чтение
+    Write,      // Ожидание готовности сокета на запись
+    Timer       // Ожидание истечения таймаута
+};
+
+// Ожидание машины состояний перед следующим шагом
+struct T_Wait {
+    E_Readiness               What    = E_Readiness::None;                  // Ожидаемое событие
+    std::chrono::milliseconds Timeout = std::chrono::milliseconds( 0 );     // Таймаут (для E_Readiness::Timer и
+                                                                            // для цикла без реактора)
+};
+
 /*****************************************************************************
   Functions Prototypes
 *****************************************************************************/
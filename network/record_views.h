@@ -0,0 +1,191 @@
+/*****************************************************************************
+
+  Представления записей файла с данными в формате *.mes
+
+
+  ОПИСАНИЕ
+
+  * Файлы *.mes записываются программой для ОС Windows, в которой типы long и
+    unsigned long занимают 4 байта, поэтому поля записей файла имеют
+    фиксированный размер, не совпадающий с размером этих типов в ОС Linux (LP64),
+    и порядок байтов little-endian.
+
+  * Представления T_FileHeaderView и T_PacketView хранят только указатель на
+    начало записи в буфере (или в отображенном в память файле) и читают поля
+    по фиксированным смещениям в порядке байтов little-endian. Данные не
+    копируются, выравнивание записи в буфере не требуется, результат не зависит
+    от платформы.
+
+  * Данные, на которые указывает представление, должны существовать, пока оно
+    используется. Проверка того, что запись целиком находится внутри буфера,
+    выполняется вызывающей стороной (размеры записей - size()/headerSize()).
+
+
+  ИСПОЛЬЗОВАНИЕ
+
+  * Чтение заголовка файла и первого пакета:
+
+    T_FileHeaderView header( data );
+    unsigned long count = header.recordsInFile();
+
+    T_PacketView packet( data + T_FileHeaderView::size() );
+    if ( packet.time() > ... ) { ... }
+
+  * Переход к следующему пакету:
+
+    T_PacketView next( packet.data() + packet.size() );
+
+*****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common_types.h"
+
+namespace network {
+
+/*****************************************************************************
+  Macro Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Forward Declarations
+*****************************************************************************/
+
+// Чтение 16-битного числа в порядке байтов little-endian
+inline uint16_t loadLe16( const char *a_data );
+// Чтение 32-битного числа в порядке байтов little-endian
+inline uint32_t loadLe32( const char *a_data );
+// Запись 32-битного числа в порядке байтов little-endian
+inline void storeLe32( char *a_data, uint32_t a_value );
+
+/*****************************************************************************
+  Types and Classes Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Представление заголовка файла (T_PacketFileHeader)
+ */
+class T_FileHeaderView
+{
+
+public:
+
+    explicit T_FileHeaderView( const char *a_data = nullptr ) : m_data( a_data ) {}
+
+    // Представление указывает на данные
+    explicit operator bool() const { return m_data != nullptr; }
+    // Начало заголовка
+    const char * data() const { return m_data; }
+
+    // Идентификатор формата файла (4 символа без завершающего нуля)
+    const char * type() const { return m_data; }
+    // Количество потоков
+    uint32_t streamQuan() const { return loadLe32( m_data + 4 ); }
+    // Количество пакетов в файле
+    uint32_t recordsInFile() const { return loadLe32( m_data + 8 ); }
+    // Время записи
+    int32_t recordTime() const { return static_cast<int32_t>( loadLe32( m_data + 12 ) ); }
+    // Название записи (64 символа)
+    const char * recordName() const { return m_data + 16; }
+    // Время последнего изменения
+    int32_t lastChangeTime() const { return static_cast<int32_t>( loadLe32( m_data + 80 ) ); }
+    // Дополнительная информация (60 символов)
+    const char * info() const { return m_data + 84; }
+
+    // Размер заголовка в файле
+    static constexpr std::size_t size() { return 144; }
+    // Запись количества пакетов в заголовок a_data
+    static void setRecordsInFile( char *a_data, uint32_t a_count ) { storeLe32( a_data + 8, a_count ); }
+
+private:
+
+    const char *m_data;     // Начало заголовка
+
+};
+
+/*****************************************************************************
+ * Представление пакета (T_Packet)
+ */
+class T_PacketView
+{
+
+public:
+
+    explicit T_PacketView( const char *a_data = nullptr ) : m_data( a_data ) {}
+
+    // Представление указывает на данные
+    explicit operator bool() const { return m_data != nullptr; }
+    // Начало пакета
+    const char * data() const { return m_data; }
+
+    // Время получения пакета в миллисекундах
+    uint32_t time() const { return loadLe32( m_data ); }
+    // Размер данных пакета
+    uint16_t dataSize() const { return loadLe16( m_data + 4 ); }
+    // Номер потока, которому принадлежит пакет
+    uint8_t streamNum() const { return static_cast<uint8_t>( m_data[6] ); }
+    // Зарезервировано для будущего использования
+    uint8_t info() const { return static_cast<uint8_t>( m_data[7] ); }
+    // Данные пакета
+    const char * payload() const { return m_data + headerSize(); }
+
+    // Размер пакета вместе с заголовком
+    std::size_t size() const { return headerSize() + dataSize(); }
+
+    // Размер заголовка пакета в файле
+    static constexpr std::size_t headerSize() { return 8; }
+
+private:
+
+    const char *m_data;     // Начало пакета
+
+};
+
+static_assert( sizeof(T_PacketFileHeader) == T_FileHeaderView::size(), "file header layout must match the file format" );
+static_assert( sizeof(T_Packet)           == T_PacketView::headerSize(), "packet layout must match the file format" );
+
+/*****************************************************************************
+  Functions Prototypes
+*****************************************************************************/
+
+/*****************************************************************************
+  Variables Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+  Inline Functions Definitions
+*****************************************************************************/
+
+/*****************************************************************************
+ * Чтение 16-битного числа в порядке байтов little-endian
+ */
+inline uint16_t loadLe16( const char *a_data )
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>( a_data );
+    return static_cast<uint16_t>( bytes[0] | bytes[1] << 8 );
+}
+
+/*****************************************************************************
+ * Чтение 32-битного числа в порядке байтов little-endian
+ */
+inline uint32_t loadLe32( const char *a_data )
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>( a_data );
+    return static_cast<uint32_t>( bytes[0] )       | static_cast<uint32_t>( bytes[1] ) << 8 |
+           static_cast<uint32_t>( bytes[2] ) << 16 | static_cast<uint32_t>( bytes[3] ) << 24;
+}
+
+/*****************************************************************************
+ * Запись 32-битного числа в порядке байтов little-endian
+ */
+inline void storeLe32( char *a_data, uint32_t a_value )
+{
+    for ( unsigned i = 0; i < 4; i++ ) {
+        a_data[i] = static_cast<char>( ( a_value >> ( 8 * i ) ) & 0xff );
+    }
+}
+
+} // namespace network
@@ -6,6 +6,15 @@
 
 #include "utils.h"
 
+#include <cstring>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace network {
 
 /*****************************************************************************
@@ -84,33 +93,33 @@ std::vector<I_Socket::endpoint> parseEndpointStr( std::string a_configStr )
  * Вывод заголовка на экран
  *
  * @param
- *  [in] a_header - указатель на заголовок
+ *  [in] a_header - представление заголовка
  */
-void print( const T_PacketFileHeader *a_header ) {
+void print( T_FileHeaderView a_header ) {
     using namespace std;
     if( a_header ) {
         g_log << "--------PACKET FILE HEADER--------" << endl;
         g_log << "Type: ";
         for( uint32_t i = 0; i < 4; i++ ) {
-            g_log <<  a_header->Type.TypeStr[i];
+            g_log <<  a_header.type()[i];
         }
         g_log << endl;
         //----------------------------------------------------------------------------
-        g_log << "Stream quan: "     << a_header->StreamQuan    << endl;
-        g_log << "Records in file: " << a_header->RecordsInFile << endl;
-        g_log << "Record time: "     << a_header->RecordTime    << endl;
+        g_log << "Stream quan: "     << a_header.streamQuan()    << endl;
+        g_log << "Records in file: " << a_header.recordsInFile() << endl;
+        g_log << "Record time: "     << a_header.recordTime()    << endl;
         //----------------------------------------------------------------------------
         g_log << "RecordName: ";
         for( uint32_t i = 0; i < 64; i++ ) {
-            g_log << a_header->RecordName[i];
+            g_log << a_header.recordName()[i];
         }
         g_log << endl;
 
-        g_log << "Last Change Time: " << a_header->LastChangeTime   << endl;
+        g_log << "Last Change Time: " << a_header.lastChangeTime()   << endl;
 
         g_log << "Info: ";
         for( uint32_t i = 0; i < 60; i++ ) {
-            g_log << a_header->Info[i];
+            g_log << a_header.info()[i];
         }
         g_log << endl;
         g_log << "----------------------------------" << endl;
@@ -121,15 +130,15 @@ void print( const T_PacketFileHeader *a_header ) {
  * Вывод пакета на экран
  *
  * @param
- *  [in] a_packet - указатель на пакет
+ *  [in] a_packet - представление пакета
  */
-void print( const T_Packet *a_packet ) {
+void print( T_PacketView a_packet ) {
     using namespace std;
     if( a_packet ) {
-        g_log << "Time: "          << a_packet->Time      << " ms" << endl;
-        g_log << "Data size: "     << a_packet->DataSize  << " bytes" <<endl;
-      //  g_log << "Stream number: " << a_packet->StreamNum << endl;
-      //  g_log << "Info: "          << a_packet->Info      << endl;
+        g_log << "Time: "          << a_packet.time()      << " ms" << endl;
+        g_log << "Data size: "     << a_packet.dataSize()  << " bytes" <<endl;
+      //  g_log << "Stream number: " << a_packet.streamNum() << endl;
+      //  g_log << "Info: "          << a_packet.info()      << endl;
         g_log << "----------------------------------" << endl;
     }
 }
@@ -138,13 +147,13 @@ void print( const T_Packet *a_packet ) {
  * Вывод данных пакета на экран
  *
  * @param
- *  [in] a_packet - указатель на пакет
+ *  [in] a_packet - представление пакета
  */
-void printData( const T_Packet *a_packet ) {
+void printData( T_PacketView a_packet ) {
     if( a_packet ) {
         g_log << "Packet Data: ";
-        for( uint32_t i = 0; i < a_packet->DataSize; i++ ) {
-            g_log << a_packet->Data[i];
+        for( uint32_t i = 0; i < a_packet.dataSize(); i++ ) {
+            g_log << a_packet.payload()[i];
         }
         g_log << std::endl << "----------------------------------" << std::endl;
     }
@@ -154,13 +163,13 @@ void printData( const T_Packet *a_packet ) {
  * Расчет размера пакета
  *
  * @param
- *  [in] a_packet - указатель на пакет
+ *  [in] a_packet - представление пакета
  *
  * @return
  *  - размер пакета в байтах
  */
-unsigned int getPacketSize( T_Packet *a_packet ) {
-    return sizeof(T_Packet) + a_packet->DataSize;
+unsigned int getPacketSize( T_PacketView a_packet ) {
+    return static_cast<unsigned int>( a_packet.size() );
 }
 
 /*****************************************************************************
@@ -170,7 +179,7 @@ unsigned int getPacketSize( T_Packet *a_packet ) {
  *  - размер заголовка в байтах
  */
 unsigned int getHeaderSize() {
-    return sizeof(T_PacketFileHeader);
+    return static_cast<unsigned int>( T_FileHeaderView::size() );
 }
 
 /*****************************************************************************
@@ -197,6 +206,32 @@ std::vector<char> serialize( const T_NetPacket &a_packet )
     return outputBuf;
 }
 
+/*****************************************************************************
+ * Формирование кадра со ссылкой на данные без копирования
+ *
+ * Заголовок кадра совпадает с заголовком, формируемым serialize()
+ *
+ * @param
+ *  [in] a_head - заголовок пакета
+ *  [in] a_data - данные пакета (должны существовать до отправки кадра)
+ *  [in] a_size - размер данных
+ *
+ * @return
+ *  - кадр для отправки I_Socket::sendFrames()
+ */
+T_Frame makeFrame( Header a_head, const char *a_data, size_t a_size )
+{
+    uint16_t value = static_cast<uint16_t>( a_head );
+
+    T_Frame frame;
+    frame.Head[0]  = static_cast<char>( value >> 8 );
+    frame.Head[1]  = static_cast<char>( value & 0xFF );
+    frame.HeadSize = sizeof(uint16_t);
+    frame.Data     = a_data;
+    frame.Size     = a_size;
+    return frame;
+}
+
 /*****************************************************************************
  * Десериализация сетевого пакета из байтового потока
  *
@@ -208,14 +243,135 @@ std::vector<char> serialize( const T_NetPacket &a_packet )
  */
 T_NetPacket deserialize( const std::vector<char> &a_buffer )
 {
-    unsigned char hi = a_buffer[0];
-    unsigned char lo = a_buffer[1];
+    return deserialize( a_buffer.data(), a_buffer.size() );
+}
+
+/*****************************************************************************
+ * Десериализация сетевого пакета из принятых байтов буфера
+ *
+ * @param
+ *  [in] a_data - буфер приема
+ *  [in] a_size - количество принятых байтов
+ *
+ * @return
+ *  - десериализованный пакет (Header::Unknown, если принято меньше заголовка)
+ */
+T_NetPacket deserialize( const char *a_data, size_t a_size )
+{
+    T_NetPacketView view = deserializeView( a_data, a_size );
 
     T_NetPacket packet;
-    packet.Head = (Header)( uint16_t(hi) << 8 | lo  );
-    packet.Data.assign( &a_buffer[2], &a_buffer[2] + a_buffer.size() - 2 );
+    packet.Head = view.Head;
+    packet.Data.assign( view.Data, view.Data + view.Size );
 
     return packet;
 }
 
+/*****************************************************************************
+ * Разбор сетевого пакета в буфере приема без копирования данных
+ *
+ * @param
+ *  [in] a_data - буфер приема
+ *  [in] a_size - количество принятых байтов
+ *
+ * @return
+ *  - представление пакета, указывающее в a_data (Header::Unknown и пустые
+ *    данные, если принято меньше заголовка)
+ */
+T_NetPacketView deserializeView( const char *a_data, size_t a_size )
+{
+    T_NetPacketView view;
+    if ( a_size < sizeof(uint16_t) ) {
+        return view;
+    }
+    unsigned char hi = a_data[0];
+    unsigned char lo = a_data[1];
+
+    view.Head = (Header)( uint16_t(hi) << 8 | lo  );
+    view.Data = a_data + 2;
+    view.Size = a_size - 2;
+
+    return view;
+}
+
+/*****************************************************************************
+ * Открытие файла на уровне дескрипторов ОС
+ *
+ * Дескриптор используется для передачи файла между сокетом и диском без
+ * буферизации потоков (см. I_Socket::sendFile(), I_Socket::recvFile()).
+ * Файл для записи открывается без флага O_APPEND, который не допускается
+ * вызовом splice(), и позиционируется на конец
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу
+ *  [in] a_mode     - режим: чтение или дозапись в конец файла
+ *
+ * @return
+ *  >= 0 - дескриптор открытого файла
+ *  < 0  - ошибка открытия файла
+ */
+int openFileDescriptor( const std::string &a_filePath, E_FileMode a_mode )
+{
+#ifdef _WIN32
+    int flags = ( a_mode == E_FileMode::Reading ) ? _O_RDONLY : _O_WRONLY | _O_CREAT;
+    int fd = _open( a_filePath.c_str(), flags | _O_BINARY, _S_IREAD | _S_IWRITE );
+    if ( fd >= 0 && a_mode == E_FileMode::Writing ) {
+        _lseeki64( fd, 0, SEEK_END );
+    }
+    return fd;
+#else
+    int flags = ( a_mode == E_FileMode::Reading ) ? O_RDONLY : O_WRONLY | O_CREAT;
+    int fd = ::open( a_filePath.c_str(), flags | O_CLOEXEC, 0644 );
+    if ( fd >= 0 && a_mode == E_FileMode::Writing ) {
+        ::lseek( fd, 0, SEEK_END );
+    }
+    return fd;
+#endif
+}
+
+/*****************************************************************************
+ * Закрытие дескриптора файла
+ *
+ * @param
+ *  [in,out] a_fd - дескриптор файла, после закрытия принимает значение -1
+ */
+void closeFileDescriptor( int &a_fd )
+{
+    if ( a_fd < 0 ) {
+        return;
+    }
+#ifdef _WIN32
+    _close( a_fd );
+#else
+    ::close( a_fd );
+#endif
+    a_fd = -1;
+}
+
+/*****************************************************************************
+ * Изменение размера файла
+ *
+ * @param
+ *  [in] a_filePath - путь к файлу
+ *  [in] a_size     - новый размер файла в байтах
+ *
+ * @return
+ *  true  - размер файла изменен
+ *  false - ошибка открытия или изменения размера файла
+ */
+bool truncateFile( const std::string &a_filePath, uint64_t a_size )
+{
+#ifdef _WIN32
+    int fd = _open( a_filePath.c_str(), _O_RDWR | _O_BINARY );
+    if ( fd < 0 ) {
+        return false;
+    }
+    bool result = _chsize_s( fd, static_cast<__int64>( a_size ) ) == 0;
+    _close( fd );
+    return result;
+#else
+    return ::truncate( a_filePath.c_str(), static_cast<off_t>( a_size ) ) == 0;
+#endif
+}
+
 } // namespace network
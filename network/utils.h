@@ -17,6 +17,7 @@
 
 #include "I_Socket.h"
 #include "C_Logger.h"
+#include "record_views.h"
 
 namespace network {
 
@@ -62,22 +63,22 @@ constexpr std::chrono::milliseconds to_ms( long long a_msecs )
 /*****************************************************************************
  * Вывод заголовка на экран
  */
-void print( const network::T_PacketFileHeader *a_header );
+void print( T_FileHeaderView a_header );
 
 /*****************************************************************************
  * Вывод пакета на экран
  */
-void print( const network::T_Packet *a_packet );
+void print( T_PacketView a_packet );
 
 /*****************************************************************************
  * Вывод данных пакета на экран
  */
-void printData( const network::T_Packet *a_packet );
+void printData( T_PacketView a_packet );
 
 /*****************************************************************************
  * Расчет размера пакета
  */
-unsigned int getPacketSize( T_Packet* a_packet );
+unsigned int getPacketSize( T_PacketView a_packet );
 
 /*****************************************************************************
  * Расчет размера заголовка
@@ -85,47 +86,43 @@ unsigned int getPacketSize( T_Packet* a_packet );
 unsigned int getHeaderSize();
 
 /*****************************************************************************
- * Приведение указателя T* к T_Packet*
- *
- * @param
- *  [in] a_rawPtr - некоторый указатель на область памяти в которой лежит T_Packet
- *
- * @return
- *  - указатель на T_Packet
+ * Сериализация сетевого пакета в байтовый поток
  */
-template <typename T>
-T_Packet* toPacketPtr( const T* a_rawPtr )
-{
-   T* noConstPtr = const_cast<T*>( a_rawPtr );
-   T_Packet* packetPtr = reinterpret_cast<T_Packet*>(noConstPtr);
-   return packetPtr;
-}
+std::vector<char> serialize( const T_NetPacket &a_packet );
 
 /*****************************************************************************
- * Приведение указателя T* к T_PacketFileHeader*
- *
- * @param
- *  [in] a_rawPtr - некоторый указатель на область памяти в которой лежит T_PacketFileHeader
- *
- * @return
- *  - указатель на T_PacketFileHeader
+ * Формирование кадра со ссылкой на данные без копирования
  */
-template <typename T>
-T_PacketFileHeader* toPacketHeaderPtr( const T* a_rawPtr )
-{
-   T* noConstPtr = const_cast<T*>( a_rawPtr );
-   T_PacketFileHeader* packetPtr = reinterpret_cast<T_PacketFileHeader*>(noConstPtr);
-   return packetPtr;
-}
+T_Frame makeFrame( Header a_head, const char *a_data, size_t a_size );
 
 /*****************************************************************************
- * Сериализация сетевого пакета в байтовый поток
+ * Десериализация сетевого пакета из байтового потока
  */
-std::vector<char> serialize( const T_NetPacket &a_packet );
+T_NetPacket deserialize( const std::vector<char> &a_buffer );
 
 /*****************************************************************************
- * Десериализация сетевого пакета из байтового потока
+ * Десериализация сетевого пакета из принятых байтов буфера
  */
-T_NetPacket deserialize( const std::vector<char> &a_buffer );
+T_NetPacket deserialize( const char *a_data, size_t a_size );
+
+/*****************************************************************************
+ * Разбор сетевого пакета в буфере приема без копирования данных
+ */
+T_NetPacketView deserializeView( const char *a_data, size_t a_size );
+
+/*****************************************************************************
+ * Открытие файла на уровне дескрипторов ОС
+ */
+int openFileDescriptor( const std::string &a_filePath, E_FileMode a_mode );
+
+/*****************************************************************************
+ * Закрытие дескриптора файла
+ */
+void closeFileDescriptor( int &a_fd );
+
+/*****************************************************************************
+ * Изменение размера файла
+ */
+bool truncateFile( const std::string &a_filePath, uint64_t a_size );
 
 } // namespace network